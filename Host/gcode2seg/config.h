@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * File Name          : config.h
+  * Description        : G-code compiler machine settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GCODE2SEG_CONFIG_H
+#define GCODE2SEG_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "protocol.h"
+
+namespace gcode2seg
+{
+
+constexpr size_t AXIS_CNT = genlink::AXIS_CNT; // X, Y, Z, A are the board's axes 0..3
+
+struct AxisConfig
+{
+  double              steps_per_mm = 80;
+  double              vmax = 100; // mm/s
+  double              amax = 1000; // mm/s^2
+  double              min = -std::numeric_limits<double>::infinity(); // soft limits, mm, infinite = unset,
+  double              max = std::numeric_limits<double>::infinity(); // main() sets the board's position range
+};
+
+struct Config
+{
+  AxisConfig          axis[AXIS_CNT];
+  uint8_t             axes_mask = 0x0F; // the board's axes in use
+  double              junction_dev = 0.01; // mm, corner speed limit
+  double              arc_tol = 0.002; // mm, arc chords deviation
+  size_t              lookahead = 32; // planner blocks
+  double              slice = 0.005; // s, steps are generated in the time order by these slices
+  double              wait = 0.01; // s, max time without the axis stream data
+  double              window = 0.02; // s, max time the data waits for a full chunk
+  size_t              chunk = 64; // stream frame data, bytes
+  size_t              prebuffer = 1024; // stream bytes sent before the start
+};
+
+} // namespace gcode2seg
+
+#endif /* GCODE2SEG_CONFIG_H */
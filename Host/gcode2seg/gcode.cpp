@@ -0,0 +1,282 @@
+/**
+  ******************************************************************************
+  * File Name          : gcode.cpp
+  * Description        : G-code reader, the program is read line by line
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "gcode.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace gcode2seg
+{
+
+static const char AXIS_LETTERS[AXIS_CNT] = {'X', 'Y', 'Z', 'A'};
+
+void GcodeReader::error(const std::string& msg)
+{
+  ++errors;
+  std::fprintf(stderr, "line %llu: %s\n", (unsigned long long)lines, msg.c_str());
+}
+
+bool GcodeReader::limits_ok(const double* p)
+{
+  for ( size_t i = 0; i < AXIS_CNT; ++i )
+  {
+    if ( p[i] < cfg.axis[i].min || p[i] > cfg.axis[i].max )
+    {
+      error(std::string("the move is out of the ") + AXIS_LETTERS[i] + " soft limits, skipped");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * the next program move
+ */
+bool GcodeReader::next(Move& m)
+{
+  std::string s;
+
+  if ( arc_on && arc_next(m) ) return true;
+
+  while ( !ended && std::getline(in, s) )
+  {
+    ++lines;
+    if ( line(s, m) ) return true;
+    if ( arc_on && arc_next(m) ) return true;
+  }
+
+  m.type = Move::END;
+  return false;
+}
+
+/*
+ * the next arc chord, the other axes move linearly
+ */
+bool GcodeReader::arc_next(Move& m)
+{
+  double a, f;
+
+  if ( arc.i >= arc.n )
+  {
+    arc_on = false;
+    return false;
+  }
+
+  ++arc.i;
+  f = static_cast<double>(arc.i) / arc.n;
+
+  m = Move();
+  m.type = Move::LINE;
+  m.feed = feed;
+
+  for ( size_t k = 0; k < AXIS_CNT; ++k ) m.target[k] = arc.start[k] + (arc.end[k] - arc.start[k]) * f;
+
+  if ( arc.i < arc.n )
+  {
+    a = arc.a0 + arc.sweep * f;
+    m.target[0] = arc.c[0] + arc.r * std::cos(a);
+    m.target[1] = arc.c[1] + arc.r * std::sin(a);
+  }
+
+  // the arc bulge may be out of the soft limits
+  if ( !limits_ok(m.target) )
+  {
+    arc_on = false;
+    return false;
+  }
+
+  for ( size_t k = 0; k < AXIS_CNT; ++k ) pos[k] = m.target[k];
+
+  return true;
+}
+
+/*
+ * parse and execute the program line, true if it's a move
+ */
+bool GcodeReader::line(const std::string& s, Move& m)
+{
+  std::vector<double> g;
+  std::vector<int>    mc;
+  double              word[26];
+  bool                has[26] = {false};
+  double              t[AXIS_CNT];
+  bool                axes = false;
+  const char*         p = s.c_str();
+  char*               e;
+  char                c;
+  int                 depth = 0;
+
+  // words out of the comments
+  while ( (c = *p) )
+  {
+    if ( c == '(' ) ++depth;
+    else if ( c == ')' && depth ) --depth;
+    else if ( !depth && (c == ';' || c == '*' || c == '%') ) break;
+    else if ( !depth && std::isalpha(static_cast<unsigned char>(c)) )
+    {
+      c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+      double v = std::strtod(p + 1, &e);
+      if ( e == p + 1 )
+      {
+        error(std::string("no value of ") + c);
+        return false;
+      }
+
+      if ( c == 'G' ) g.push_back(v);
+      else if ( c == 'M' ) mc.push_back(static_cast<int>(v));
+      else
+      {
+        word[c - 'A'] = v;
+        has[c - 'A'] = true;
+      }
+
+      p = e;
+      continue;
+    }
+
+    ++p;
+  }
+
+  for ( double v : g )
+  {
+    int code = static_cast<int>(std::lround(v * 10));
+
+    switch ( code )
+    {
+      case 0: case 10: case 20: case 30: motion = code / 10; break;
+      case 40: break;
+      case 170: break;
+      case 200: unit = 25.4; break;
+      case 210: unit = 1; break;
+      case 900: absolute = true; break;
+      case 910: absolute = false; break;
+      case 901: arc_absolute = true; break;
+      case 911: arc_absolute = false; break;
+      case 920: break;
+      case 180: case 190: error("only the G17 arcs plane is supported"); return false;
+      default:
+        if ( warned.insert("G" + std::to_string(v)).second ) error("G" + std::to_string(v) + " is ignored");
+        break;
+    }
+  }
+
+  for ( int v : mc )
+  {
+    if ( v == 2 || v == 30 ) ended = true;
+  }
+
+  if ( has['F' - 'A'] ) feed = word['F' - 'A'] * unit / 60;
+
+  for ( size_t k = 0; k < AXIS_CNT; ++k ) axes |= has[AXIS_LETTERS[k] - 'A'];
+
+  for ( double v : g )
+  {
+    long code = std::lround(v * 10);
+
+    if ( code == 920 )
+    {
+      // the current position gets the given program coordinates
+      for ( size_t k = 0; k < AXIS_CNT; ++k )
+      {
+        if ( has[AXIS_LETTERS[k] - 'A'] ) offset[k] = pos[k] - word[AXIS_LETTERS[k] - 'A'] * unit;
+      }
+      return false;
+    }
+
+    if ( code == 40 )
+    {
+      m = Move();
+      m.type = Move::DWELL;
+      m.dwell = has['P' - 'A'] ? word['P' - 'A'] : 0;
+      for ( size_t k = 0; k < AXIS_CNT; ++k ) m.target[k] = pos[k];
+      return true;
+    }
+  }
+
+  if ( !axes ) return false;
+
+  for ( size_t k = 0; k < AXIS_CNT; ++k )
+  {
+    t[k] = pos[k];
+    if ( !has[AXIS_LETTERS[k] - 'A'] ) continue;
+
+    t[k] = absolute ? word[AXIS_LETTERS[k] - 'A'] * unit + offset[k] :
+                      pos[k] + word[AXIS_LETTERS[k] - 'A'] * unit;
+  }
+
+  if ( !limits_ok(t) ) return false;
+
+  if ( motion != 0 && feed <= 0 )
+  {
+    error("no feed rate, the move is skipped");
+    return false;
+  }
+
+  if ( motion <= 1 )
+  {
+    m = Move();
+    m.type = Move::LINE;
+    m.rapid = motion == 0;
+    m.feed = m.rapid ? std::numeric_limits<double>::infinity() : feed;
+    for ( size_t k = 0; k < AXIS_CNT; ++k )
+    {
+      m.target[k] = t[k];
+      pos[k] = t[k];
+    }
+    return true;
+  }
+
+  // G2, G3 in the XY plane
+  double ci = has['I' - 'A'] ? word['I' - 'A'] * unit : 0;
+  double cj = has['J' - 'A'] ? word['J' - 'A'] * unit : 0;
+  double r1, seg;
+
+  arc.c[0] = arc_absolute ? ci + offset[0] : pos[0] + ci;
+  arc.c[1] = arc_absolute ? cj + offset[1] : pos[1] + cj;
+  arc.r = std::hypot(pos[0] - arc.c[0], pos[1] - arc.c[1]);
+  r1 = std::hypot(t[0] - arc.c[0], t[1] - arc.c[1]);
+
+  if ( arc.r <= 0 || std::fabs(arc.r - r1) > std::max(0.005, 0.001 * arc.r) )
+  {
+    error("wrong arc center, the move is skipped");
+    return false;
+  }
+
+  arc.a0 = std::atan2(pos[1] - arc.c[1], pos[0] - arc.c[0]);
+  arc.sweep = std::atan2(t[1] - arc.c[1], t[0] - arc.c[0]) - arc.a0;
+
+  // the same start and end is the full circle
+  if ( motion == 2 && arc.sweep >= 0 ) arc.sweep -= 2 * M_PI;
+  if ( motion == 3 && arc.sweep <= 0 ) arc.sweep += 2 * M_PI;
+
+  seg = cfg.arc_tol < arc.r ? 2 * std::acos(1 - cfg.arc_tol / arc.r) : M_PI / 2;
+  arc.n = static_cast<uint32_t>(std::ceil(std::fabs(arc.sweep) / seg));
+  if ( !arc.n ) arc.n = 1;
+  arc.i = 0;
+
+  for ( size_t k = 0; k < AXIS_CNT; ++k )
+  {
+    arc.start[k] = pos[k];
+    arc.end[k] = t[k];
+  }
+
+  arc_on = true;
+
+  return false;
+}
+
+} // namespace gcode2seg
@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * File Name          : gcode.h
+  * Description        : G-code reader, the program is read line by line
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GCODE2SEG_GCODE_H
+#define GCODE2SEG_GCODE_H
+
+#include <cstdint>
+#include <istream>
+#include <set>
+#include <string>
+
+#include "config.h"
+
+namespace gcode2seg
+{
+
+// machine move in the machine coordinates
+struct Move
+{
+  enum Type { LINE, DWELL, END };
+
+  Type                type = END;
+  double              target[AXIS_CNT] = {0}; // mm
+  double              feed = 0; // mm/s
+  bool                rapid = false;
+  double              dwell = 0; // s
+};
+
+// G0 G1 G2 G3 G4 G17 G20 G21 G90 G91 G90.1 G91.1 G92 M2 M30 F, the arcs are
+// split into the chords one by one, so the memory doesn't depend on the program
+class GcodeReader
+{
+public:
+  GcodeReader(std::istream& in, const Config& cfg) : in(in), cfg(cfg) {}
+
+  // the next move, false at the program end
+  bool next(Move& m);
+
+  uint64_t            lines = 0;
+  uint64_t            errors = 0;
+
+private:
+  struct Arc
+  {
+    double            c[2]; // center, mm
+    double            r; // mm
+    double            a0; // start angle
+    double            sweep; // signed angle
+    double            start[AXIS_CNT];
+    double            end[AXIS_CNT];
+    uint32_t          n; // chords
+    uint32_t          i; // the next chord
+  };
+
+  bool line(const std::string& s, Move& m);
+  bool arc_next(Move& m);
+  void error(const std::string& msg);
+  bool limits_ok(const double* p);
+
+  std::istream&       in;
+  const Config&       cfg;
+  double              pos[AXIS_CNT] = {0}; // machine position, mm
+  double              offset[AXIS_CNT] = {0}; // G92, mm
+  int                 motion = 0; // G0..G3
+  double              feed = 0; // mm/s
+  double              unit = 1; // mm per program unit
+  bool                absolute = true;
+  bool                arc_absolute = false; // IJ
+  bool                ended = false;
+  Arc                 arc = {};
+  bool                arc_on = false;
+  std::set<std::string> warned;
+};
+
+} // namespace gcode2seg
+
+#endif /* GCODE2SEG_GCODE_H */
@@ -0,0 +1,266 @@
+/**
+  ******************************************************************************
+  * File Name          : main.cpp
+  * Description        : G-code to the board's axes streams compiler
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  * g++ -std=c++17 -O2 -I../genlink -o gcode2seg main.cpp gcode.cpp planner.cpp
+  *     stepgen.cpp ../genlink/protocol.cpp ../genlink/stream_encoder.cpp
+  *     ../genlink/client.cpp ../genlink/sim_board.cpp
+  *     ../genlink/loopback_transport.cpp ../genlink/spidev_transport.cpp
+  *
+  * gcode2seg [options] program.nc|-
+  *   -o file           link frames to the file, - is the stdout
+  *   -d /dev/spidevX.Y stream to the board
+  *   -b hz             SPI clock, 4000000
+  *   --spm x,y,z,a     steps/mm
+  *   --vmax x,y,z,a    mm/s
+  *   --amax x,y,z,a    mm/s^2
+  *   --min x,y,z,a     soft limits, mm, the unset ones are
+  *   --max x,y,z,a     the board's 32 bits position range
+  *   --jd mm           junction deviation
+  *   --tol mm          arc chords tolerance
+  *   --lookahead n     planner blocks
+  *   --axes mask       board's axes in use, 0x0F
+  *
+  * the program is read line by line and the streams are sent by chunks
+  * while it is compiled, so the memory doesn't depend on the program size
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "client.h"
+#include "gcode.h"
+#include "planner.h"
+#include "stepgen.h"
+#include "transport.h"
+
+using namespace gcode2seg;
+
+namespace
+{
+
+// link frames to the file, the same bytes the host sends to the board
+class FileSink : public Sink
+{
+public:
+  explicit FileSink(std::FILE* f) : f(f) {}
+
+  void stream(uint8_t axis, const uint8_t* data, size_t len) override
+  {
+    uint8_t payload[genlink::PAYLOAD_MAX];
+
+    while ( len )
+    {
+      size_t n = std::min(len, genlink::PAYLOAD_MAX - 1);
+
+      payload[0] = axis;
+      std::memcpy(&payload[1], data, n);
+      write(genlink::Cmd::STREAM, payload, n + 1);
+      data += n;
+      len -= n;
+    }
+  }
+
+  void start(uint8_t axes_mask) override { write(genlink::Cmd::STREAM_START, &axes_mask, 1); }
+  void finish() override { std::fflush(f); }
+
+private:
+  void write(genlink::Cmd cmd, const uint8_t* payload, size_t len)
+  {
+    buf.clear();
+    genlink::frame_encode(buf, cmd, payload, len);
+    std::fwrite(buf.data(), 1, buf.size(), f);
+  }
+
+  std::FILE*          f;
+  std::vector<uint8_t> buf;
+};
+
+// streams to the board, the host queue is about the board's FIFOs size
+class ClientSink : public Sink
+{
+public:
+  explicit ClientSink(genlink::Client& client, size_t chunk) : client(client), chunk(chunk) {}
+
+  void stream(uint8_t axis, const uint8_t* data, size_t len) override
+  {
+    client.stream(axis, data, len);
+    while ( client.queued() > 2 * genlink::AXIS_CNT * genlink::BOARD_STREAM_SIZE / chunk ) client.pump();
+  }
+
+  void start(uint8_t axes_mask) override
+  {
+    // the start follows the data which is in the board's FIFOs
+    client.pump();
+    client.stream_start(axes_mask);
+  }
+
+  void finish() override { client.flush(); }
+
+private:
+  genlink::Client&    client;
+  size_t              chunk;
+};
+
+/*
+ * per axis values list, the missing values stay
+ */
+bool axes_parse(const char* s, double AxisConfig::* field, Config& cfg, bool positive = true)
+{
+  char* end;
+
+  for ( size_t k = 0; k < AXIS_CNT && *s; ++k )
+  {
+    double v = std::strtod(s, &end);
+
+    if ( end == s || !std::isfinite(v) || (positive && v <= 0) ) return false;
+    cfg.axis[k].*field = v;
+    s = *end == ',' ? end + 1 : end;
+  }
+
+  return true;
+}
+
+int usage()
+{
+  std::fprintf(stderr, "usage: gcode2seg [-o file] [-d spidev] [-b hz] [--spm x,y,z,a] [--vmax x,y,z,a]\n"
+                       "                 [--amax x,y,z,a] [--min x,y,z,a] [--max x,y,z,a] [--jd mm]\n"
+                       "                 [--tol mm] [--lookahead n] [--axes mask] program.nc|-\n");
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Config        cfg;
+  const char*   input = nullptr;
+  const char*   output = nullptr;
+  const char*   dev = nullptr;
+  uint32_t      hz = 4000000;
+
+  for ( int i = 1; i < argc; ++i )
+  {
+    std::string a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+    bool        ok = true;
+
+    if ( a == "-" || a[0] != '-' )
+    {
+      input = argv[i];
+      continue;
+    }
+    if ( !v ) return usage();
+
+    if ( a == "-o" ) output = v;
+    else if ( a == "-d" ) dev = v;
+    else if ( a == "-b" ) hz = std::strtoul(v, nullptr, 0);
+    else if ( a == "--spm" ) ok = axes_parse(v, &AxisConfig::steps_per_mm, cfg);
+    else if ( a == "--vmax" ) ok = axes_parse(v, &AxisConfig::vmax, cfg);
+    else if ( a == "--amax" ) ok = axes_parse(v, &AxisConfig::amax, cfg);
+    else if ( a == "--min" ) ok = axes_parse(v, &AxisConfig::min, cfg, false);
+    else if ( a == "--max" ) ok = axes_parse(v, &AxisConfig::max, cfg, false);
+    else if ( a == "--jd" ) cfg.junction_dev = std::strtod(v, nullptr);
+    else if ( a == "--tol" ) cfg.arc_tol = std::strtod(v, nullptr);
+    else if ( a == "--lookahead" ) cfg.lookahead = std::strtoul(v, nullptr, 0);
+    else if ( a == "--axes" ) cfg.axes_mask = std::strtoul(v, nullptr, 0) & 0x0F;
+    else return usage();
+
+    if ( !ok || cfg.arc_tol <= 0 || cfg.junction_dev < 0 || !cfg.lookahead || !cfg.axes_mask ) return usage();
+    ++i;
+  }
+
+  if ( !input || (!output == !dev) ) return usage();
+
+  // the unset soft limits are the board's 32 bits position range
+  for ( AxisConfig& ax : cfg.axis )
+  {
+    if ( !std::isfinite(ax.min) ) ax.min = INT32_MIN / ax.steps_per_mm;
+    if ( !std::isfinite(ax.max) ) ax.max = INT32_MAX / ax.steps_per_mm;
+    if ( ax.min >= ax.max ) return usage();
+  }
+
+  std::ifstream file;
+  std::istream* in = &std::cin;
+  if ( std::strcmp(input, "-") )
+  {
+    file.open(input);
+    if ( !file )
+    {
+      std::fprintf(stderr, "gcode2seg: can't open %s\n", input);
+      return 1;
+    }
+    in = &file;
+  }
+
+  std::unique_ptr<Sink>                     sink;
+  std::unique_ptr<genlink::SpidevTransport> spi;
+  std::unique_ptr<genlink::Client>          client;
+  std::FILE*                                out = nullptr;
+
+  try
+  {
+    if ( dev )
+    {
+      spi.reset(new genlink::SpidevTransport(dev, hz));
+      client.reset(new genlink::Client(*spi, 4096, cfg.chunk));
+      sink.reset(new ClientSink(*client, cfg.chunk));
+    }
+    else
+    {
+      out = std::strcmp(output, "-") ? std::fopen(output, "wb") : stdout;
+      if ( !out )
+      {
+        std::fprintf(stderr, "gcode2seg: can't create %s\n", output);
+        return 1;
+      }
+      sink.reset(new FileSink(out));
+    }
+
+    GcodeReader reader(*in, cfg);
+    StepGen     gen(cfg, *sink);
+    Planner     planner(cfg, gen);
+    Move        m;
+
+    while ( reader.next(m) )
+    {
+      if ( m.type == Move::LINE ) planner.line(m);
+      else if ( m.type == Move::DWELL ) planner.dwell(m.dwell);
+      else break;
+    }
+
+    planner.finish();
+    gen.finish();
+
+    std::fprintf(stderr, "lines %llu, errors %llu, blocks %llu, time %.3f s\n",
+                 (unsigned long long)reader.lines, (unsigned long long)reader.errors,
+                 (unsigned long long)planner.blocks, gen.time);
+    std::fprintf(stderr, "steps %llu %llu %llu %llu, stream bytes %llu\n",
+                 (unsigned long long)gen.steps[0], (unsigned long long)gen.steps[1],
+                 (unsigned long long)gen.steps[2], (unsigned long long)gen.steps[3],
+                 (unsigned long long)gen.bytes);
+
+    if ( out && out != stdout ) std::fclose(out);
+
+    return reader.errors ? 1 : 0;
+  }
+  catch ( const std::exception& e )
+  {
+    std::fprintf(stderr, "gcode2seg: %s\n", e.what());
+    return 1;
+  }
+}
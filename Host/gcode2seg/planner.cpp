@@ -0,0 +1,155 @@
+/**
+  ******************************************************************************
+  * File Name          : planner.cpp
+  * Description        : look-ahead speed planner of the moves
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "planner.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gcode2seg
+{
+
+Planner::Planner(const Config& cfg, StepGen& gen) : cfg(cfg), gen(gen) {}
+
+/*
+ * add the line move, the steps are rounded from the machine position
+ */
+void Planner::line(const Move& m)
+{
+  Block   b;
+  double  d[AXIS_CNT];
+  double  u[AXIS_CNT];
+  double  len = 0, cos_t, sin_h;
+  bool    moves = false;
+
+  for ( size_t k = 0; k < AXIS_CNT; ++k )
+  {
+    int64_t target = std::llround(m.target[k] * cfg.axis[k].steps_per_mm);
+
+    b.steps[k] = target - pos[k];
+    d[k] = b.steps[k] / cfg.axis[k].steps_per_mm;
+    len += d[k] * d[k];
+    if ( b.steps[k] ) moves = true;
+  }
+
+  if ( !moves ) return;
+
+  b.len = std::sqrt(len);
+  b.v_nom = m.rapid ? INFINITY : m.feed;
+  b.acc = INFINITY;
+
+  // the axes limits along the move direction
+  for ( size_t k = 0; k < AXIS_CNT; ++k )
+  {
+    u[k] = d[k] / b.len;
+    if ( !u[k] ) continue;
+
+    b.v_nom = std::min(b.v_nom, cfg.axis[k].vmax / std::fabs(u[k]));
+    b.acc = std::min(b.acc, cfg.axis[k].amax / std::fabs(u[k]));
+  }
+
+  // the corner speed of the junction deviation, v^2 = a * jd * sin(t/2) / (1 - sin(t/2))
+  b.v_max_entry = 0;
+  if ( prev )
+  {
+    cos_t = 0;
+    for ( size_t k = 0; k < AXIS_CNT; ++k ) cos_t -= unit[k] * u[k];
+
+    if ( cos_t < -0.999999 ) b.v_max_entry = b.v_nom; // straight
+    else if ( cos_t < 0.999999 )
+    {
+      sin_h = std::sqrt((1 - cos_t) / 2);
+      b.v_max_entry = std::sqrt(b.acc * cfg.junction_dev * sin_h / (1 - sin_h));
+    }
+
+    if ( !queue.empty() ) b.v_max_entry = std::min(b.v_max_entry, queue.back().v_nom);
+    b.v_max_entry = std::min(b.v_max_entry, b.v_nom);
+  }
+
+  for ( size_t k = 0; k < AXIS_CNT; ++k )
+  {
+    pos[k] += b.steps[k];
+    unit[k] = u[k];
+  }
+  prev = true;
+
+  queue.push_back(b);
+  ++blocks;
+
+  if ( queue.size() > cfg.lookahead )
+  {
+    plan();
+    execute(queue.size() - cfg.lookahead);
+  }
+}
+
+/*
+ * entry speeds of the blocks, the last one stops
+ */
+void Planner::plan()
+{
+  size_t n = queue.size();
+  double v;
+
+  if ( !n ) return;
+
+  // backward: every block can stop at the window end
+  v = 0;
+  for ( size_t i = n; i-- > 0; )
+  {
+    Block& b = queue[i];
+
+    b.v_entry = std::min(b.v_max_entry, std::sqrt(v * v + 2 * b.acc * b.len));
+    v = b.v_entry;
+  }
+
+  // forward: the acceleration limit from the previous block entry,
+  // the first block entry is the executed block exit
+  for ( size_t i = 1; i < n; ++i )
+  {
+    Block& a = queue[i - 1];
+
+    v = std::sqrt(a.v_entry * a.v_entry + 2 * a.acc * a.len);
+    queue[i].v_entry = std::min(queue[i].v_entry, v);
+  }
+}
+
+/*
+ * steps of the front blocks
+ */
+void Planner::execute(size_t n)
+{
+  while ( n-- && !queue.empty() )
+  {
+    double v_exit = queue.size() > 1 ? queue[1].v_entry : 0;
+
+    gen.block(queue.front(), v_exit);
+    queue.pop_front();
+
+    // the executed exit is the fixed entry of the next block
+    if ( !queue.empty() ) queue.front().v_max_entry = v_exit;
+  }
+}
+
+void Planner::dwell(double s)
+{
+  finish();
+  gen.dwell(s);
+}
+
+void Planner::finish()
+{
+  plan();
+  execute(queue.size());
+  prev = false;
+}
+
+} // namespace gcode2seg
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * File Name          : planner.h
+  * Description        : look-ahead speed planner of the moves
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GCODE2SEG_PLANNER_H
+#define GCODE2SEG_PLANNER_H
+
+#include <deque>
+
+#include "config.h"
+#include "gcode.h"
+#include "stepgen.h"
+
+namespace gcode2seg
+{
+
+// the blocks wait in the fixed look-ahead window, the corner speeds come from
+// the junction deviation, the backward and forward passes keep every block
+// able to stop at the window end
+class Planner
+{
+public:
+  Planner(const Config& cfg, StepGen& gen);
+
+  void line(const Move& m);
+  void dwell(double s);
+  // execute all the planned blocks, the machine stops
+  void finish();
+
+  uint64_t            blocks = 0;
+
+private:
+  void plan();
+  void execute(size_t n);
+
+  const Config&       cfg;
+  StepGen&            gen;
+  std::deque<Block>   queue;
+  int64_t             pos[AXIS_CNT] = {0}; // steps
+  double              unit[AXIS_CNT] = {0}; // the previous block direction
+  bool                prev = false;
+};
+
+} // namespace gcode2seg
+
+#endif /* GCODE2SEG_PLANNER_H */
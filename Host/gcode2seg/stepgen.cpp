@@ -0,0 +1,191 @@
+/**
+  ******************************************************************************
+  * File Name          : stepgen.cpp
+  * Description        : planned blocks to the board's axes streams
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "stepgen.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace gcode2seg
+{
+
+using genlink::TIM_FREQ;
+
+StepGen::StepGen(const Config& cfg, Sink& sink) : cfg(cfg), sink(sink)
+{
+  wait_ticks = static_cast<int64_t>(cfg.wait * TIM_FREQ);
+  window_ticks = static_cast<int64_t>(cfg.window * TIM_FREQ);
+}
+
+/*
+ * send the encoded bytes of the axis
+ */
+void StepGen::emit(size_t axis, size_t n)
+{
+  Axis& a = axes[axis];
+
+  sink.stream(static_cast<uint8_t>(axis), a.enc.bytes().data(), n);
+  a.enc.bytes().erase(a.enc.bytes().begin(), a.enc.bytes().begin() + n);
+  bytes += n;
+  a.sent += n;
+}
+
+/*
+ * the step at the program time, the long gaps are the waits
+ */
+void StepGen::step(size_t axis, int64_t tick, int8_t dir)
+{
+  Axis& a = axes[axis];
+
+  if ( a.pending < 0 ) a.pending = a.last;
+
+  while ( tick - a.last > 2 * wait_ticks )
+  {
+    a.enc.wait(static_cast<uint32_t>(wait_ticks));
+    a.last += wait_ticks;
+  }
+
+  a.enc.step(static_cast<uint32_t>(tick - a.last), dir);
+  a.last = tick;
+  ++steps[axis];
+}
+
+/*
+ * the idle axes waits and the streams data which is due to send
+ */
+void StepGen::check(int64_t now)
+{
+  size_t total = 0;
+
+  for ( size_t axis = 0; axis < AXIS_CNT; ++axis )
+  {
+    Axis& a = axes[axis];
+
+    if ( !(cfg.axes_mask & (1 << axis)) ) continue;
+
+    // the board's stream doesn't run dry while the axis is idle
+    while ( now - a.last > 2 * wait_ticks )
+    {
+      if ( a.pending < 0 ) a.pending = a.last;
+      a.enc.wait(static_cast<uint32_t>(wait_ticks));
+      a.last += wait_ticks;
+    }
+
+    while ( a.enc.bytes().size() >= cfg.chunk ) emit(axis, cfg.chunk);
+
+    if ( a.pending >= 0 && now - a.pending > window_ticks )
+    {
+      a.enc.flush();
+      if ( !a.enc.bytes().empty() ) emit(axis, a.enc.bytes().size());
+      a.pending = -1;
+    }
+
+    total += a.sent;
+  }
+
+  if ( !started && total >= cfg.prebuffer )
+  {
+    sink.start(cfg.axes_mask);
+    started = true;
+  }
+}
+
+/*
+ * steps of the block, the axis step j of n is at (j - 0.5) / n of the block
+ */
+void StepGen::block(const Block& b, double v_exit)
+{
+  const double  a = b.acc;
+  const double  ve = b.v_entry;
+  const double  vx = v_exit;
+  double        vp = b.v_nom;
+  double        da, dc, ta, tc, td, dur;
+  double        t0 = time;
+  size_t        j[AXIS_CNT] = {0};
+  size_t        n[AXIS_CNT];
+
+  da = (vp * vp - ve * ve) / (2 * a);
+  dc = b.len - da - (vp * vp - vx * vx) / (2 * a);
+
+  if ( dc < 0 )
+  {
+    // no cruise, the peak speed is lower
+    vp = std::sqrt((2 * a * b.len + ve * ve + vx * vx) / 2);
+    da = (vp * vp - ve * ve) / (2 * a);
+    dc = 0;
+  }
+  if ( da < 0 ) da = 0;
+
+  ta = (vp - ve) / a;
+  tc = vp > 0 ? dc / vp : 0;
+  td = (vp - vx) / a;
+  dur = ta + tc + (td > 0 ? td : 0);
+
+  auto t_at = [&](double s) -> double
+  {
+    double s2, q;
+
+    if ( s < da ) return (std::sqrt(ve * ve + 2 * a * s) - ve) / a;
+    if ( s < da + dc ) return ta + (s - da) / vp;
+
+    s2 = s - da - dc;
+    q = vp * vp - 2 * a * s2;
+    return ta + tc + (vp - std::sqrt(q > 0 ? q : 0)) / a;
+  };
+
+  for ( size_t k = 0; k < AXIS_CNT; ++k ) n[k] = static_cast<size_t>(std::llabs(b.steps[k]));
+
+  for ( double end = cfg.slice; ; end += cfg.slice )
+  {
+    bool last = end >= dur;
+
+    for ( size_t k = 0; k < AXIS_CNT; ++k )
+    {
+      for ( ; j[k] < n[k]; ++j[k] )
+      {
+        double t = t_at((j[k] + 0.5) / n[k] * b.len);
+        if ( !last && t > end ) break;
+
+        step(k, std::llround((t0 + t) * TIM_FREQ), b.steps[k] < 0 ? -1 : 1);
+      }
+    }
+
+    check(std::llround((t0 + (last ? dur : end)) * TIM_FREQ));
+    if ( last ) break;
+  }
+
+  time = t0 + dur;
+}
+
+void StepGen::dwell(double s)
+{
+  time += s;
+  check(std::llround(time * TIM_FREQ));
+}
+
+/*
+ * the streams ends
+ */
+void StepGen::finish()
+{
+  for ( size_t axis = 0; axis < AXIS_CNT; ++axis )
+  {
+    if ( !(cfg.axes_mask & (1 << axis)) ) continue;
+
+    axes[axis].enc.end();
+    emit(axis, axes[axis].enc.bytes().size());
+  }
+
+  if ( !started ) sink.start(cfg.axes_mask);
+  sink.finish();
+}
+
+} // namespace gcode2seg
@@ -0,0 +1,83 @@
+/**
+  ******************************************************************************
+  * File Name          : stepgen.h
+  * Description        : planned blocks to the board's axes streams
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GCODE2SEG_STEPGEN_H
+#define GCODE2SEG_STEPGEN_H
+
+#include <cstdint>
+
+#include "config.h"
+#include "stream_encoder.h"
+
+namespace gcode2seg
+{
+
+// planned block, the trapezoid speed profile
+struct Block
+{
+  int64_t             steps[AXIS_CNT] = {0}; // signed
+  double              len = 0; // mm
+  double              v_nom = 0; // mm/s
+  double              acc = 0; // mm/s^2
+  double              v_max_entry = 0; // mm/s
+  double              v_entry = 0; // mm/s
+};
+
+// the streams output
+class Sink
+{
+public:
+  virtual ~Sink() = default;
+
+  virtual void stream(uint8_t axis, const uint8_t* data, size_t len) = 0;
+  virtual void start(uint8_t axes_mask) = 0;
+  virtual void finish() = 0;
+};
+
+// the step times of all axes are generated in the time order by slices and
+// rounded from the program time, so the axes stay synchronized on the board
+class StepGen
+{
+public:
+  StepGen(const Config& cfg, Sink& sink);
+
+  void block(const Block& b, double v_exit);
+  void dwell(double s);
+  void finish();
+
+  double              time = 0; // s, program time
+  uint64_t            steps[AXIS_CNT] = {0};
+  uint64_t            bytes = 0;
+
+private:
+  struct Axis
+  {
+    genlink::StreamEncoder enc;
+    int64_t           last = 0; // ticks of the last step or wait end
+    int64_t           pending = -1; // ticks of the first data which isn't sent
+    size_t            sent = 0; // encoder bytes sent
+  };
+
+  void step(size_t axis, int64_t tick, int8_t dir);
+  void check(int64_t now);
+  void emit(size_t axis, size_t n);
+
+  const Config&       cfg;
+  Sink&               sink;
+  Axis                axes[AXIS_CNT];
+  int64_t             wait_ticks;
+  int64_t             window_ticks;
+  bool                started = false;
+};
+
+} // namespace gcode2seg
+
+#endif /* GCODE2SEG_STEPGEN_H */
@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * File Name          : bench.cpp
+  * Description        : host link end to end benchmark on the loopback transport
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  * g++ -std=c++17 -O2 -o genlink_bench bench.cpp client.cpp protocol.cpp
+  *     sim_board.cpp loopback_transport.cpp spidev_transport.cpp
+  *
+  * genlink_bench [steps per axis] [SPI Hz] [board steps/s]
+  *
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "client.h"
+#include "sim_board.h"
+#include "transport.h"
+
+using namespace genlink;
+
+int main(int argc, char** argv)
+{
+  const uint64_t  steps = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 1000000;
+  const uint32_t  hz = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 9000000;
+  const uint32_t  rate = argc > 3 ? std::strtoul(argv[3], nullptr, 0) : 50000;
+
+  SimBoard          board(rate);
+  LoopbackTransport link(board, hz);
+  Client            client(link);
+  std::vector<uint8_t> data;
+  uint64_t          queued = 0;
+  uint64_t          done;
+
+  // the varying steps rate, the 2nd differences are 1 byte codes
+  for ( int i = 0; i < 4096; ++i ) data.push_back(static_cast<uint8_t>((i / 64) % 2 ? 0x01 : 0x3F));
+
+  auto t0 = std::chrono::steady_clock::now();
+
+  for ( bool started = false; ; )
+  {
+    // keep the host queue about the board's FIFO size
+    while ( queued < steps && client.queued() < 2 * BOARD_STREAM_SIZE / 64 )
+    {
+      for ( uint8_t axis = 0; axis < AXIS_CNT; ++axis ) client.stream(axis, data.data(), 256);
+      queued += 256;
+    }
+
+    if ( queued >= steps && !client.queued() ) break;
+
+    client.pump();
+
+    // the streams start with the data in the board's FIFOs
+    if ( !started )
+    {
+      client.stream_start(0x0F);
+      started = true;
+    }
+  }
+
+  // the stream ends
+  const uint8_t end = 0xFF;
+  for ( uint8_t axis = 0; axis < AXIS_CNT; ++axis ) client.stream(axis, &end, 1);
+  client.flush();
+
+  // the board decodes the rest of its FIFOs
+  link.idle(2.0 * BOARD_STREAM_SIZE / rate);
+
+  auto t1 = std::chrono::steady_clock::now();
+  double host_s = std::chrono::duration<double>(t1 - t0).count();
+  double link_s = client.bytes * 8.0 / hz;
+
+  done = 0;
+  for ( size_t axis = 0; axis < AXIS_CNT; ++axis ) done += board.steps[axis];
+
+  std::printf("steps sent        %llu x %zu axes, decoded %llu\n",
+              (unsigned long long)queued, AXIS_CNT, (unsigned long long)done);
+  std::printf("transfers         %llu, stalls %llu, frames %llu\n",
+              (unsigned long long)client.transfers, (unsigned long long)client.stalls,
+              (unsigned long long)client.frames);
+  std::printf("link bytes        %llu, payload %.1f%%\n",
+              (unsigned long long)client.bytes, 100.0 * client.payload / client.bytes);
+  std::printf("link time         %.3f s, board steps time %.3f s\n", link_s, (double)queued / rate);
+  std::printf("host CPU          %.3f s, %.1f Msteps/s\n", host_s, done / host_s / 1e6);
+  std::printf("board underruns   %llu %llu %llu %llu, rx lost %llu, bad frames %llu\n",
+              (unsigned long long)board.underruns[0], (unsigned long long)board.underruns[1],
+              (unsigned long long)board.underruns[2], (unsigned long long)board.underruns[3],
+              (unsigned long long)board.rx_lost, (unsigned long long)board.bad_frames);
+
+  return board.rx_lost || board.bad_frames ? 1 : 0;
+}
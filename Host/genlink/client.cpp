@@ -0,0 +1,161 @@
+/**
+  ******************************************************************************
+  * File Name          : client.cpp
+  * Description        : host link client of the generator board
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "client.h"
+
+#include <stdexcept>
+
+namespace genlink
+{
+
+// the padding to get a status frame when there are no frames to send
+static constexpr size_t POLL_SIZE = 24;
+
+Client::Client(Transport& transport, size_t transfer_max, size_t chunk)
+  : transport(transport), transfer_max(transfer_max), chunk(chunk)
+{
+  if ( !chunk || chunk > PAYLOAD_MAX - 1 ) throw std::invalid_argument("genlink: wrong stream chunk size");
+  if ( transfer_max < POLL_SIZE ) throw std::invalid_argument("genlink: transfer is too short");
+}
+
+/*
+ * queue the stream data in the chunks, the small chunks fit the credits better
+ */
+void Client::stream(uint8_t axis, const uint8_t* data, size_t len)
+{
+  uint8_t payload[PAYLOAD_MAX];
+  size_t  n;
+
+  if ( axis >= AXIS_CNT ) throw std::out_of_range("genlink: wrong axis");
+
+  for ( ; len; len -= n, data += n )
+  {
+    n = len < chunk ? len : chunk;
+
+    payload[0] = axis;
+    for ( size_t i = 0; i < n; ++i ) payload[1 + i] = data[i];
+
+    queue.push_back({axis, n, {}});
+    frame_encode(queue.back().bytes, Cmd::STREAM, payload, n + 1);
+  }
+}
+
+void Client::stream_start(uint8_t axes_mask)
+{
+  queue.push_back({AXIS_ALL, 0, {}});
+  frame_encode(queue.back().bytes, Cmd::STREAM_START, &axes_mask, 1);
+}
+
+void Client::override_set(uint8_t axis, uint16_t percent)
+{
+  uint8_t payload[3] = {axis, static_cast<uint8_t>(percent & 0xFF), static_cast<uint8_t>(percent >> 8)};
+
+  queue.push_back({AXIS_ALL, 0, {}});
+  frame_encode(queue.back().bytes, Cmd::OVERRIDE, payload, sizeof(payload));
+}
+
+void Client::command(Cmd cmd, const Payload& payload)
+{
+  queue.push_back({AXIS_ALL, 0, {}});
+  frame_encode(queue.back().bytes, cmd, payload.bytes.data(), payload.bytes.size());
+}
+
+/*
+ * the board's FIFO space for the axis stream which isn't taken by the sent frames
+ */
+int64_t Client::credit(uint8_t axis) const
+{
+  int64_t free = status().stream_free[axis];
+
+  for ( const Sent& s : sent )
+  {
+    if ( s.axis == axis ) free -= static_cast<int64_t>(s.data);
+  }
+
+  return free;
+}
+
+/*
+ * forget the frames which the board has taken out of its receive FIFO
+ */
+void Client::status_update()
+{
+  // the board's counter wraps at 16 bits, it's behind the sent bytes
+  parsed += static_cast<uint16_t>(status().parsed - static_cast<uint16_t>(parsed));
+  status_ok = true;
+
+  while ( !sent.empty() && sent.front().end <= parsed ) sent.pop_front();
+}
+
+/*
+ * batch the queued frames to one transfer
+ *
+ * the frames keep their order, the first frame which doesn't fit the credits
+ * or the board's receive FIFO stops the batch
+ */
+size_t Client::pump()
+{
+  uint64_t  in_fifo;
+  int64_t   credits[AXIS_CNT];
+  size_t    cnt = 0;
+
+  tx.clear();
+
+  if ( status_ok )
+  {
+    for ( uint8_t axis = 0; axis < AXIS_CNT; ++axis ) credits[axis] = credit(axis);
+
+    while ( !queue.empty() )
+    {
+      const Frame& f = queue.front();
+
+      in_fifo = sent_bytes + tx.size() - parsed;
+      if ( tx.size() + f.bytes.size() > transfer_max ) break;
+      if ( in_fifo + f.bytes.size() >= BOARD_RX_SIZE ) break;
+      if ( f.axis != AXIS_ALL && credits[f.axis] < static_cast<int64_t>(f.data) ) break;
+
+      tx.insert(tx.end(), f.bytes.begin(), f.bytes.end());
+      if ( f.axis != AXIS_ALL ) credits[f.axis] -= f.data;
+
+      sent.push_back({sent_bytes + tx.size(), f.axis, f.data});
+      payload += f.data;
+      queue.pop_front();
+      ++cnt;
+    }
+  }
+
+  if ( !cnt ) ++stalls;
+
+  // the board skips the bytes out of the frames, they bring the status back
+  if ( tx.size() < POLL_SIZE ) tx.resize(POLL_SIZE, 0);
+
+  rx.resize(tx.size());
+  transport.transfer(tx.data(), rx.data(), tx.size());
+
+  sent_bytes += tx.size();
+  bytes += tx.size();
+  frames += cnt;
+  ++transfers;
+
+  for ( uint8_t b : rx )
+  {
+    if ( parser.feed(b) ) status_update();
+  }
+
+  return queue.size();
+}
+
+void Client::flush()
+{
+  while ( pump() ) {}
+}
+
+} // namespace genlink
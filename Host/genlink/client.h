@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * File Name          : client.h
+  * Description        : host link client of the generator board
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GENLINK_CLIENT_H
+#define GENLINK_CLIENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "protocol.h"
+#include "transport.h"
+
+namespace genlink
+{
+
+// the client keeps the board's stream FIFOs full: the board's status frames
+// give the free space (credits), the queued frames are batched to the transfers
+// and sent only when the board takes them without a wait
+class Client
+{
+public:
+  explicit Client(Transport& transport, size_t transfer_max = 4096, size_t chunk = 64);
+
+  // queue the encoded stream data of the axis
+  void stream(uint8_t axis, const uint8_t* data, size_t len);
+  // queue the streams start, axes_mask bit 0 is the axis 0
+  void stream_start(uint8_t axes_mask);
+  // queue the feed override, axis or AXIS_ALL
+  void override_set(uint8_t axis, uint16_t percent);
+  // queue the other command, the status counts it with its result
+  void command(Cmd cmd, const Payload& payload);
+
+  // one transfer of the queued frames which fit the credits,
+  // returns the queued frames count after it
+  size_t pump();
+  // pump until the queue is empty
+  void flush();
+
+  size_t queued() const { return queue.size(); }
+  const Status& status() const { return parser.status(); }
+
+  // statistics
+  uint64_t            transfers = 0;
+  uint64_t            bytes = 0; // all transferred bytes
+  uint64_t            payload = 0; // stream data bytes
+  uint64_t            frames = 0;
+  uint64_t            stalls = 0; // transfers without frames, no credits
+
+private:
+  struct Frame
+  {
+    uint8_t           axis; // AXIS_ALL for the commands
+    size_t            data; // stream data bytes
+    std::vector<uint8_t> bytes;
+  };
+
+  struct Sent
+  {
+    uint64_t          end; // sent bytes offset of the frame end
+    uint8_t           axis;
+    size_t            data;
+  };
+
+  void status_update();
+  int64_t credit(uint8_t axis) const;
+
+  Transport&          transport;
+  size_t              transfer_max;
+  size_t              chunk;
+  std::deque<Frame>   queue;
+  std::deque<Sent>    sent; // frames which the board didn't take out of its FIFO yet
+  uint64_t            sent_bytes = 0;
+  uint64_t            parsed = 0; // board's parsed bytes, unwrapped
+  bool                status_ok = false;
+  StatusParser        parser;
+  std::vector<uint8_t> tx;
+  std::vector<uint8_t> rx;
+};
+
+} // namespace genlink
+
+#endif /* GENLINK_CLIENT_H */
@@ -0,0 +1,31 @@
+/**
+  ******************************************************************************
+  * File Name          : loopback_transport.cpp
+  * Description        : in-process host link transport to the simulated board
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "transport.h"
+
+namespace genlink
+{
+
+/*
+ * the board gets and sends a byte at every SPI byte time
+ */
+void LoopbackTransport::transfer(const uint8_t* tx, uint8_t* rx, size_t len)
+{
+  const double byte_s = 8.0 / hz;
+
+  for ( size_t i = 0; i < len; ++i )
+  {
+    rx[i] = board.exchange(tx[i]);
+    board.advance(byte_s);
+  }
+}
+
+} // namespace genlink
@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * File Name          : protocol.cpp
+  * Description        : host link frames of the generator board
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "protocol.h"
+
+#include <stdexcept>
+
+namespace genlink
+{
+
+/*
+ * append the frame to the output bytes
+ */
+void frame_encode(std::vector<uint8_t>& out, Cmd cmd, const uint8_t* payload, size_t len)
+{
+  uint8_t sum;
+
+  if ( len > PAYLOAD_MAX ) throw std::length_error("genlink: payload is too long");
+
+  sum = static_cast<uint8_t>(cmd) ^ static_cast<uint8_t>(len);
+
+  out.push_back(SYNC);
+  out.push_back(static_cast<uint8_t>(cmd));
+  out.push_back(static_cast<uint8_t>(len));
+  for ( size_t i = 0; i < len; ++i )
+  {
+    out.push_back(payload[i]);
+    sum ^= payload[i];
+  }
+  out.push_back(sum);
+}
+
+/*
+ * status frame of the board
+ */
+std::vector<uint8_t> status_encode(const Status& st)
+{
+  std::vector<uint8_t>  out;
+  uint8_t               sum = 0;
+
+  out.push_back(SYNC);
+  out.push_back(st.parsed & 0xFF);
+  out.push_back(st.parsed >> 8);
+  for ( size_t i = 0; i < AXIS_CNT; ++i )
+  {
+    out.push_back(st.stream_free[i] & 0xFF);
+    out.push_back(st.stream_free[i] >> 8);
+  }
+  out.push_back(st.cmds);
+  out.push_back(st.result);
+  for ( size_t i = 1; i < out.size(); ++i ) sum ^= out[i];
+  out.push_back(sum);
+
+  return out;
+}
+
+/*
+ * parse the board's output byte
+ *
+ * the board sends the status frames back to back, a wrong xor
+ * drops the frame and the parser looks for the next sync byte
+ */
+bool StatusParser::feed(uint8_t byte)
+{
+  uint8_t sum = 0;
+
+  if ( !in_frame )
+  {
+    in_frame = byte == SYNC;
+    pos = 0;
+    return false;
+  }
+
+  if ( pos < SIZE )
+  {
+    buf[pos++] = byte;
+    return false;
+  }
+
+  in_frame = false;
+
+  for ( size_t i = 0; i < SIZE; ++i ) sum ^= buf[i];
+  if ( sum != byte ) return false;
+
+  last.parsed = buf[0] | (buf[1] << 8);
+  for ( size_t i = 0; i < AXIS_CNT; ++i ) last.stream_free[i] = buf[2 + 2*i] | (buf[3 + 2*i] << 8);
+  last.cmds = buf[2 + 2*AXIS_CNT];
+  last.result = buf[3 + 2*AXIS_CNT];
+
+  return true;
+}
+
+} // namespace genlink
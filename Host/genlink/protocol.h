@@ -0,0 +1,131 @@
+/**
+  ******************************************************************************
+  * File Name          : protocol.h
+  * Description        : host link frames of the generator board
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GENLINK_PROTOCOL_H
+#define GENLINK_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace genlink
+{
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+// the same values as in the firmware's link.h, stream.h and generator.h
+constexpr uint8_t   SYNC = 0xA5;
+constexpr size_t    AXIS_CNT = 4;
+constexpr size_t    PAYLOAD_MAX = 255;
+constexpr size_t    BOARD_RX_SIZE = 1024; // board's SPI receive FIFO
+constexpr size_t    BOARD_STREAM_SIZE = 512; // board's stream FIFO of the axis
+constexpr uint8_t   AXIS_ALL = 0xFF; // GEN_AXIS_NONE, the global override
+constexpr uint32_t  TIM_FREQ = 72000000; // Hz, the stream intervals ticks
+
+// board's stream codes, stream.h
+constexpr uint8_t   OP_DD = 0x00; // 00dddddd, step, 6 bit signed 2nd difference
+constexpr uint8_t   OP_RUN = 0x40; // 01nnnnnn, n+1 steps with zero 2nd difference
+constexpr uint8_t   OP_DD_LONG = 0x80; // 10dddddd dddddddd, step, 14 bit signed 2nd difference
+constexpr uint8_t   OP_DIR_FWD = 0xC0;
+constexpr uint8_t   OP_DIR_BACK = 0xC1;
+constexpr uint8_t   OP_SET = 0xC2; // + LE32 interval, step, 1st difference = 0
+constexpr uint8_t   OP_WAIT = 0xC3; // + LE32 ticks without a step
+constexpr uint8_t   OP_END = 0xFF;
+
+constexpr uint8_t   ERR_CMD = 0xFF; // command result of an unknown command or a short payload, LINK_ERR_CMD
+
+// board's LINK_CMD_t, the payload integers are LE
+enum class Cmd : uint8_t
+{
+  STREAM = 1, // axis, encoded stream data
+  STREAM_START, // axes mask
+  STOP, // axis or AXIS_ALL
+  MOVE, // axis, dir, steps LE32, freq LE32
+  PULSE_WIDTH, // axis, ns LE32
+  GEAR, // slave, master or AXIS_ALL for off, num LE16, den LE16
+  HOME_CONFIG, // axis, dir, fast_freq LE32, slow_freq LE32, backoff LE16, travel_max LE32, home_pos LE32
+  HOME_START, // axis
+  LIMITS, // axis, pos_min LE32, pos_max LE32, pos_on, freq_max LE32, freq_start LE32, accel LE32
+  BACKLASH, // axis, steps LE16, freq LE32
+  ARC, // ax, ay, az, xe, ye, ze, i, j LE32, cw, feed LE32
+  PVT_ADD, // axis, pos LE32, vel LE32, us LE32
+  PVT_START, // axes mask
+  OVERRIDE, // axis or AXIS_ALL, feed override % LE16
+  RAMP, // axis, dir, steps LE32, table, freq LE32
+  RAMP_ACCEL, // axis, dir, steps LE32, accel LE32, freq_start LE32, freq LE32
+  TLM_RATE, // Hz LE16
+  PVT_END, // axes mask
+  SLOW, // axis, dir, steps LE32, num LE32, den LE32
+  VERIFY, // axis, checker or AXIS_ALL for off
+  MODE, // axis, mode
+  FOLLOW, // axis, input axis, num LE32, den LE32, avg
+  FOLLOW_STOP // axis
+};
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// board's LINK_STATUS_t
+struct Status
+{
+  uint16_t            parsed = 0; // board's received bytes taken out of its FIFO, wraps
+  uint16_t            stream_free[AXIS_CNT] = {0}; // bytes
+  uint8_t             cmds = 0; // board's executed commands, wraps
+  uint8_t             result = 0; // board's GEN_ERR_t of the last executed command or ERR_CMD
+};
+
+// command payload of the LE fields
+class Payload
+{
+public:
+  Payload& u8(uint8_t v) { bytes.push_back(v); return *this; }
+  Payload& u16(uint16_t v) { return u8(v & 0xFF).u8(v >> 8); }
+  Payload& u32(uint32_t v) { return u16(v & 0xFFFF).u16(v >> 16); }
+
+  std::vector<uint8_t> bytes;
+};
+
+// status frames parser of the board's output bytes
+class StatusParser
+{
+public:
+  // returns true when a new status frame is complete
+  bool feed(uint8_t byte);
+  const Status& status() const { return last; }
+
+private:
+  static constexpr size_t SIZE = 2 + 2*AXIS_CNT + 2;
+
+  uint8_t             buf[SIZE] = {0};
+  size_t              pos = 0;
+  bool                in_frame = false;
+  Status              last;
+};
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+// append the frame to the output bytes, the payload is PAYLOAD_MAX bytes max
+void frame_encode(std::vector<uint8_t>& out, Cmd cmd, const uint8_t* payload, size_t len);
+
+// status frame of the board, SYNC, status, xor
+std::vector<uint8_t> status_encode(const Status& st);
+
+} // namespace genlink
+
+#endif /* GENLINK_PROTOCOL_H */
@@ -0,0 +1,231 @@
+/**
+  ******************************************************************************
+  * File Name          : sim_board.cpp
+  * Description        : simulated generator board of the host link
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "sim_board.h"
+
+namespace genlink
+{
+
+/*
+ * SPI byte exchange, like LINK_SPI_IRQHandler()
+ */
+uint8_t SimBoard::exchange(uint8_t in)
+{
+  Status st;
+
+  if ( tx_pos >= tx.size() )
+  {
+    // the status frame is a snapshot at its start
+    st.parsed = parsed;
+    for ( size_t i = 0; i < AXIS_CNT; ++i ) st.stream_free[i] = stream_free(i);
+    st.cmds = cmds;
+    st.result = result;
+    tx = status_encode(st);
+    tx_pos = 0;
+  }
+
+  if ( (rx_tail + 1) % BOARD_RX_SIZE != rx_head )
+  {
+    rx[rx_tail] = in;
+    rx_tail = (rx_tail + 1) % BOARD_RX_SIZE;
+  }
+  else ++rx_lost;
+
+  return tx[tx_pos++];
+}
+
+/*
+ * free space of the axis stream FIFO, bytes
+ */
+uint16_t SimBoard::stream_free(size_t axis) const
+{
+  const Stream& st = streams[axis];
+
+  return static_cast<uint16_t>((st.head - st.tail - 1) % BOARD_STREAM_SIZE);
+}
+
+/*
+ * the board's main loop runs much faster than the SPI bytes come,
+ * so it runs at every advance
+ */
+void SimBoard::advance(double s)
+{
+  process();
+
+  for ( size_t axis = 0; axis < AXIS_CNT; ++axis )
+  {
+    if ( !streams[axis].on ) continue;
+
+    streams[axis].due += s * steps_rate * override[AXIS_CNT] / 100.0 * override[axis] / 100.0;
+    decode(streams[axis], axis);
+  }
+}
+
+/*
+ * take the bytes out of the receive FIFO
+ */
+void SimBoard::skip(size_t n)
+{
+  rx_head = (rx_head + n) % BOARD_RX_SIZE;
+  parsed = static_cast<uint16_t>(parsed + n);
+}
+
+/*
+ * parse the received frames, like LINK_process()
+ */
+void SimBoard::process()
+{
+  uint8_t data[PAYLOAD_MAX];
+  size_t  avail, len;
+  uint8_t sum;
+
+  for ( ;; )
+  {
+    avail = rx_avail();
+
+    while ( avail && rx[rx_head] != SYNC )
+    {
+      skip(1);
+      --avail;
+    }
+
+    if ( avail < 3 ) return;
+
+    len = rx[(rx_head + 2) % BOARD_RX_SIZE];
+    if ( avail < len + 4 ) return;
+
+    sum = rx[(rx_head + 1) % BOARD_RX_SIZE] ^ static_cast<uint8_t>(len);
+    for ( size_t i = 0; i < len; ++i )
+    {
+      data[i] = rx[(rx_head + 3 + i) % BOARD_RX_SIZE];
+      sum ^= data[i];
+    }
+
+    if ( sum != rx[(rx_head + 3 + len) % BOARD_RX_SIZE] )
+    {
+      ++bad_frames;
+      skip(1);
+      continue;
+    }
+
+    if ( !command(rx[(rx_head + 1) % BOARD_RX_SIZE], data, len) ) return;
+
+    ++frames;
+    skip(len + 4);
+  }
+}
+
+/*
+ * execute the command, false if it must be repeated later
+ */
+bool SimBoard::command(uint8_t cmd, const uint8_t* data, size_t len)
+{
+  Stream* st;
+
+  result = len && cmd >= static_cast<uint8_t>(Cmd::STREAM) && cmd <= static_cast<uint8_t>(Cmd::FOLLOW_STOP) ? 0 : ERR_CMD;
+
+  switch ( static_cast<Cmd>(cmd) )
+  {
+    case Cmd::STREAM:
+      if ( !len || data[0] >= AXIS_CNT ) break;
+      st = &streams[data[0]];
+      if ( len - 1 > stream_free(data[0]) ) return false;
+      for ( size_t i = 1; i < len; ++i )
+      {
+        st->fifo[st->tail] = data[i];
+        st->tail = (st->tail + 1) % BOARD_STREAM_SIZE;
+      }
+      break;
+
+    case Cmd::STREAM_START:
+      if ( !len ) break;
+      for ( size_t axis = 0; axis < AXIS_CNT; ++axis )
+      {
+        if ( !(data[0] & (1 << axis)) ) continue;
+        streams[axis].on = true;
+        streams[axis].due = 0;
+        streams[axis].run = 0;
+      }
+      break;
+
+    case Cmd::OVERRIDE:
+      if ( len < 3 ) break;
+      if ( data[0] == AXIS_ALL ) override[AXIS_CNT] = data[1] | (data[2] << 8);
+      else if ( data[0] < AXIS_CNT ) override[data[0]] = data[1] | (data[2] << 8);
+      break;
+
+    case Cmd::STOP:
+      if ( !len ) break;
+      for ( size_t axis = 0; axis < AXIS_CNT; ++axis )
+      {
+        if ( data[0] == axis || data[0] == AXIS_ALL ) streams[axis].on = false;
+      }
+      break;
+
+    // the other motion and settings commands aren't simulated
+    default: break;
+  }
+
+  ++cmds;
+
+  return true;
+}
+
+/*
+ * decode the due steps, the codes lengths like STR_source()
+ */
+void SimBoard::decode(Stream& st, size_t axis)
+{
+  size_t  avail, len;
+  uint8_t op;
+
+  while ( st.due >= 1 )
+  {
+    if ( st.run )
+    {
+      --st.run;
+      ++steps[axis];
+      st.due -= 1;
+      continue;
+    }
+
+    avail = (st.tail - st.head) % BOARD_STREAM_SIZE;
+    op = avail ? st.fifo[st.head] : 0;
+    len = (op & 0xC0) == OP_DD_LONG ? 2 : op == OP_SET || op == OP_WAIT ? 5 : 1;
+
+    if ( avail < len )
+    {
+      // the step is due, the data isn't
+      if ( !st.starving ) ++underruns[axis];
+      st.starving = true;
+      st.due = 0;
+      return;
+    }
+
+    st.starving = false;
+    st.head = (st.head + len) % BOARD_STREAM_SIZE;
+
+    if ( (op & 0xC0) == OP_RUN ) st.run = op & 0x3F;
+    else if ( op == OP_DIR_FWD || op == OP_DIR_BACK || op == OP_WAIT ) continue;
+    else if ( (op & 0xC0) == 0xC0 && op != OP_SET )
+    {
+      // the stream end
+      st.on = false;
+      st.due = 0;
+      return;
+    }
+
+    ++steps[axis];
+    st.due -= 1;
+  }
+}
+
+} // namespace genlink
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * File Name          : sim_board.h
+  * Description        : simulated generator board of the host link
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GENLINK_SIM_BOARD_H
+#define GENLINK_SIM_BOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "protocol.h"
+
+namespace genlink
+{
+
+// the board's link.c and stream.c FIFOs and frames handling, the axes
+// decode their streams at the constant steps rate
+class SimBoard
+{
+public:
+  explicit SimBoard(uint32_t steps_rate) : steps_rate(steps_rate) {}
+
+  // SPI byte from the master, returns the board's byte of the same SPI clocks
+  uint8_t exchange(uint8_t in);
+  // run the board's main loop and the axes for the time, s
+  void advance(double s);
+
+  // stream FIFO free space like STR_free()
+  uint16_t stream_free(size_t axis) const;
+
+  uint64_t            steps[AXIS_CNT] = {0}; // decoded steps
+  uint64_t            underruns[AXIS_CNT] = {0}; // the started stream had no data
+  uint64_t            rx_lost = 0; // the receive FIFO was full
+  uint64_t            frames = 0;
+  uint64_t            bad_frames = 0;
+  uint16_t            override[AXIS_CNT + 1] = {100, 100, 100, 100, 100};
+  uint8_t             cmds = 0; // executed commands, wraps
+  uint8_t             result = 0; // the last command result, the motion commands are accepted
+
+private:
+  struct Stream
+  {
+    std::vector<uint8_t> fifo = std::vector<uint8_t>(BOARD_STREAM_SIZE);
+    size_t            head = 0;
+    size_t            tail = 0;
+    bool              on = false;
+    bool              starving = false;
+    uint32_t          run = 0;
+    double            due = 0; // steps to decode
+  };
+
+  void process();
+  bool command(uint8_t cmd, const uint8_t* data, size_t len);
+  size_t rx_avail() const { return (rx_tail - rx_head) % BOARD_RX_SIZE; }
+  void skip(size_t n);
+  void decode(Stream& st, size_t axis);
+
+  uint32_t            steps_rate; // steps/s of every axis
+  std::vector<uint8_t> rx = std::vector<uint8_t>(BOARD_RX_SIZE);
+  size_t              rx_head = 0;
+  size_t              rx_tail = 0;
+  uint16_t            parsed = 0;
+  std::vector<uint8_t> tx;
+  size_t              tx_pos = 0;
+  Stream              streams[AXIS_CNT];
+};
+
+} // namespace genlink
+
+#endif /* GENLINK_SIM_BOARD_H */
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * File Name          : spidev_transport.cpp
+  * Description        : Linux spidev host link transport
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "transport.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/spi/spidev.h>
+#include <stdexcept>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace genlink
+{
+
+/*
+ * open the spidev device, SPI mode 0, 8 bit, MSB first like the board's SPI1
+ */
+SpidevTransport::SpidevTransport(const std::string& dev, uint32_t hz) : speed(hz)
+{
+  uint8_t mode = SPI_MODE_0;
+  uint8_t bits = 8;
+
+  fd = open(dev.c_str(), O_RDWR);
+  if ( fd < 0 ) throw std::runtime_error("genlink: " + dev + ": " + std::strerror(errno));
+
+  if ( ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+       ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+       ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0 )
+  {
+    int err = errno;
+    close(fd);
+    throw std::runtime_error("genlink: " + dev + ": " + std::strerror(err));
+  }
+}
+
+SpidevTransport::~SpidevTransport()
+{
+  if ( fd >= 0 ) close(fd);
+}
+
+/*
+ * full duplex transfer, split to the spidev buffer size
+ */
+void SpidevTransport::transfer(const uint8_t* tx, uint8_t* rx, size_t len)
+{
+  struct spi_ioc_transfer xfer;
+  size_t                  n;
+
+  for ( ; len; len -= n, tx += n, rx += n )
+  {
+    n = len < CHUNK ? len : CHUNK;
+
+    std::memset(&xfer, 0, sizeof(xfer));
+    xfer.tx_buf = reinterpret_cast<uintptr_t>(tx);
+    xfer.rx_buf = reinterpret_cast<uintptr_t>(rx);
+    xfer.len = static_cast<uint32_t>(n);
+    xfer.speed_hz = speed;
+    xfer.bits_per_word = 8;
+
+    if ( ioctl(fd, SPI_IOC_MESSAGE(1), &xfer) < 0 )
+    {
+      throw std::runtime_error(std::string("genlink: spidev transfer: ") + std::strerror(errno));
+    }
+  }
+}
+
+} // namespace genlink
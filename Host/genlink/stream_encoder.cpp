@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * File Name          : stream_encoder.cpp
+  * Description        : board's compressed steps intervals stream encoder
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "stream_encoder.h"
+
+namespace genlink
+{
+
+void StreamEncoder::put32(uint8_t op, uint32_t v)
+{
+  out.push_back(op);
+  out.push_back(v & 0xFF);
+  out.push_back((v >> 8) & 0xFF);
+  out.push_back((v >> 16) & 0xFF);
+  out.push_back(v >> 24);
+}
+
+/*
+ * the run code is n+1 steps
+ */
+void StreamEncoder::run_flush()
+{
+  uint32_t n;
+
+  for ( ; run; run -= n )
+  {
+    n = run < 64 ? run : 64;
+    out.push_back(OP_RUN | (n - 1));
+  }
+}
+
+void StreamEncoder::step(uint32_t iv, int8_t d)
+{
+  int64_t dd;
+
+  // the board's interval is 31 bit
+  if ( iv > 0x7FFFFFFF ) iv = 0x7FFFFFFF;
+  if ( !iv ) iv = 1;
+
+  if ( (d < 0 ? -1 : 1) != dir )
+  {
+    run_flush();
+    dir = d < 0 ? -1 : 1;
+    out.push_back(dir < 0 ? OP_DIR_BACK : OP_DIR_FWD);
+  }
+
+  dd = static_cast<int64_t>(iv) - interval - delta;
+  ++steps;
+
+  if ( !dd )
+  {
+    interval += delta;
+    ++run;
+    return;
+  }
+
+  run_flush();
+
+  if ( dd >= -32 && dd <= 31 )
+  {
+    out.push_back(OP_DD | (dd & 0x3F));
+  }
+  else if ( dd >= -8192 && dd <= 8191 )
+  {
+    out.push_back(OP_DD_LONG | ((dd >> 8) & 0x3F));
+    out.push_back(dd & 0xFF);
+  }
+  else
+  {
+    put32(OP_SET, iv);
+    interval = iv;
+    delta = 0;
+    return;
+  }
+
+  delta += dd;
+  interval += delta;
+}
+
+void StreamEncoder::wait(uint32_t ticks)
+{
+  run_flush();
+  // 0xFFFFFFFF is the board's source without data, GEN_PRF_WAIT
+  put32(OP_WAIT, !ticks ? 1 : ticks > 0xFFFFFFFE ? 0xFFFFFFFE : ticks);
+}
+
+void StreamEncoder::end()
+{
+  run_flush();
+  out.push_back(OP_END);
+}
+
+} // namespace genlink
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * File Name          : stream_encoder.h
+  * Description        : board's compressed steps intervals stream encoder
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GENLINK_STREAM_ENCODER_H
+#define GENLINK_STREAM_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "protocol.h"
+
+namespace genlink
+{
+
+// the encoder mirrors the board's decoder state, every interval is the
+// 2nd difference code, a run of the equal differences or a new interval
+class StreamEncoder
+{
+public:
+  // the step after the interval from the previous step or wait, ticks, dir -1/1
+  void step(uint32_t interval, int8_t dir);
+  // the time without a step, ticks, 0xFFFFFFFE max
+  void wait(uint32_t ticks);
+  void end();
+
+  // encoded bytes, the pending run isn't in them until flush()
+  std::vector<uint8_t>& bytes() { return out; }
+  void flush() { run_flush(); }
+
+  uint64_t            steps = 0;
+
+private:
+  void run_flush();
+  void put32(uint8_t op, uint32_t v);
+
+  int64_t             interval = 0;
+  int64_t             delta = 0;
+  int8_t              dir = 1;
+  uint32_t            run = 0; // steps with zero 2nd difference
+  std::vector<uint8_t> out;
+};
+
+} // namespace genlink
+
+#endif /* GENLINK_STREAM_ENCODER_H */
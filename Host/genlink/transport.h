@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * File Name          : transport.h
+  * Description        : host link transports
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#ifndef GENLINK_TRANSPORT_H
+#define GENLINK_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "sim_board.h"
+
+namespace genlink
+{
+
+// full duplex byte transfer, the board is the SPI slave
+class Transport
+{
+public:
+  virtual ~Transport() = default;
+
+  // send tx and receive the same count of the board's bytes to rx
+  virtual void transfer(const uint8_t* tx, uint8_t* rx, size_t len) = 0;
+};
+
+// Linux spidev master
+class SpidevTransport : public Transport
+{
+public:
+  SpidevTransport(const std::string& dev, uint32_t hz);
+  ~SpidevTransport() override;
+
+  SpidevTransport(const SpidevTransport&) = delete;
+  SpidevTransport& operator=(const SpidevTransport&) = delete;
+
+  void transfer(const uint8_t* tx, uint8_t* rx, size_t len) override;
+
+private:
+  static constexpr size_t CHUNK = 4096; // spidev default buffer size
+
+  int                 fd = -1;
+  uint32_t            speed;
+};
+
+// in-process transport to the simulated board, the board's time runs
+// by the SPI clock of the transferred bytes
+class LoopbackTransport : public Transport
+{
+public:
+  LoopbackTransport(SimBoard& board, uint32_t hz) : board(board), hz(hz) {}
+
+  void transfer(const uint8_t* tx, uint8_t* rx, size_t len) override;
+
+  // let the board run without the transfers, s
+  void idle(double s) { board.advance(s); }
+
+private:
+  SimBoard&           board;
+  uint32_t            hz;
+};
+
+} // namespace genlink
+
+#endif /* GENLINK_TRANSPORT_H */
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * File Name          : cmsis_host.h
+  * Description        : Cortex-M intrinsics of the host tests build
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  * the firmware units are built for the host with -D__CMSIS_GCC_H, so the
+  * ARM inline assembly of cmsis_gcc.h is replaced by these functions
+  *
+  ******************************************************************************
+  */
+
+#ifndef __CMSIS_HOST_H
+#define __CMSIS_HOST_H
+
+#include <stdint.h>
+
+#define __ASM                   __asm
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+
+// the interrupts mask of the host build, the tests are single threaded
+static uint32_t host_primask = 0;
+
+__STATIC_INLINE void __enable_irq(void) { host_primask = 0; }
+__STATIC_INLINE void __disable_irq(void) { host_primask = 1; }
+__STATIC_INLINE uint32_t __get_PRIMASK(void) { return host_primask; }
+__STATIC_INLINE void __set_PRIMASK(uint32_t m) { host_primask = m; }
+__STATIC_INLINE void __DSB(void) {}
+__STATIC_INLINE void __ISB(void) {}
+__STATIC_INLINE void __DMB(void) {}
+__STATIC_INLINE void __NOP(void) {}
+__STATIC_INLINE uint32_t __get_CONTROL(void) { return 0; }
+__STATIC_INLINE uint32_t __get_IPSR(void) { return 0; }
+__STATIC_INLINE uint32_t __get_BASEPRI(void) { return 0; }
+__STATIC_INLINE void __set_BASEPRI(uint32_t v) { (void)v; }
+__STATIC_INLINE uint32_t __get_FAULTMASK(void) { return 0; }
+__STATIC_INLINE void __set_FAULTMASK(uint32_t v) { (void)v; }
+__STATIC_INLINE uint32_t __get_MSP(void) { return 0; }
+__STATIC_INLINE void __set_MSP(uint32_t v) { (void)v; }
+__STATIC_INLINE uint32_t __get_PSP(void) { return 0; }
+__STATIC_INLINE void __set_PSP(uint32_t v) { (void)v; }
+__STATIC_INLINE uint32_t __RBIT(uint32_t v)
+{
+  uint32_t r = 0;
+  for ( int i = 0; i < 32; ++i ) r |= ((v >> i) & 1) << (31 - i);
+  return r;
+}
+#define __CLZ                   __builtin_clz
+#define __REV                   __builtin_bswap32
+
+#endif /* __CMSIS_HOST_H */
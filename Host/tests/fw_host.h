@@ -0,0 +1,102 @@
+/**
+  ******************************************************************************
+  * File Name          : fw_host.h
+  * Description        : firmware units host build support of the tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  * the test includes this file and then the firmware unit source, the timers
+  * and DMA channels of the axes are plain memory, the core peripherals
+  * are redirected to it too
+  *
+  ******************************************************************************
+  */
+
+#ifndef __FW_HOST_H
+#define __FW_HOST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stm32f1xx_hal.h"
+
+
+
+
+/* checks --------------------------------------------------------------------*/
+
+static int host_fails = 0;
+
+#define CHECK(c) \
+  do { if ( !(c) ) { ++host_fails; printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); } } while ( 0 )
+
+#define CHECK_EQ(a, b) \
+  do { long long _a = (long long)(a), _b = (long long)(b); if ( _a != _b ) { ++host_fails; \
+    printf("%s:%d: %s == %s failed, %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); } } while ( 0 )
+
+#define HOST_RESULT() (printf("%s: %s\n", __FILE__, host_fails ? "FAIL" : "OK"), host_fails ? 1 : 0)
+
+
+
+
+/* peripherals ---------------------------------------------------------------*/
+
+static TIM_TypeDef          host_tim[4];
+static DMA_Channel_TypeDef  host_dma_ch[4];
+static DMA_TypeDef          host_dma = { 0xFFFFFFFF, 0 };
+static DWT_Type             host_dwt;
+static CoreDebug_Type       host_core_debug;
+static GPIO_TypeDef         host_gpio[2];
+static uint32_t             host_tick = 0;
+
+#undef DWT
+#define DWT (&host_dwt)
+#undef CoreDebug
+#define CoreDebug (&host_core_debug)
+#undef DMA1
+#define DMA1 (&host_dma)
+#undef TIM1
+#define TIM1 (&host_tim[0])
+#undef GPIOA
+#define GPIOA (&host_gpio[0])
+#undef GPIOB
+#define GPIOB (&host_gpio[1])
+
+TIM_HandleTypeDef htim1 = { .Instance = &host_tim[0] };
+TIM_HandleTypeDef htim2 = { .Instance = &host_tim[1] };
+TIM_HandleTypeDef htim3 = { .Instance = &host_tim[2] };
+TIM_HandleTypeDef htim4 = { .Instance = &host_tim[3] };
+DMA_HandleTypeDef hdma_tim1_ch4_trig_com = { .Instance = &host_dma_ch[0], .ChannelIndex = 12 };
+DMA_HandleTypeDef hdma_tim2_ch2_ch4 = { .Instance = &host_dma_ch[1], .ChannelIndex = 24 };
+DMA_HandleTypeDef hdma_tim3_ch1_trig = { .Instance = &host_dma_ch[2], .ChannelIndex = 20 };
+DMA_HandleTypeDef hdma_tim4_ch1 = { .Instance = &host_dma_ch[3], .ChannelIndex = 0 };
+
+uint32_t SystemCoreClock = 72000000;
+
+void TIM_CCxChannelCmd(TIM_TypeDef* tim, uint32_t ch, uint32_t state)
+{
+  tim->CCER = (tim->CCER & ~(TIM_CCER_CC1E << ch)) | (state << ch);
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init) { (void)port; (void)init; }
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin)
+{
+  return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state)
+{
+  if ( state == GPIO_PIN_SET ) port->ODR |= pin;
+  else port->ODR &= ~pin;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void) { return 72000000; }
+uint32_t HAL_SYSTICK_Config(uint32_t ticks) { (void)ticks; return 0; }
+uint32_t HAL_GetTick(void) { return host_tick; }
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t pre, uint32_t sub) { (void)irq; (void)pre; (void)sub; }
+void HAL_NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+
+#endif /* __FW_HOST_H */
@@ -0,0 +1,21 @@
+#!/bin/sh
+# build and run the host tests, the firmware units are built for the host
+cd "$(dirname "$0")" || exit 1
+
+FW="-Wno-pointer-to-int-cast -Wno-int-to-pointer-cast -D__CMSIS_GCC_H -include cmsis_host.h -DSTM32F103xB -DUSE_HAL_DRIVER -I../../Inc
+    -I../../Drivers/STM32F1xx_HAL_Driver/Inc -I../../Drivers/CMSIS/Device/ST/STM32F1xx/Include
+    -I../../Drivers/CMSIS/Include"
+OUT="${TMPDIR:-/tmp}"
+fail=0
+
+for t in test_*.c; do
+  # the genlink host code of the test is C++
+  host=""
+  if [ -f "${t%.c}_host.cpp" ]; then
+    g++ -std=c++17 -O1 -c -o "$OUT/${t%.c}_host.o" "${t%.c}_host.cpp" || { fail=1; continue; }
+    host="$OUT/${t%.c}_host.o -lstdc++"
+  fi
+  gcc -std=gnu11 -O1 $FW -o "$OUT/${t%.c}" "$t" $host -lm && "$OUT/${t%.c}" || fail=1
+done
+
+exit $fail
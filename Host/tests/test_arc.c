@@ -0,0 +1,178 @@
+/**
+  ******************************************************************************
+  * File Name          : test_arc.c
+  * Description        : arc interpolation walk host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "fw_host.h"
+#include "../../Src/generator.c"
+#include "../../Src/arc.c"
+
+void HOME_output_complete(uint8_t axis) { (void)axis; }
+void HOME_abort(uint8_t axis) { (void)axis; }
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+/*
+ * generator state of the test start
+ */
+static void HOST_reset(void)
+{
+  GEN_init();
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    profile[axis].on = 0;
+    axes[axis].busy = 0;
+    // the host DMA calibration has no clocks counter
+    axes[axis].dma_clk = 1;
+  }
+  ovr_cur = 100;
+  ovr_req = 100;
+}
+
+/*
+ * walk of the arc relative to the centre, it's set like ARC_start does
+ */
+static struct ARC_WALK_t HOST_walk(int32_t x, int32_t y, int32_t xe, int32_t ye, uint8_t cw)
+{
+  struct ARC_WALK_t w = {0};
+  uint32_t          rmax = ARC_abs(x) > ARC_abs(y) ? ARC_abs(x) : ARC_abs(y);
+  uint32_t          a0, a1;
+
+  w.x = x;
+  w.y = y;
+  w.xe = xe;
+  w.ye = ye;
+  w.r2 = (int64_t)x*x + (int64_t)y*y;
+  w.cw = cw;
+  w.left = 16*rmax + 16;
+
+  a0 = ARC_angle(x, y);
+  a1 = ARC_angle(xe, ye);
+  w.moves = ARC_moves(&w, a0, x == xe && y == ye ? 4*ARC_QUARTER : ((cw ? a0 - a1 : a1 - a0) & (4*ARC_QUARTER - 1)));
+
+  return w;
+}
+
+/*
+ * the walk ends at the end point, the moves estimate is near the walk
+ */
+static void HOST_arc_check(int32_t x, int32_t y, int32_t xe, int32_t ye, uint8_t cw, uint32_t nz)
+{
+  struct ARC_WALK_t w = HOST_walk(x, y, xe, ye, cw);
+  uint32_t          moves = 0, z = 0, zend = 0;
+  int8_t            dx, dy, dz;
+
+  w.nz = nz;
+  w.zleft = nz;
+  w.zdir = 1;
+
+  while ( ARC_walk(&w, &dx, &dy, &dz) )
+  {
+    moves += dx || dy;
+    z += dz;
+    zend += dz && !dx && !dy;
+  }
+
+  CHECK_EQ(w.x, xe);
+  CHECK_EQ(w.y, ye);
+  CHECK_EQ(z, nz);
+  // the helix steps are spread over the plane moves
+  CHECK(zend <= 8);
+  CHECK(moves + 8 >= w.moves && w.moves + 8 >= moves);
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * the closed form moves of the quarters, the full circles and the odd arcs
+ */
+static void test_arc_moves(void)
+{
+  HOST_arc_check(1000, 0, 0, 1000, 0, 0);
+  HOST_arc_check(1000, 0, 0, -1000, 1, 0);
+  HOST_arc_check(500, 0, 500, 0, 0, 0);
+  HOST_arc_check(300, 400, -400, -300, 1, 0);
+  HOST_arc_check(300, 400, -400, -300, 0, 0);
+  HOST_arc_check(-707, 707, 707, 707, 1, 0);
+  HOST_arc_check(3, 0, 0, 3, 0, 0);
+  HOST_arc_check(100000, 1, -99999, 447, 0, 0);
+  HOST_arc_check(-12345, 6789, -12345, 6789, 1, 0);
+  // the end point next to the start one, the long and the short arcs
+  HOST_arc_check(1000, 0, 1000, 1, 1, 0);
+  HOST_arc_check(1000, 0, 1000, 1, 0, 0);
+  HOST_arc_check(-707, -707, -708, -706, 0, 0);
+  HOST_arc_check(-707, -707, -708, -706, 1, 0);
+}
+
+/*
+ * all helix steps are taken, the estimate error steps are at the end, one step per plane move max
+ */
+static void test_arc_helix(void)
+{
+  HOST_arc_check(1000, 0, 0, 1000, 0, 1400);
+  HOST_arc_check(300, 400, -400, -300, 1, 7);
+  HOST_arc_check(-12345, 6789, -12345, 6789, 0, 54321);
+  HOST_arc_check(1000, 0, 1000, 1, 1, 3000);
+  HOST_arc_check(1000, 0, 1000, 1, 0, 1);
+}
+
+/*
+ * the walk out of the safety count goes to the end point straight
+ */
+static void test_arc_walk_left(void)
+{
+  struct ARC_WALK_t w = HOST_walk(1000, 0, 0, 1000, 0);
+  int8_t            dx, dy, dz;
+
+  w.left = 100;
+  while ( ARC_walk(&w, &dx, &dy, &dz) );
+
+  CHECK_EQ(w.x, 0);
+  CHECK_EQ(w.y, 1000);
+}
+
+/*
+ * the quadrature axes run the arc, it's the profile output
+ */
+static void test_arc_quad(void)
+{
+  struct ARC_t arc = {0, 1, GEN_AXIS_NONE, -1000, 1000, 0, -1000, 0, 0, 1000};
+
+  HOST_reset();
+  CHECK_EQ(GEN_mode_set(0, GEN_MODE_QUAD), GEN_OK);
+  CHECK_EQ(GEN_mode_set(1, GEN_MODE_QUAD), GEN_OK);
+
+  CHECK_EQ(ARC_start(&arc), GEN_OK);
+  CHECK(profile[0].on && profile[1].on);
+  // the constant frequency output still has no quadrature
+  CHECK_EQ(GEN_move(2, 1, 10, 1000), GEN_OK);
+  CHECK_EQ(GEN_mode_set(3, GEN_MODE_QUAD), GEN_OK);
+  CHECK_EQ(GEN_move(3, -1, 10, 1000), GEN_ERR_MODE);
+  // the rejected move doesn't change the direction
+  CHECK_EQ(axes[3].dir, 1);
+}
+
+
+
+
+int main(void)
+{
+  test_arc_moves();
+  test_arc_helix();
+  test_arc_walk_left();
+  test_arc_quad();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,208 @@
+/**
+  ******************************************************************************
+  * File Name          : test_follow.c
+  * Description        : step/dir input re-generator host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "fw_host.h"
+#include "../../Src/generator.c"
+#include "../../Src/follow.c"
+
+void HOME_output_complete(uint8_t axis) { (void)axis; }
+void HOME_abort(uint8_t axis) { (void)axis; }
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+/*
+ * re-generator state of the start without the input and the profile output, like FOL_start() sets it
+ */
+static struct FOL_t* HOST_follow(uint32_t num, uint32_t den, uint8_t avg)
+{
+  struct FOL_t* f = &follows[0];
+
+  memset(f, 0, sizeof(*f));
+  f->num = num;
+  f->den = den;
+  f->avg = avg;
+  f->ticks = 72000;
+  f->on = 1;
+
+  return f;
+}
+
+/*
+ * the input steps of the next sample
+ */
+static void HOST_input(struct FOL_t* f, int16_t n)
+{
+  f->fifo[f->tail] = n;
+  f->tail = (f->tail + 1) & FOL_MASK;
+}
+
+/*
+ * play one sample time, the output steps are evenly spaced inside it
+ *
+ * returns 1 if the sample is played, GEN_PRF_WAIT if there is no sample, 0 at the end
+ */
+static uint32_t HOST_play(struct FOL_t* f, int32_t* steps)
+{
+  uint32_t  len, ticks = 0;
+  int8_t    dir;
+
+  *steps = 0;
+
+  do
+  {
+    dir = 0;
+    len = FOL_source(f, &dir);
+    if ( !len || len == GEN_PRF_WAIT ) return len;
+
+    if ( len < f->ticks / f->slots || len > f->ticks / f->slots + 1 )
+    {
+      CHECK(len >= f->ticks / f->slots && len <= f->ticks / f->slots + 1);
+      printf("  at the slot %u of %u\n", f->slot, f->slots);
+    }
+    ticks += len;
+    *steps += dir;
+  }
+  while ( f->slot < f->slots );
+
+  CHECK_EQ(ticks, f->ticks);
+
+  return 1;
+}
+
+/*
+ * output steps of the next sample time
+ */
+static int32_t HOST_sample(struct FOL_t* f)
+{
+  int32_t steps;
+
+  CHECK_EQ(HOST_play(f, &steps), 1);
+
+  return steps;
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * the output steps are the input ones multiplied by num/den, the fractions
+ * are carried, the stopped input flushes the filter
+ */
+static void test_follow_ratio(void)
+{
+  struct FOL_t* f = HOST_follow(3, 7, 5);
+  int32_t       in = 0, out = 0, n;
+  uint32_t      i;
+
+  for ( i = 0; i < 200; ++i )
+  {
+    n = (i * 37) % 41;
+    HOST_input(f, n);
+    in += n;
+    out += HOST_sample(f);
+  }
+  CHECK_EQ(HOST_play(f, &n), GEN_PRF_WAIT);
+
+  f->stop = 1;
+  while ( HOST_play(f, &n) == 1 ) out += n;
+
+  CHECK_EQ(out, in * 3 / 7);
+  CHECK_EQ(f->on, 0);
+}
+
+/*
+ * the output speed is the moving average of the input speed
+ */
+static void test_follow_filter(void)
+{
+  static const int32_t  exp[] = {2, 4, 6, 8, 8, 8, 6, 4, 2, 0};
+  struct FOL_t*         f = HOST_follow(1, 1, 4);
+
+  for ( uint32_t i = 0; i < 10; ++i )
+  {
+    HOST_input(f, i < 6 ? 8 : 0);
+    CHECK_EQ(HOST_sample(f), exp[i]);
+  }
+
+  // the reversal is averaged too
+  HOST_input(f, -8);
+  CHECK_EQ(HOST_sample(f), -2);
+  CHECK_EQ(f->dir, -1);
+}
+
+/*
+ * the steps over the max frequency are done at the next samples
+ */
+static void test_follow_max_freq(void)
+{
+  struct FOL_t* f = HOST_follow(1, 1, 1);
+  int32_t       max = GEN_FREQ_MAX / GEN_SYSTICK_IRQ_FREQ;
+
+  HOST_input(f, max + 100);
+  HOST_input(f, 0);
+  CHECK_EQ(HOST_sample(f), max);
+  CHECK_EQ(f->slots, (uint32_t)max);
+  CHECK_EQ(HOST_sample(f), 100);
+
+  HOST_input(f, -max - 100);
+  HOST_input(f, 0);
+  CHECK_EQ(HOST_sample(f), -max);
+  CHECK_EQ(HOST_sample(f), -100);
+}
+
+/*
+ * the re-generator stopped by GEN_stop() releases its input, it starts again
+ */
+static void test_follow_abort(void)
+{
+  uint8_t axis = 1, input = 2;
+
+  GEN_init();
+  // the host DMA calibration has no clocks counter
+  axes[axis].dma_clk = 1;
+
+  CHECK_EQ(FOL_start(axis, input, 1, 1, 1), GEN_OK);
+  CHECK_EQ(follows[axis].on, 1);
+  CHECK_EQ(verify[input].counts, 1);
+  CHECK_EQ(FOL_start(axis, input, 1, 1, 1), GEN_ERR_BUSY);
+
+  GEN_stop(axis);
+  FOL_stop(axis);
+  CHECK_EQ(follows[axis].on, 0);
+  CHECK_EQ(verify[input].counts, 0);
+
+  CHECK_EQ(FOL_start(axis, input, 1, 1, 1), GEN_OK);
+  GEN_stop(axis);
+  CHECK_EQ(FOL_start(axis, input, 2, 1, 1), GEN_OK);
+  CHECK_EQ(follows[axis].num, 2);
+  GEN_stop(axis);
+  FOL_stop(axis);
+}
+
+
+
+
+int main(void)
+{
+  GEN_init();
+
+  test_follow_ratio();
+  test_follow_filter();
+  test_follow_max_freq();
+  test_follow_abort();
+
+  return HOST_RESULT();
+}
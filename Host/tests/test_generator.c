@@ -0,0 +1,931 @@
+/**
+  ******************************************************************************
+  * File Name          : test_generator.c
+  * Description        : steps generation arithmetic host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  * gcc -std=gnu11 -D__CMSIS_GCC_H -include cmsis_host.h -DSTM32F103xB
+  *     -DUSE_HAL_DRIVER -I../../Inc -I../../Drivers/STM32F1xx_HAL_Driver/Inc
+  *     -I../../Drivers/CMSIS/Device/ST/STM32F1xx/Include
+  *     -I../../Drivers/CMSIS/Include -o test_generator test_generator.c
+  *
+  ******************************************************************************
+  */
+
+#include "fw_host.h"
+#include "../../Src/generator.c"
+
+void HOME_output_complete(uint8_t axis) { (void)axis; }
+void HOME_abort(uint8_t axis) { (void)axis; }
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+// test steps source, the intervals list with the directions, 0 is the end
+struct SRC_t
+{
+  const uint32_t*     len;
+  const int8_t*       dir;
+  uint32_t            n;
+  uint32_t            i;
+};
+
+static uint32_t SRC_source(void* ctx, int8_t* dir)
+{
+  struct SRC_t* s = ctx;
+
+  if ( s->i >= s->n ) return 0;
+
+  *dir = s->dir[s->i];
+  return s->len[s->i++];
+}
+
+/*
+ * generator state of the test start
+ */
+static void HOST_reset(void)
+{
+  GEN_init();
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    profile[axis].on = 0;
+    axes[axis].busy = 0;
+    // the host DMA calibration has no clocks counter
+    axes[axis].dma_clk = 1;
+    axes[axis].pos = 0;
+  }
+  ovr_cur = 100;
+  ovr_req = 100;
+}
+
+/*
+ * ticks of the ring periods from the period i to the next step period
+ */
+static uint64_t HOST_ring_interval(uint8_t axis, uint32_t* i)
+{
+  uint64_t t = 0;
+
+  do
+  {
+    t += GEN_profile_period_ticks(axis, *i);
+    *i = (*i + 1) % PRF_RING_SIZE;
+  }
+  while ( !PRF_step[axis][*i] );
+
+  return t;
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * the timer data is updated at the frequency change over 16 bits and at the pulse width change
+ */
+static void test_pulse_width(void)
+{
+  TIM_TypeDef*  tim;
+  uint8_t       axis = 1;
+
+  HOST_reset();
+  tim = axes[axis].htim->Instance;
+
+  CHECK_EQ(GEN_steps_output(axis, 10, 70000), GEN_OK);
+  CHECK_EQ(tim->ARR, axes[axis].tim_freq / 70000 - 1);
+  axes[axis].busy = 0;
+  // 70000 is 4464 in 16 bits
+  CHECK_EQ(GEN_steps_output(axis, 10, 4464), GEN_OK);
+  CHECK_EQ(tim->ARR, axes[axis].tim_freq / 4464 - 1);
+  axes[axis].busy = 0;
+
+  CHECK_EQ(GEN_pulse_width_set(GEN_AXIS_CNT, 2000), GEN_ERR_AXIS);
+  CHECK_EQ(GEN_pulse_width_set(axis, 2000), GEN_OK);
+  CHECK_EQ(GEN_steps_output(axis, 10, 4464), GEN_OK);
+  CHECK_EQ(tim->CCR1, axes[axis].pulse_clk);
+  axes[axis].busy = 0;
+  CHECK_EQ(GEN_pulse_width_set(axis, 0), GEN_OK);
+}
+
+/*
+ * the axes 0 and 1 outputs use the CC4 DMA requests, the frozen compare
+ * is at the pulse end of the steps output, the profile request is at the Update event
+ */
+static void test_dma_request(void)
+{
+  static const uint32_t len[] = {7200, 7200};
+  static const int8_t   dir[] = {1, 1};
+  struct SRC_t          src = {len, dir, 2, 0};
+  TIM_TypeDef*          tim;
+
+  HOST_reset();
+  tim = axes[0].htim->Instance;
+  tim->DIER = 0;
+  CHECK_EQ(GEN_steps_output(0, 10, 10000), GEN_OK);
+  CHECK_EQ(tim->DIER & (TIM_DMA_CC1 | TIM_DMA_CC4), TIM_DMA_CC4);
+  CHECK_EQ(tim->CCR4, tim->CCR1);
+  GEN_stop(0);
+  CHECK_EQ(tim->DIER & TIM_DMA_CC4, 0);
+
+  tim = axes[1].htim->Instance;
+  tim->DIER = 0;
+  CHECK_EQ(GEN_profile_set(1, SRC_source, &src), GEN_OK);
+  CHECK_EQ(tim->DIER & (TIM_DMA_CC1 | TIM_DMA_CC4), TIM_DMA_CC4);
+  CHECK_EQ(tim->CR2 & TIM_CR2_CCDS, TIM_CR2_CCDS);
+  GEN_stop(1);
+  CHECK_EQ(tim->CR2 & TIM_CR2_CCDS, 0);
+
+  tim = axes[2].htim->Instance;
+  tim->DIER = 0;
+  CHECK_EQ(GEN_steps_output(2, 10, 10000), GEN_OK);
+  CHECK_EQ(tim->DIER & (TIM_DMA_CC1 | TIM_DMA_CC4), TIM_DMA_CC1);
+  GEN_stop(2);
+}
+
+/*
+ * the equal periods of the TIM1 axis are the repetitions of one ring period,
+ * the last two periods of the half aren't repeated, the other axes don't repeat
+ */
+static void test_profile_runs(void)
+{
+  static uint32_t       len[200];
+  static int8_t         dir[200];
+  struct SRC_t          src = {len, dir, 200, 0};
+  uint32_t              i, h, steps = 0;
+  uint8_t               axis;
+
+  for ( i = 0; i < 200; ++i )
+  {
+    len[i] = 7200;
+    dir[i] = 1;
+  }
+
+  HOST_reset();
+  CHECK_EQ(GEN_profile_set(0, SRC_source, &src), GEN_OK);
+  CHECK_EQ(profile[0].runs, 1);
+  // the 1st period is before the 1st step, 144000 ticks of a burst are 20 periods
+  CHECK_EQ(PRF_ring[0][0][2], 0);
+  CHECK_EQ(PRF_ring[0][1][2], 19);
+  for ( h = 0; h < 2; ++h )
+  {
+    CHECK_EQ(PRF_ring[0][h*GEN_PRF_HALF_SIZE + GEN_PRF_HALF_SIZE - 1][2], 0);
+    CHECK_EQ(PRF_ring[0][h*GEN_PRF_HALF_SIZE + GEN_PRF_HALF_SIZE - 2][2], 0);
+  }
+  for ( i = 0; i < PRF_RING_SIZE; ++i ) steps += GEN_profile_period_steps(0, i);
+  CHECK_EQ(steps, 200);
+  CHECK_EQ(profile[0].net[0] + profile[0].net[1], 200);
+  GEN_stop(0);
+
+  for ( axis = 1; axis < GEN_AXIS_CNT; ++axis )
+  {
+    src.i = 0;
+    CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+    CHECK_EQ(profile[axis].runs, 0);
+    for ( i = 0; i < PRF_RING_SIZE; ++i ) CHECK_EQ(PRF_ring[axis][i][2], 0);
+    GEN_stop(axis);
+  }
+}
+
+/*
+ * the stop in the repeated period counts its pulses by the time from the output start
+ */
+static void test_profile_runs_stop(void)
+{
+  static uint32_t       len[100];
+  static int8_t         dir[100];
+  struct SRC_t          src = {len, dir, 100, 0};
+  TIM_TypeDef*          tim = axes[0].htim->Instance;
+  uint32_t              i;
+
+  for ( i = 0; i < 100; ++i )
+  {
+    len[i] = 7200;
+    dir[i] = 1;
+  }
+
+  HOST_reset();
+  CHECK_EQ(GEN_profile_set(0, SRC_source, &src), GEN_OK);
+  GEN_profile_start(1);
+
+  // the 2nd period repeats 20 times, the 6th repetition is in progress,
+  // the Update event request has read the 3rd period
+  axes[0].hdma->Instance->CNDTR = PRF_RING_SIZE*5 - 3*5;
+  DWT->CYCCNT = profile[0].cyc + GEN_PRF_PAD_TICKS + 7200 + 5*7200 + 100;
+  tim->CNT = 100;
+  GEN_stop(0);
+  CHECK_EQ(axes[0].pos, 6);
+  CHECK_EQ(tim->CR2 & TIM_CR2_CCDS, 0);
+}
+
+/*
+ * the inverted limits and the frequencies over the max are rejected,
+ * the move can't end out of the soft limits
+ */
+static void test_limits(void)
+{
+  struct LIMITS_t lim = {0};
+  uint8_t         axis = 2;
+
+  HOST_reset();
+  lim.pos_on = 1;
+  lim.pos_min = -5;
+  lim.pos_max = 10;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_OK);
+  lim.pos_min = 11;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_ERR_LIMIT);
+  lim.pos_min = -5;
+  lim.freq_max = GEN_FREQ_MAX + 1;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_ERR_FREQ);
+  lim.freq_max = 1000;
+  lim.freq_start = 2000;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_ERR_FREQ);
+  CHECK_EQ(GEN_limits_set(GEN_AXIS_CNT, &lim), GEN_ERR_AXIS);
+
+  CHECK_EQ(GEN_move_check(axis, 1, 11, 1000), GEN_ERR_LIMIT);
+  CHECK_EQ(GEN_move_check(axis, -1, 5, 1000), GEN_OK);
+  CHECK_EQ(GEN_move_check(axis, 1, 10, 1000), GEN_OK);
+
+  lim.pos_on = 0;
+  lim.freq_max = 0;
+  lim.freq_start = 0;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_OK);
+}
+
+/*
+ * the warped intervals are the scaled source time without drift and truncation
+ */
+static void test_warp(void)
+{
+  struct PRF_t  prf = {0};
+  uint64_t      sum = 0;
+
+  // 50% doubles the 2^31 ticks wait to 2^32
+  prf.ovr = 50;
+  prf.axis_ovr = 100;
+  CHECK_EQ(GEN_profile_warp(&prf, 0x80000000), 0x100000000ULL);
+
+  // the starvation slows down to 1%
+  prf = (struct PRF_t){0};
+  prf.ovr = GEN_OVR_MIN;
+  prf.axis_ovr = 100;
+  CHECK_EQ(GEN_profile_warp(&prf, 0xFFFFFFFE), 0xFFFFFFFEULL * 100 / GEN_OVR_MIN);
+
+  // the tick fractions are carried, the scaled time is 1/256 ticks per interval
+  prf = (struct PRF_t){0};
+  prf.ovr = 70;
+  prf.axis_ovr = 100;
+  for ( int i = 0; i < 1000; ++i ) sum += GEN_profile_warp(&prf, 12345);
+  CHECK(12345ULL * 1000 * 100 / 70 - sum <= 1000 / 256 + 1);
+
+  // the override switch inside the interval
+  prf = (struct PRF_t){0};
+  prf.ovr = 100;
+  prf.axis_ovr = 100;
+  prf.ovr_pending = 1;
+  prf.ovr_at = 1000;
+  prf.ovr_next = 50;
+  CHECK_EQ(GEN_profile_warp(&prf, 3000), 1000 + 2000 * 2);
+  CHECK_EQ(prf.ovr, 50);
+}
+
+/*
+ * the DMA channels priorities are ranked by the outputs rates, the equal rates
+ * keep the axes order, the idle axis is the lowest one
+ */
+static void test_dma_priorities(void)
+{
+  static const uint32_t pl[GEN_AXIS_CNT] = {1, 0, 3, 2};
+  uint8_t               axis;
+
+  HOST_reset();
+  CHECK_EQ(GEN_steps_output(3, 10, 10000), GEN_OK);
+  CHECK_EQ(GEN_steps_output(0, 10, 5000), GEN_OK);
+  // the IRQ handler's call keeps the interrupts masked
+  host_primask = 1;
+  CHECK_EQ(GEN_steps_output(2, 10, 10000), GEN_OK);
+  CHECK_EQ(host_primask, 1);
+  host_primask = 0;
+
+  for ( axis = 0; axis < GEN_AXIS_CNT; ++axis )
+  {
+    if ( (axes[axis].hdma->Instance->CCR & DMA_CCR_PL) >> DMA_CCR_PL_Pos != pl[axis] )
+    {
+      CHECK_EQ((axes[axis].hdma->Instance->CCR & DMA_CCR_PL) >> DMA_CCR_PL_Pos, pl[axis]);
+      printf("  at the axis %u\n", axis);
+    }
+  }
+
+  for ( axis = GEN_AXIS_CNT; axis--; ) GEN_stop(axis);
+}
+
+/*
+ * the transfer complete after the counter wrap is the late stop
+ */
+static void test_late_stop(void)
+{
+  struct GEN_STATUS_t st;
+  TIM_TypeDef*        tim;
+  uint8_t             axis = 2;
+
+  HOST_reset();
+  tim = axes[axis].htim->Instance;
+  axes[axis].late_stops = 0;
+
+  CHECK_EQ(GEN_steps_output(axis, 10, 10000), GEN_OK);
+  axes[axis].hdma->Instance->CNDTR = 0;
+  tim->CNT = tim->CCR1;
+  GEN_DMA_transfer_complete(axis);
+  GEN_status_get(axis, &st);
+  CHECK_EQ(st.late_stops, 0);
+
+  CHECK_EQ(GEN_steps_output(axis, 10, 10000), GEN_OK);
+  axes[axis].hdma->Instance->CNDTR = 0;
+  tim->CNT = tim->CCR1 - 1;
+  GEN_DMA_transfer_complete(axis);
+  GEN_status_get(axis, &st);
+  CHECK_EQ(st.late_stops, 1);
+  CHECK_EQ(axes[axis].busy, 0);
+}
+
+/*
+ * the checker counts the axis pulses over its 16 bit counter wrap, the output
+ * with the wrong count is reported by its id, the checker isn't an output
+ */
+static void test_verify(void)
+{
+  static const uint32_t len[] = {7200, 7200, 7200};
+  static const int8_t   dir[] = {1, 1, 1};
+  struct SRC_t          src = {len, dir, 3, 0};
+  struct GEN_STATUS_t   st;
+  TIM_TypeDef*          chk = axes[3].htim->Instance;
+  uint32_t              errors;
+  uint16_t              seg;
+  uint8_t               axis = 2, n;
+
+  HOST_reset();
+  GEN_status_get(axis, &st);
+  seg = st.seg;
+  errors = st.verify_errors;
+  chk->CNT = 0xFFFA;
+  CHECK_EQ(GEN_verify_set(axis, axis), GEN_ERR_AXIS);
+  CHECK_EQ(GEN_verify_set(axis, 3), GEN_OK);
+  CHECK_EQ(GEN_verify_set(1, 3), GEN_ERR_BUSY);
+  CHECK_EQ(GEN_move(3, 1, 10, 1000), GEN_ERR_BUSY);
+  CHECK_EQ(GEN_profile_set(3, SRC_source, &src), GEN_ERR_BUSY);
+
+  // the pulses are counted right, then one is lost
+  for ( n = 10; n >= 9; --n )
+  {
+    CHECK_EQ(GEN_steps_output(axis, 10, 10000), GEN_OK);
+    chk->CNT += n;
+    axes[axis].hdma->Instance->CNDTR = 0;
+    axes[axis].htim->Instance->CNT = axes[axis].htim->Instance->CCR1;
+    GEN_DMA_transfer_complete(axis);
+  }
+  GEN_status_get(axis, &st);
+  CHECK_EQ(st.seg, seg + 2);
+  CHECK_EQ(st.verify_seg, seg + 2);
+  CHECK_EQ(st.verify_diff, -1);
+  CHECK_EQ(st.verify_errors, errors + 1);
+
+  // the profile pulses are the played halves ones
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  GEN_profile_start(1 << axis);
+  chk->CNT += 4;
+  for ( n = 0; n < 8 && axes[axis].busy; ++n )
+  {
+    if ( n & 1 ) GEN_DMA_transfer_complete(axis);
+    else GEN_DMA_half_transfer(axis);
+    GEN_process();
+  }
+  CHECK_EQ(axes[axis].busy, 0);
+  GEN_status_get(axis, &st);
+  CHECK_EQ(st.seg, seg + 3);
+  CHECK_EQ(st.verify_seg, seg + 3);
+  CHECK_EQ(st.verify_diff, 1);
+  CHECK_EQ(st.verify_errors, errors + 2);
+
+  // the stopped output isn't checked
+  CHECK_EQ(GEN_steps_output(axis, 10, 10000), GEN_OK);
+  GEN_stop(axis);
+  GEN_status_get(axis, &st);
+  CHECK_EQ(st.verify_errors, errors + 2);
+
+  GEN_verify_off(axis);
+  CHECK_EQ(GEN_move(3, 1, 10, 1000), GEN_OK);
+  GEN_stop(3);
+}
+
+/*
+ * the interval over 32 bits is the prescaled chunks of the exact length
+ */
+static void test_long_interval(void)
+{
+  static const uint32_t len[] = {0xF0000000, 1000, 70000};
+  static const int8_t   dir[] = {1, 1, -1};
+  struct SRC_t          src = {len, dir, 3, 0};
+  uint32_t              i = 0;
+  uint8_t               axis = 2;
+
+  HOST_reset();
+  ovr_cur = 50;
+
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  CHECK_EQ(HOST_ring_interval(axis, &i), 0x1E0000000ULL);
+  CHECK_EQ(HOST_ring_interval(axis, &i), 2000);
+  // the step pulse of the prescaled period isn't shorter than the set one
+  CHECK(PRF_ring[axis][i][0] > 0);
+  CHECK_EQ(PRF_ring[axis][i][3], (profile[axis].pulse_ticks + PRF_ring[axis][i][0]) / (PRF_ring[axis][i][0] + 1));
+  CHECK_EQ(HOST_ring_interval(axis, &i), 140000);
+  CHECK_EQ(PRF_step[axis][i], -1);
+}
+
+/*
+ * the interval without a step is the idle time, the next step is after both intervals
+ */
+static void test_profile_wait(void)
+{
+  static const uint32_t len[] = {7200, 20000, 7200};
+  static const int8_t   dir[] = {1, 0, 1};
+  struct SRC_t          src = {len, dir, 3, 0};
+  uint32_t              i = 0, n = 0;
+  uint8_t               axis = 2;
+
+  HOST_reset();
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  CHECK_EQ(HOST_ring_interval(axis, &i), 7200);
+  CHECK_EQ(PRF_step[axis][i], 1);
+  CHECK_EQ(HOST_ring_interval(axis, &i), 27200);
+  CHECK_EQ(PRF_step[axis][i], 1);
+
+  for ( i = 0; i < PRF_RING_SIZE; ++i ) n += PRF_step[axis][i] != 0;
+  CHECK_EQ(n, 2);
+}
+
+/*
+ * the axis override steps keep the axis acceleration limit
+ */
+static void test_axis_override_slew(void)
+{
+  static const uint32_t len[] = {7200};
+  static const int8_t   dir[] = {1};
+  struct SRC_t          src = {len, dir, 1, 0};
+  struct LIMITS_t       lim = {0};
+  struct PRF_t*         prf = &profile[3];
+  uint16_t              p[4];
+  uint64_t              at = 0;
+  int8_t                step;
+  uint8_t               axis = 3;
+
+  HOST_reset();
+  axis_ovr_req[axis] = 100;
+  // 10 kHz, 5% is 500 Hz, 50 ms at 10000 steps/s^2
+  lim.accel = 10000;
+  GEN_limits_set(axis, &lim);
+
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  CHECK_EQ(GEN_axis_override_set(axis, 80), GEN_OK);
+
+  for ( uint32_t n = 0; n < 5000 && prf->axis_ovr != 80; ++n )
+  {
+    src.i = 0;
+    prf->end = 0;
+    prf->wait = 0;
+    GEN_profile_period(axis, p, &step);
+
+    // the step is at the fetch, the previous one was the gap earlier
+    if ( prf->axis_ovr_at != at )
+    {
+      if ( at ) CHECK(prf->src_time - 7200 >= at);
+      // 50 ms of the source time at the faster side of the step
+      CHECK_EQ(prf->axis_ovr_at - (prf->src_time - 7200), 3600000ULL * (prf->axis_ovr + 5) / 100);
+      at = prf->axis_ovr_at;
+    }
+  }
+
+  CHECK_EQ(prf->axis_ovr, 80);
+  // 4 steps, 3 gaps of 50 ms at 100%..85%
+  CHECK(prf->src_time >= 3600000ULL * (100 + 95 + 90) / 100);
+}
+
+/*
+ * the exact rate profile isn't scaled by the overrides, the request is for one profile
+ */
+static void test_exact_rate(void)
+{
+  static const uint32_t len[] = {100000, 100000};
+  static const int8_t   dir[] = {1, 1};
+  struct SRC_t          src = {len, dir, 2, 0};
+  uint32_t              i = 0;
+  uint8_t               axis = 2;
+
+  HOST_reset();
+  ovr_cur = 50;
+  axis_ovr_req[axis] = 30;
+
+  GEN_profile_exact_set(axis);
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  CHECK_EQ(HOST_ring_interval(axis, &i), 100000);
+  CHECK_EQ(HOST_ring_interval(axis, &i), 100000);
+
+  // the global override step doesn't wait for the exact output
+  ovr_req = 100;
+  profile[axis].on = 1;
+  GEN_override_process();
+  CHECK_EQ(profile[axis].ovr_pending, 0);
+  CHECK_EQ(ovr_cur, 50 + GEN_OVR_STEP);
+
+  profile[axis].on = 0;
+  axes[axis].busy = 0;
+  src.i = 0;
+  i = 0;
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  CHECK_EQ(profile[axis].exact, 0);
+  CHECK_EQ(HOST_ring_interval(axis, &i), 100000ULL * 10000 / (55 * 30));
+  axis_ovr_req[axis] = 100;
+}
+
+/*
+ * the shortest interval of the low max rate is over 16 bits,
+ * the reversal keeps it and the last chunk still fits the timer
+ */
+static void test_low_max_rate(void)
+{
+  static uint32_t       len[3];
+  static const int8_t   dir[] = {1, -1, -1};
+  struct SRC_t          src = {len, dir, 3, 0};
+  struct LIMITS_t       lim = {0};
+  uint32_t              i = 0, m;
+  uint8_t               axis = 1;
+
+  HOST_reset();
+  lim.freq_max = 100;
+  GEN_limits_set(axis, &lim);
+  m = axes[axis].tim_freq / 100;
+  CHECK(m > GEN_PRF_CHUNK_MAX);
+
+  // the reversal right at the shortest interval, the faster step is delayed
+  len[0] = 3*m;
+  len[1] = m;
+  len[2] = m / 2;
+
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  CHECK_EQ(profile[axis].min_ticks, m);
+  CHECK_EQ(HOST_ring_interval(axis, &i), 3ULL*m);
+  CHECK_EQ(HOST_ring_interval(axis, &i), (uint64_t)m + profile[axis].setup_ticks);
+  CHECK_EQ(PRF_step[axis][i], -1);
+  CHECK_EQ(HOST_ring_interval(axis, &i), m);
+}
+
+/*
+ * the profile clock keeps the clocks counter wraps of the long halves
+ */
+static void test_profile_clock(void)
+{
+  struct PRF_t* prf = &profile[0];
+  uint32_t      n;
+
+  HOST_reset();
+  prf->on = 1;
+  prf->runs = 1;
+  prf->clk = 0;
+  prf->cyc = 0;
+  DWT->CYCCNT = 0;
+
+  // the timer isn't started, the profile clock waits
+  axes[0].htim->Instance->CR1 = 0;
+  DWT->CYCCNT = 1000;
+  GEN_SYSTICK_IRQHandler();
+  CHECK_EQ(prf->clk, 0);
+
+  // 5 counter wraps at the SysTick rate
+  axes[0].htim->Instance->CR1 = TIM_CR1_CEN;
+  prf->cyc = DWT->CYCCNT;
+  for ( n = 0; n < 5 * 4295; ++n )
+  {
+    DWT->CYCCNT += SystemCoreClock / 1000;
+    GEN_SYSTICK_IRQHandler();
+  }
+  CHECK_EQ(prf->clk, 5ULL * 4295 * (SystemCoreClock / 1000));
+
+  prf->on = 0;
+  axes[0].htim->Instance->CR1 = 0;
+}
+
+/*
+ * the profile reversal takes up the backlash by the pulses out of the position,
+ * the stop keeps the played take-up, the CC4 request axis and the quadrature
+ * axis have read the next period at the stop already
+ */
+static void test_backlash_profile(void)
+{
+  static const uint32_t len[] = {7200, 7200, 7200, 7200};
+  static const int8_t   dir[] = {1, 1, -1, -1};
+  static const int8_t   exp[] = {1, 1, -PRF_LASH, -PRF_LASH, -PRF_LASH, -1, -1};
+  static const uint8_t  list[] = {2, 1, 2};
+  static const uint8_t  mode[] = {GEN_MODE_STEP_DIR, GEN_MODE_STEP_DIR, GEN_MODE_QUAD};
+  struct LIMITS_t       lim = {0};
+  struct SRC_t          src;
+  uint32_t              i, n, at[7], read;
+  uint8_t               k, axis;
+
+  for ( k = 0; k < sizeof(list); ++k )
+  {
+    axis = list[k];
+    src = (struct SRC_t){len, dir, 4, 0};
+    n = 0;
+
+    HOST_reset();
+    GEN_limits_set(axis, &lim);
+    CHECK_EQ(GEN_mode_set(axis, mode[k]), GEN_OK);
+    CHECK_EQ(GEN_backlash_set(axis, 3, 1000), GEN_OK);
+    CHECK_EQ(backlash[axis].slack, 3);
+
+    CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+    for ( i = 0; i < PRF_RING_SIZE; ++i )
+    {
+      if ( !PRF_step[axis][i] ) continue;
+      if ( n < 7 ) CHECK_EQ(PRF_step[axis][i], exp[n]);
+      if ( n < 7 ) at[n] = i;
+      ++n;
+    }
+    CHECK_EQ(n, 7);
+    CHECK_EQ(profile[axis].net[0], 0);
+    CHECK_EQ(profile[axis].slack[0], 0);
+
+    // the take-up pulses are at the take-up frequency
+    i = at[3];
+    CHECK_EQ(HOST_ring_interval(axis, &i), 72000);
+
+    // the stop after the 2nd take-up pulse, 1 step is left to engage
+    read = (axes[axis].htim->Instance->CR2 & TIM_CR2_CCDS ? at[4] : at[3]) + 1;
+    axes[axis].hdma->Instance->CNDTR = PRF_RING_SIZE*5 - read*5;
+    axes[axis].htim->Instance->CNT = 0;
+    axes[axis].htim->Instance->CCR1 = 1;
+    GEN_stop(axis);
+    CHECK_EQ(axes[axis].pos, 2);
+    CHECK_EQ(backlash[axis].slack, 1);
+    CHECK_EQ(GEN_backlash_need(axis, -1, backlash[axis].slack), 1);
+    CHECK_EQ(GEN_backlash_need(axis, 1, backlash[axis].slack), 2);
+    GEN_backlash_set(axis, 0, 0);
+    GEN_mode_set(axis, GEN_MODE_STEP_DIR);
+  }
+}
+
+/*
+ * the stop during the constant frequency take-up leaves the rest of it
+ */
+static void test_backlash_move(void)
+{
+  uint8_t axis = 2;
+
+  HOST_reset();
+  axes[axis].pos = 0;
+  CHECK_EQ(GEN_backlash_set(axis, 5, 1000), GEN_OK);
+
+  // the same direction has no take-up
+  CHECK_EQ(GEN_move(axis, 1, 10, 1000), GEN_OK);
+  CHECK_EQ(backlash[axis].comp, 0);
+  axes[axis].busy = 0;
+
+  CHECK_EQ(GEN_move(axis, -1, 10, 1000), GEN_OK);
+  CHECK_EQ(backlash[axis].comp, 1);
+  CHECK_EQ(axes[axis].steps, 5);
+
+  // 2 take-up steps are done
+  axes[axis].hdma->Instance->CNDTR = 3;
+  axes[axis].htim->Instance->CNT = 0;
+  axes[axis].htim->Instance->CCR1 = 0;
+  GEN_stop(axis);
+  CHECK_EQ(axes[axis].pos, 0);
+  CHECK_EQ(axes[axis].dir, -1);
+  CHECK_EQ(backlash[axis].slack, 3);
+
+  CHECK_EQ(GEN_move(axis, 1, 10, 1000), GEN_OK);
+  CHECK_EQ(axes[axis].steps, 2);
+}
+
+/*
+ * the quadrature steps are the Gray code of A and B, one edge per step
+ */
+static void test_quad_gray(void)
+{
+  static const uint32_t len[] = {5000, 5000, 5000, 5000, 5000, 9000, 5000, 5000, 5000, 70000};
+  static const int8_t   dir[] = {1, 1, 1, 1, 1, -1, -1, -1, 0, 1};
+  struct SRC_t          src = {len, dir, 10, 0};
+  uint16_t*             p;
+  uint32_t              i, n = 0, lash = 0;
+  uint8_t               a = 0, b = 0, q = 0, axis = 3;
+  int8_t                s;
+
+  HOST_reset();
+  CHECK_EQ(GEN_mode_set(axis, GEN_MODE_QUAD), GEN_OK);
+  CHECK_EQ(GEN_backlash_set(axis, 2, 1000), GEN_OK);
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+
+  for ( i = 0; i < PRF_RING_SIZE; ++i )
+  {
+    p = PRF_ring[axis][i];
+    s = PRF_step[axis][i];
+
+    // the step is one A or B edge, the other periods have no edges
+    CHECK_EQ((p[3] != 0xFFFF) + (p[4] != 0xFFFF), s != 0);
+    a ^= p[3] != 0xFFFF;
+    b ^= p[4] != 0xFFFF;
+    if ( !s ) continue;
+
+    // the states order of GEN_profile_finish(), A is the step output, B is the direction one,
+    // the take-up pulse is one step too
+    q = (q + (s > 0 ? 1 : -1)) & 3;
+    CHECK_EQ(b ? (a ? 2 : 3) : (a ? 1 : 0), q);
+    lash += !PRF_POS(s);
+    ++n;
+  }
+
+  // the first forward step and the reversal take up
+  CHECK_EQ(lash, 4);
+  CHECK_EQ(n, 9 + lash);
+  CHECK_EQ(axes[axis].quad_q, q);
+  CHECK_EQ(GEN_mode_set(axis, GEN_MODE_STEP_DIR), GEN_ERR_BUSY);
+  axes[axis].busy = 0;
+  profile[axis].on = 0;
+  GEN_backlash_set(axis, 0, 0);
+  CHECK_EQ(GEN_mode_set(axis, GEN_MODE_STEP_DIR), GEN_OK);
+}
+
+/*
+ * the CW/CCW forward pulses are at the channel 1, the backward ones at the channel 2
+ */
+static void test_cw_ccw_routing(void)
+{
+  static const uint32_t len[] = {5000, 5000, 9000, 5000, 70000, 5000};
+  static const int8_t   dir[] = {1, 1, -1, -1, 0, 1};
+  struct SRC_t          src = {len, dir, 6, 0};
+  TIM_TypeDef*          tim;
+  uint16_t*             p;
+  uint32_t              i, w, n = 0;
+  uint8_t               axis = 3;
+
+  HOST_reset();
+  tim = axes[axis].htim->Instance;
+  CHECK_EQ(GEN_mode_set(axis, GEN_MODE_CW_CCW), GEN_OK);
+
+  // the constant frequency output enables the channel of the move direction
+  CHECK_EQ(GEN_move(axis, -1, 10, 1000), GEN_OK);
+  CHECK_EQ(tim->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E), TIM_CCER_CC2E);
+  CHECK_EQ(tim->CCR2, tim->CCR1);
+  GEN_stop(axis);
+  CHECK_EQ(tim->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E), 0);
+
+  CHECK_EQ(GEN_move(axis, 1, 10, 1000), GEN_OK);
+  CHECK_EQ(tim->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E), TIM_CCER_CC1E);
+  GEN_stop(axis);
+
+  // the profile pulse is at the channel of its step, the prescaled pulse is rounded up
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  for ( i = 0; i < PRF_RING_SIZE; ++i )
+  {
+    p = PRF_ring[axis][i];
+    w = (PRF_step[axis][i] > 0 ? p[3] : p[4]) * (p[0] + 1U);
+
+    if ( PRF_step[axis][i] ) CHECK(w >= profile[axis].pulse_ticks && w <= profile[axis].pulse_ticks + p[0]);
+    if ( PRF_step[axis][i] > 0 ) CHECK(!p[4]);
+    else if ( PRF_step[axis][i] < 0 ) CHECK(!p[3]);
+    else CHECK(!p[3] && !p[4]);
+    n += PRF_step[axis][i] != 0;
+  }
+  CHECK_EQ(n, 5);
+
+  // both channels run the profile, both are off at its end
+  GEN_profile_start(1 << axis);
+  CHECK_EQ(tim->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E), TIM_CCER_CC1E | TIM_CCER_CC2E);
+  GEN_stop(axis);
+  CHECK_EQ(tim->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E), 0);
+  CHECK_EQ(GEN_mode_set(axis, GEN_MODE_STEP_DIR), GEN_OK);
+}
+
+/*
+ * the take-up frequency is inside the axis limits and the DMA bus share like the move one
+ */
+static void test_backlash_admission(void)
+{
+  static const uint32_t len[] = {5000, 5000};
+  static const int8_t   dir[] = {1, -1};
+  struct SRC_t          src = {len, dir, 2, 0};
+  struct LIMITS_t       lim = {0};
+  uint8_t               axis = 2;
+
+  HOST_reset();
+  axes[axis].pos = 0;
+  GEN_dir_set(axis, 1);
+  lim.freq_start = 2000;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_OK);
+  CHECK_EQ(GEN_backlash_set(axis, 5, 5000), GEN_ERR_FREQ);
+  CHECK_EQ(GEN_backlash_set(axis, 5, 1000), GEN_OK);
+
+  // the limits are lowered after the backlash setting
+  lim.freq_max = 800;
+  lim.freq_start = 0;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_OK);
+  CHECK_EQ(GEN_move(axis, 1, 10, 500), GEN_OK);
+  axes[axis].busy = 0;
+  CHECK_EQ(GEN_move(axis, -1, 10, 500), GEN_ERR_FREQ);
+  CHECK_EQ(axes[axis].busy, 0);
+
+  // the running axis 0 output leaves the DMA bus share of 500 transfers/s,
+  // the move fits it, the take-up doesn't
+  lim.freq_max = 0;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_OK);
+  axes[0].busy = 1;
+  axes[0].rate = GEN_dma_budget() - 500;
+  CHECK_EQ(GEN_move(axis, -1, 10, 100), GEN_ERR_BUS);
+  CHECK_EQ(axes[axis].busy, 0);
+
+  // the profile take-up pulses are throttled like the steps
+  CHECK_EQ(GEN_backlash_set(axis, 5, 5000), GEN_OK);
+  axes[0].rate = GEN_dma_budget() - 5 * 2000;
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_OK);
+  CHECK(profile[axis].min_ticks >= axes[axis].tim_freq / 2000);
+  CHECK(profile[axis].lash_ticks >= profile[axis].min_ticks);
+
+  axes[0].busy = 0;
+  axes[axis].busy = 0;
+  profile[axis].on = 0;
+  CHECK_EQ(GEN_backlash_set(axis, 0, 0), GEN_OK);
+}
+
+/*
+ * the running outputs load is the rate * transfers * cost, the profile
+ * without the DMA bus share left isn't started
+ */
+static void test_dma_load(void)
+{
+  static const uint32_t len[] = {5000, 5000};
+  static const int8_t   dir[] = {1, 1};
+  struct SRC_t          src = {len, dir, 2, 0};
+  struct GEN_STATUS_t   st;
+  uint8_t               axis = 3;
+
+  HOST_reset();
+  axes[1].dma_clk = 36;
+  CHECK_EQ(GEN_steps_output(1, 10, 100000), GEN_OK);
+  GEN_status_get(axis, &st);
+  CHECK_EQ(st.dma_load, 5);
+
+  // the profile period is the 5 transfers burst at the max rate
+  axes[2].dma_clk = 18;
+  axes[2].busy = 1;
+  axes[2].rate = 80000;
+  profile[2].on = 1;
+  GEN_status_get(axis, &st);
+  CHECK_EQ(st.dma_load, 15);
+
+  // no share is left, then the running outputs are over the share
+  axes[0].busy = 1;
+  axes[0].rate = GEN_dma_budget() - 100000 * 36 - 80000 * 5 * 18;
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_ERR_BUS);
+  CHECK_EQ(axes[axis].busy, 0);
+  CHECK_EQ(GEN_move_check(axis, 1, 10, 1), GEN_ERR_BUS);
+  axes[0].rate += 1000;
+  src.i = 0;
+  CHECK_EQ(GEN_profile_set(axis, SRC_source, &src), GEN_ERR_BUS);
+
+  axes[0].busy = 0;
+  profile[2].on = 0;
+  axes[2].busy = 0;
+  GEN_stop(1);
+}
+
+
+
+
+int main(void)
+{
+  test_pulse_width();
+  test_warp();
+  test_dma_request();
+  test_dma_priorities();
+  test_late_stop();
+  test_verify();
+  test_long_interval();
+  test_profile_wait();
+  test_profile_runs();
+  test_profile_runs_stop();
+  test_profile_clock();
+  test_axis_override_slew();
+  test_exact_rate();
+  test_limits();
+  test_low_max_rate();
+  test_backlash_profile();
+  test_backlash_move();
+  test_quad_gray();
+  test_cw_ccw_routing();
+  test_backlash_admission();
+  test_dma_load();
+
+  return HOST_RESULT();
+}
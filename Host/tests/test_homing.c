@@ -0,0 +1,149 @@
+/**
+  ******************************************************************************
+  * File Name          : test_homing.c
+  * Description        : axes homing host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "fw_host.h"
+#include "../../Src/generator.c"
+#include "../../Src/homing.c"
+
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+/*
+ * generator state of the test start, the home switches are released
+ */
+static void HOST_reset(void)
+{
+  GEN_init();
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    axes[axis].busy = 0;
+    axes[axis].pos = 0;
+    homes[axis].state = HOME_IDLE;
+    homes[axis].out = 0;
+    homes[axis].port->IDR |= homes[axis].pin;
+  }
+}
+
+/*
+ * the home switch input of the axis
+ */
+static void HOST_switch(uint8_t axis, uint8_t pressed)
+{
+  if ( pressed ) homes[axis].port->IDR &= ~homes[axis].pin;
+  else homes[axis].port->IDR |= homes[axis].pin;
+}
+
+/*
+ * the axis output is done, all steps are made
+ */
+static void HOST_complete(uint8_t axis)
+{
+  axes[axis].hdma->Instance->CNDTR = 0;
+  GEN_DMA_transfer_complete(axis);
+}
+
+/*
+ * steps of the output in progress are done and the next pulse isn't started
+ */
+static void HOST_done(uint8_t axis, uint32_t steps)
+{
+  axes[axis].hdma->Instance->CNDTR = axes[axis].steps - steps;
+  axes[axis].htim->Instance->CNT = axes[axis].htim->Instance->CCR1;
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * fast seek -> back-off -> slow seek -> the position is set at the switch edge
+ */
+static void test_home_cycle(void)
+{
+  uint8_t axis = 1;
+
+  HOST_reset();
+  CHECK_EQ(HOME_config(axis, 1, 10000, 1000, 50, 100000, 500), GEN_OK);
+  CHECK_EQ(HOME_start(axis), GEN_OK);
+  CHECK_EQ(HOME_state(axis), HOME_SEEK_FAST);
+
+  // the long seek is the bursts of the DMA array size
+  HOST_complete(axis);
+  CHECK_EQ(HOME_state(axis), HOME_SEEK_FAST);
+  CHECK_EQ(axes[axis].busy, 1);
+  CHECK_EQ(GEN_position_get(axis), GEN_DMA_ARRAY_SIZE);
+
+  HOST_done(axis, 100);
+  HOST_switch(axis, 1);
+  HOME_EXTI_IRQHandler(axis);
+  CHECK_EQ(HOME_state(axis), HOME_BACKOFF);
+  CHECK_EQ(axes[axis].dir, -1);
+  CHECK_EQ(axes[axis].steps, 50);
+
+  HOST_switch(axis, 0);
+  HOST_complete(axis);
+  CHECK_EQ(HOME_state(axis), HOME_SEEK_SLOW);
+  CHECK_EQ(axes[axis].dir, 1);
+
+  HOST_done(axis, 60);
+  HOST_switch(axis, 1);
+  HOME_EXTI_IRQHandler(axis);
+  CHECK_EQ(HOME_state(axis), HOME_DONE);
+  CHECK_EQ(axes[axis].busy, 0);
+  CHECK_EQ(homes[axis].latch, GEN_DMA_ARRAY_SIZE + 100 - 50 + 60);
+  CHECK_EQ(GEN_position_get(axis), 500);
+}
+
+/*
+ * the stopped cycle doesn't continue at the next move end or at the switch edge
+ */
+static void test_home_stop(void)
+{
+  uint8_t axis = 2;
+
+  HOST_reset();
+  CHECK_EQ(HOME_config(axis, 1, 10000, 1000, 50, 100000, 500), GEN_OK);
+  CHECK_EQ(HOME_start(axis), GEN_OK);
+  HOST_done(axis, 10);
+  GEN_stop(axis);
+  CHECK_EQ(HOME_state(axis), HOME_IDLE);
+  CHECK_EQ(GEN_position_get(axis), 10);
+
+  CHECK_EQ(GEN_move(axis, 1, 20, 1000), GEN_OK);
+  HOST_complete(axis);
+  CHECK_EQ(axes[axis].busy, 0);
+  CHECK_EQ(GEN_position_get(axis), 30);
+
+  CHECK_EQ(GEN_move(axis, 1, 20, 1000), GEN_OK);
+  HOST_done(axis, 5);
+  HOST_switch(axis, 1);
+  HOME_EXTI_IRQHandler(axis);
+  CHECK_EQ(axes[axis].busy, 1);
+  CHECK_EQ(GEN_position_get(axis), 35);
+  HOST_complete(axis);
+  CHECK_EQ(GEN_position_get(axis), 50);
+  CHECK_EQ(HOME_state(axis), HOME_IDLE);
+}
+
+
+
+
+int main(void)
+{
+  test_home_cycle();
+  test_home_stop();
+
+  return HOST_RESULT();
+}
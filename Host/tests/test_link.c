@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * File Name          : test_link.c
+  * Description        : host link commands host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "fw_host.h"
+
+SPI_HandleTypeDef hspi1;
+SPI_HandleTypeDef hspi2;
+
+// the link DMA channels
+static DMA_Channel_TypeDef  host_link_dma[2];
+
+#include "generator.h"
+#include "link.h"
+#undef LINK_DMA_RX
+#define LINK_DMA_RX (&host_link_dma[0])
+#undef LINK_DMA_TX
+#define LINK_DMA_TX (&host_link_dma[1])
+
+#include "../../Src/generator.c"
+#include "../../Src/stream.c"
+#include "../../Src/ramp.c"
+#include "../../Src/ramp_tables.c"
+#include "../../Src/slow.c"
+#include "../../Src/arc.c"
+#include "../../Src/pvt.c"
+#include "../../Src/homing.c"
+#include "../../Src/follow.c"
+#include "../../Src/telemetry.c"
+#include "../../Src/link.c"
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+// the command payload length, see LINK_CMD_t
+struct HOST_CMD_t
+{
+  uint8_t             cmd;
+  uint8_t             len;
+};
+
+/*
+ * execute the command, returns its result of the status
+ */
+static uint8_t HOST_command(uint8_t cmd, const uint8_t* data, uint8_t len)
+{
+  uint8_t cmds = done & 0xFF;
+
+  CHECK_EQ(LINK_command(cmd, data, len), 1);
+  CHECK_EQ(done & 0xFF, (cmds + 1) & 0xFF);
+
+  return done >> 8;
+}
+
+/*
+ * the master's bytes are written to the receive ring by the circular DMA
+ */
+static void HOST_rx(const uint8_t* data, uint16_t len)
+{
+  for ( uint16_t i = 0; i < len; ++i )
+  {
+    if ( !LINK_DMA_RX->CNDTR ) LINK_DMA_RX->CNDTR = LINK_RX_SIZE;
+    rx[LINK_RX_SIZE - LINK_DMA_RX->CNDTR] = data[i];
+    --LINK_DMA_RX->CNDTR;
+  }
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * the short payload is rejected, the full one is executed
+ */
+static void test_link_payload(void)
+{
+  static const struct HOST_CMD_t cmds[] =
+  {
+    {LINK_CMD_STREAM, 1}, {LINK_CMD_STREAM_START, 1}, {LINK_CMD_STOP, 1}, {LINK_CMD_MOVE, 10},
+    {LINK_CMD_PULSE_WIDTH, 5}, {LINK_CMD_GEAR, 6}, {LINK_CMD_HOME_CONFIG, 20}, {LINK_CMD_HOME_START, 1},
+    {LINK_CMD_LIMITS, 22}, {LINK_CMD_BACKLASH, 7}, {LINK_CMD_ARC, 28}, {LINK_CMD_PVT_ADD, 13},
+    {LINK_CMD_PVT_START, 1}, {LINK_CMD_OVERRIDE, 3}, {LINK_CMD_RAMP, 11},
+    {LINK_CMD_RAMP_ACCEL, 18}, {LINK_CMD_TLM_RATE, 2}, {LINK_CMD_PVT_END, 1},
+    {LINK_CMD_SLOW, 14}, {LINK_CMD_VERIFY, 2}, {LINK_CMD_MODE, 2},
+    {LINK_CMD_FOLLOW, 11}, {LINK_CMD_FOLLOW_STOP, 1}
+  };
+  static const uint8_t data[32] = {0};
+  uint8_t              i, err;
+
+  for ( i = 0; i < sizeof(cmds) / sizeof(cmds[0]); ++i )
+  {
+    // the commands are numbered in the order
+    CHECK_EQ(cmds[i].cmd, LINK_CMD_STREAM + i);
+
+    if ( cmds[i].len )
+    {
+      err = HOST_command(cmds[i].cmd, data, cmds[i].len - 1);
+      if ( err != LINK_ERR_CMD ) printf("  at the command %u\n", cmds[i].cmd);
+      CHECK_EQ(err, LINK_ERR_CMD);
+    }
+
+    err = HOST_command(cmds[i].cmd, data, cmds[i].len);
+    if ( err == LINK_ERR_CMD ) printf("  at the command %u\n", cmds[i].cmd);
+    CHECK(err != LINK_ERR_CMD);
+  }
+
+  CHECK_EQ(HOST_command(LINK_CMD_FOLLOW_STOP + 1, data, sizeof(data)), LINK_ERR_CMD);
+  CHECK_EQ(HOST_command(0, data, sizeof(data)), LINK_ERR_CMD);
+}
+
+/*
+ * the axis out of the range is the GEN_ERR_AXIS result of every axis command
+ */
+static void test_link_axis(void)
+{
+  static const uint8_t cmds[] =
+  {
+    LINK_CMD_MOVE, LINK_CMD_PULSE_WIDTH, LINK_CMD_GEAR, LINK_CMD_HOME_CONFIG, LINK_CMD_HOME_START,
+    LINK_CMD_LIMITS, LINK_CMD_BACKLASH, LINK_CMD_PVT_ADD, LINK_CMD_OVERRIDE, LINK_CMD_RAMP,
+    LINK_CMD_RAMP_ACCEL, LINK_CMD_SLOW, LINK_CMD_VERIFY,
+    LINK_CMD_MODE, LINK_CMD_FOLLOW, LINK_CMD_FOLLOW_STOP
+  };
+  uint8_t              data[32] = {0};
+  uint8_t              err;
+
+  data[0] = GEN_AXIS_CNT;
+  for ( uint8_t i = 0; i < sizeof(cmds); ++i )
+  {
+    err = HOST_command(cmds[i], data, sizeof(data));
+    if ( err != GEN_ERR_AXIS ) printf("  at the command %u\n", cmds[i]);
+    CHECK_EQ(err, GEN_ERR_AXIS);
+  }
+
+  CHECK_EQ(HOST_command(LINK_CMD_STOP, data, 1), GEN_ERR_AXIS);
+  data[0] = GEN_AXIS_NONE;
+  CHECK_EQ(HOST_command(LINK_CMD_STOP, data, 1), GEN_OK);
+}
+
+/*
+ * the padding and the wrong frames are skipped, the status frame has
+ * the parsed bytes, the stream FIFOs space and the executed commands
+ */
+static void test_link_status(void)
+{
+  static const uint8_t  data[] =
+  {
+    0x00, 0x00, // padding
+    LINK_SYNC, LINK_CMD_STOP, 1, GEN_AXIS_NONE, 0x00, // wrong sum
+    LINK_SYNC, LINK_CMD_STOP, 1, GEN_AXIS_NONE, LINK_CMD_STOP ^ 1 ^ GEN_AXIS_NONE,
+    LINK_SYNC, 0xEE, 0, 0xEE // unknown command
+  };
+  struct LINK_STATUS_t  st;
+  uint8_t               cmds = done & 0xFF;
+  uint16_t              p = parsed;
+  uint8_t               sum = 0;
+  uint8_t               i;
+
+  HOST_rx(data, sizeof(data));
+  LINK_process();
+  CHECK_EQ((uint16_t)(parsed - p), sizeof(data));
+  CHECK_EQ(rx_head, (LINK_RX_SIZE - LINK_DMA_RX->CNDTR) & LINK_MASK);
+
+  // the 1st half is sent, its frame is updated
+  DMA1->ISR = LINK_DMA_TX_HT;
+  LINK_DMA_IRQHandler();
+  memcpy(&st, &tx[0][1], sizeof(st));
+  for ( i = 1; i < LINK_FRAME_SIZE; ++i ) sum ^= tx[0][i];
+
+  CHECK_EQ(tx[0][0], LINK_SYNC);
+  CHECK_EQ(sum, 0);
+  CHECK_EQ(st.parsed, parsed);
+  for ( i = 0; i < GEN_AXIS_CNT; ++i ) CHECK_EQ(st.stream_free[i], STR_free(i));
+  CHECK_EQ(st.cmds, (uint8_t)(cmds + 2));
+  CHECK_EQ(st.result, LINK_ERR_CMD);
+}
+
+
+
+
+int main(void)
+{
+  GEN_init();
+
+  test_link_payload();
+  test_link_axis();
+  test_link_status();
+
+  return HOST_RESULT();
+}
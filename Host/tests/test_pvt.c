@@ -0,0 +1,254 @@
+/**
+  ******************************************************************************
+  * File Name          : test_pvt.c
+  * Description        : position-velocity-time segments host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include <math.h>
+
+#include "fw_host.h"
+#include "../../Src/generator.c"
+#include "../../Src/pvt.c"
+
+void HOME_output_complete(uint8_t axis) { (void)axis; }
+void HOME_abort(uint8_t axis) { (void)axis; }
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+/*
+ * generator state of the test start
+ */
+static void HOST_reset(void)
+{
+  GEN_init();
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    profile[axis].on = 0;
+    profile[axis].low = 0;
+    axes[axis].busy = 0;
+    // the host DMA calibration has no clocks counter
+    axes[axis].dma_clk = 1;
+    axes[axis].pos = 0;
+    memset(&pvts[axis], 0, sizeof(pvts[axis]));
+  }
+  ovr_cur = 100;
+  ovr_req = 100;
+}
+
+/*
+ * PVT motion state of the start without the profile output, like PVT_start() sets it
+ */
+static struct PVT_t* HOST_pvt(uint8_t axis, uint8_t open)
+{
+  struct PVT_t* pvt = &pvts[axis];
+
+  pvt->p0 = 0;
+  pvt->v0 = 0;
+  pvt->active = 0;
+  pvt->start = 0;
+  pvt->last = 0;
+  pvt->on = 1;
+  pvt->open = open;
+
+  return pvt;
+}
+
+/*
+ * Hermite cubic position of the segment, steps
+ */
+static double HOST_hermite(double p0, double v0, double p1, double v1, double T, double t)
+{
+  double u = t / T, D = p1 - p0, V0 = v0 * T, V1 = v1 * T;
+
+  return p0 + V0*u + (3*D - 2*V0 - V1)*u*u + (V0 + V1 - 2*D)*u*u*u;
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * the steps are at the integer positions crossings of the cubic
+ */
+static void test_pvt_interpolation(void)
+{
+  struct PVT_t* pvt;
+  double        T = 0.1, f = 72000000, p, prev;
+  uint64_t      t = 0;
+  uint32_t      len, n = 0;
+  int8_t        dir;
+  uint8_t       axis = 1;
+
+  HOST_reset();
+  CHECK_EQ(PVT_add(axis, 100, 2000, 100000), GEN_OK);
+  pvt = HOST_pvt(axis, 0);
+
+  while ( (len = PVT_source(pvt, &dir)) )
+  {
+    t += len;
+    ++n;
+
+    // the step is at the crossing tick, the positions are 24.8 fixed point
+    p = HOST_hermite(0, 0, 100, 2000, T, t / f);
+    prev = HOST_hermite(0, 0, 100, 2000, T, (t - 1) / f);
+    if ( dir != 1 || p < n - 2/256.0 || prev >= n + 2/256.0 )
+    {
+      CHECK_EQ(dir, 1);
+      CHECK(p >= n - 2/256.0 && prev < n + 2/256.0);
+      printf("  at the step %u\n", n);
+      return;
+    }
+  }
+
+  CHECK_EQ(n, 100);
+  CHECK(fabs((double)t - T*f) <= T*f / 100);
+  CHECK_EQ(pvt->on, 0);
+}
+
+/*
+ * the velocity reversal inside the segment, the steps go back
+ */
+static void test_pvt_reversal(void)
+{
+  struct PVT_t* pvt;
+  uint32_t      fwd = 0, back = 0;
+  int32_t       pos = 0;
+  int8_t        dir, last = 1;
+  uint8_t       turns = 0;
+  uint8_t       axis = 1;
+
+  HOST_reset();
+  // the start velocity is forward, the end is behind the start
+  CHECK_EQ(PVT_add(axis, 50, 1000, 50000), GEN_OK);
+  CHECK_EQ(PVT_add(axis, 20, -500, 100000), GEN_OK);
+  CHECK_EQ(PVT_add(axis, 20, 0, 20000), GEN_OK);
+  pvt = HOST_pvt(axis, 0);
+
+  while ( PVT_source(pvt, &dir) )
+  {
+    pos += dir;
+    if ( dir > 0 ) ++fwd;
+    else ++back;
+    turns += dir != last;
+    last = dir;
+  }
+
+  CHECK_EQ(pos, 20);
+  CHECK(fwd > 50 && back >= 30);
+  CHECK_EQ(turns, 2);
+}
+
+/*
+ * the open motion waits for the segments at the empty queue and slows down
+ * the outputs, it ends after PVT_end()
+ */
+static void test_pvt_open(void)
+{
+  struct PVT_t* pvt;
+  uint32_t      len, n = 0;
+  int8_t        dir;
+  uint8_t       axis = 3;
+
+  HOST_reset();
+  profile[axis].on = 1;
+  CHECK_EQ(PVT_add(axis, 3, 0, 10000), GEN_OK);
+  pvt = HOST_pvt(axis, 1);
+
+  while ( (len = PVT_source(pvt, &dir)) != GEN_PRF_WAIT ) n += len != 0;
+  CHECK_EQ(n, 3);
+  CHECK_EQ(profile[axis].low, 1);
+  CHECK_EQ(pvt->on, 1);
+
+  CHECK_EQ(PVT_add(axis, 5, 0, 10000), GEN_OK);
+  CHECK_EQ(PVT_add(axis, 6, 0, 10000), GEN_OK);
+  len = PVT_source(pvt, &dir);
+  CHECK(len && len != GEN_PRF_WAIT);
+  CHECK_EQ(profile[axis].low, 0);
+
+  CHECK_EQ(PVT_end(1 << axis), GEN_OK);
+  // the ended motion takes no segments
+  CHECK_EQ(PVT_add(axis, 7, 0, 10000), GEN_ERR_BUSY);
+
+  for ( n = 1; (len = PVT_source(pvt, &dir)); ++n ) CHECK(len != GEN_PRF_WAIT);
+  CHECK_EQ(n, 3);
+  CHECK_EQ(pvt->on, 0);
+}
+
+/*
+ * the override steps of the axis are played
+ */
+static void HOST_override_pass(void)
+{
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( !profile[axis].ovr_pending ) continue;
+    profile[axis].ovr = profile[axis].ovr_next;
+    profile[axis].ovr_pending = 0;
+  }
+}
+
+/*
+ * the starving open PVT motion slows down its own outputs only,
+ * the ended motion isn't starving at its last segment
+ */
+static void test_pvt_starve_group(void)
+{
+  struct PVT_t* pvt;
+  int8_t        dir;
+  uint8_t       axis = 3, other = 1;
+
+  HOST_reset();
+  // the independent profile axis is the closed PVT motion
+  CHECK_EQ(PVT_add(other, 2000, 0, 1000000), GEN_OK);
+  CHECK_EQ(GEN_profile_set(other, PVT_source, HOST_pvt(other, 0)), GEN_OK);
+  CHECK_EQ(PVT_add(axis, 10, 0, 10000), GEN_OK);
+  pvt = HOST_pvt(axis, 1);
+  CHECK_EQ(GEN_profile_set(axis, PVT_source, pvt), GEN_OK);
+  CHECK_EQ(profile[axis].low, 1);
+  CHECK_EQ(profile[other].low, 0);
+
+  for ( uint8_t i = 0; i < 100; ++i )
+  {
+    GEN_override_process();
+    HOST_override_pass();
+  }
+  CHECK_EQ(profile[axis].ovr, GEN_OVR_MIN);
+  CHECK_EQ(profile[other].ovr, 100);
+
+  // the ended motion plays its last segment at the full speed
+  CHECK_EQ(PVT_end(1 << axis), GEN_OK);
+  CHECK(PVT_source(pvt, &dir) != GEN_PRF_WAIT);
+  CHECK_EQ(profile[axis].low, 0);
+  for ( uint8_t i = 0; i < 100; ++i )
+  {
+    GEN_override_process();
+    HOST_override_pass();
+  }
+  CHECK_EQ(profile[axis].ovr, 100);
+  CHECK_EQ(profile[other].ovr, 100);
+
+  axes[axis].busy = 0;
+  axes[other].busy = 0;
+}
+
+
+
+
+int main(void)
+{
+  test_pvt_interpolation();
+  test_pvt_reversal();
+  test_pvt_open();
+  test_pvt_starve_group();
+
+  return HOST_RESULT();
+}
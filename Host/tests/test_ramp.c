@@ -0,0 +1,198 @@
+/**
+  ******************************************************************************
+  * File Name          : test_ramp.c
+  * Description        : acceleration ramps host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include <math.h>
+
+#include "fw_host.h"
+#include "../../Src/generator.c"
+#include "../../Src/ramp.c"
+#include "../../Src/ramp_tables.c"
+
+void HOME_output_complete(uint8_t axis) { (void)axis; }
+void HOME_abort(uint8_t axis) { (void)axis; }
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+/*
+ * generator state of the test start
+ */
+static void HOST_reset(void)
+{
+  struct LIMITS_t lim = {0};
+
+  GEN_init();
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    profile[axis].on = 0;
+    axes[axis].busy = 0;
+    // the host DMA calibration has no clocks counter
+    axes[axis].dma_clk = 1;
+    GEN_limits_set(axis, &lim);
+    ramps[axis].table = 0;
+  }
+  ovr_cur = 100;
+  ovr_req = 100;
+}
+
+/*
+ * the ramp steps are at t = (sqrt(v0^2 + 2*a*k) - v0) / a, the intervals
+ * are the differences of the rounded times, so the sum doesn't drift
+ */
+static void HOST_ramp_check(const struct RAMP_TABLE_t* tab, uint32_t freq_start)
+{
+  uint64_t  sum = 0;
+  double    t, v0 = freq_start;
+
+  for ( uint32_t k = 0; k < tab->size; ++k )
+  {
+    sum += tab->ticks[k];
+    t = (sqrt(v0*v0 + 2.0*tab->accel*(k + 1)) - v0) / tab->accel * RAMP_TIM_FREQ;
+    if ( fabs((double)sum - t) > 2 )
+    {
+      CHECK(fabs((double)sum - t) <= 2);
+      printf("  at the step %u\n", k);
+      return;
+    }
+
+    if ( k ) CHECK(tab->ticks[k] <= tab->ticks[k - 1]);
+  }
+
+  // the ramp ends at the max frequency
+  CHECK(tab->ticks[tab->size - 1] >= RAMP_TIM_FREQ / tab->freq_max);
+  CHECK(tab->ticks[tab->size - 1] <= RAMP_TIM_FREQ / tab->freq_max * 102 / 100);
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * the flash tables are the constant acceleration ramps from zero
+ */
+static void test_ramp_tables(void)
+{
+  for ( uint8_t i = 0; i < RAMP_TABLE_CNT; ++i ) HOST_ramp_check(&RAMP_tables[i], 0);
+}
+
+/*
+ * the move accelerates by the table, cruises and decelerates by the table backwards,
+ * the short move peaks in the middle
+ */
+static void test_ramp_move(void)
+{
+  const struct RAMP_TABLE_t* tab = &RAMP_tables[0];
+  struct RAMP_t*  r;
+  uint32_t        len, exp, cruise, i, n = 0;
+  uint8_t         axis = 1;
+  int8_t          dir;
+
+  HOST_reset();
+  r = &ramps[axis];
+  cruise = RAMP_TIM_FREQ / (tab->freq_max / 2);
+
+  CHECK_EQ(RAMP_move(axis, -1, 2*tab->size, 0, tab->freq_max / 2), GEN_OK);
+  CHECK(r->acc > 0 && r->acc < tab->size);
+  CHECK(tab->ticks[r->acc] <= cruise && tab->ticks[r->acc - 1] > cruise);
+
+  // the source is rewound, the ring holds the first intervals already
+  r->step = 0;
+  while ( (len = RAMP_source(r, &dir)) != 0 )
+  {
+    i = n++;
+    if ( i < r->acc ) exp = tab->ticks[i];
+    else if ( i < r->steps - r->acc ) exp = cruise;
+    else exp = tab->ticks[r->steps - 1 - i];
+
+    if ( len != exp || dir != -1 )
+    {
+      CHECK_EQ(len, exp);
+      CHECK_EQ(dir, -1);
+      printf("  at the step %u\n", i);
+      return;
+    }
+  }
+  CHECK_EQ(n, 2*tab->size);
+  GEN_stop(axis);
+
+  HOST_reset();
+  CHECK_EQ(RAMP_move(axis, 1, 9, 0, tab->freq_max), GEN_OK);
+  CHECK_EQ(r->acc, 4);
+  CHECK_EQ(r->cruise, tab->ticks[4]);
+  GEN_stop(axis);
+
+  CHECK_EQ(RAMP_move(axis, 1, 9, RAMP_TABLE_CNT, tab->freq_max), GEN_ERR_STEPS);
+  CHECK_EQ(RAMP_move(axis, 1, 9, 0, tab->freq_max + 1), GEN_ERR_FREQ);
+}
+
+/*
+ * the computed ramps are the same constant acceleration from the start frequency
+ */
+static void test_ramp_cache(void)
+{
+  const struct RAMP_TABLE_t* tab;
+
+  tab = RAMP_cache_get(30000, 500, 3000);
+  CHECK(tab != 0);
+  if ( tab ) HOST_ramp_check(tab, 500);
+
+  // the hit is the same entry
+  CHECK(RAMP_cache_get(30000, 500, 3000) == tab);
+  CHECK_EQ(RAMP_cache_stat()->hits, 1);
+}
+
+/*
+ * the ramp is inside the axis limits, the full cache is busy
+ */
+static void test_ramp_limits(void)
+{
+  struct LIMITS_t lim = {0};
+  uint8_t         axis = 2;
+
+  HOST_reset();
+  lim.freq_max = 5000;
+  lim.accel = 40000;
+  lim.freq_start = 400;
+  CHECK_EQ(GEN_limits_set(axis, &lim), GEN_OK);
+
+  CHECK_EQ(RAMP_move_accel(axis, 1, 1000, 40000, 0, 6000), GEN_ERR_FREQ);
+  CHECK_EQ(RAMP_move_accel(axis, 1, 1000, 50000, 0, 4000), GEN_ERR_FREQ);
+  CHECK_EQ(RAMP_move_accel(axis, 1, 1000, 40000, 500, 4000), GEN_ERR_FREQ);
+  CHECK_EQ(RAMP_move(axis, 1, 1000, 1, 4000), GEN_ERR_FREQ);
+  // the ramp over the cache entry
+  CHECK_EQ(RAMP_move_accel(axis, 1, 1000, 1000, 0, 5000), GEN_ERR_FREQ);
+
+  // all entries are the ramps of the running moves
+  for ( uint8_t i = 0; i < RAMP_CACHE_CNT; ++i )
+  {
+    CHECK_EQ(RAMP_move_accel(i, 1, 1000, 30000 + i, 300, 3000), GEN_OK);
+    CHECK(GEN_busy(i));
+  }
+  CHECK_EQ(RAMP_move_accel(axis, 1, 1000, 40000, 300, 4000), GEN_ERR_BUSY);
+}
+
+
+
+
+int main(void)
+{
+  HOST_reset();
+
+  test_ramp_tables();
+  test_ramp_move();
+  test_ramp_cache();
+  test_ramp_limits();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,153 @@
+/**
+  ******************************************************************************
+  * File Name          : test_slow.c
+  * Description        : low speed moves host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "fw_host.h"
+#include "../../Src/generator.c"
+#include "../../Src/slow.c"
+
+void HOME_output_complete(uint8_t axis) { (void)axis; }
+void HOME_abort(uint8_t axis) { (void)axis; }
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+/*
+ * generator state of the test start
+ */
+static void HOST_reset(void)
+{
+  struct LIMITS_t lim = {0};
+
+  GEN_init();
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    profile[axis].on = 0;
+    axes[axis].busy = 0;
+    // the host DMA calibration has no clocks counter
+    axes[axis].dma_clk = 1;
+    axes[axis].pos = 0;
+    GEN_limits_set(axis, &lim);
+  }
+  ovr_cur = 100;
+  ovr_req = 100;
+}
+
+/*
+ * the source of the rate num/den, the move isn't started
+ */
+static struct SLOW_t* HOST_slow(uint8_t axis, uint32_t steps, uint32_t num, uint32_t den)
+{
+  struct SLOW_t* s = &slows[axis];
+  uint64_t       period = (uint64_t)GEN_tim_freq_get(axis) * den;
+
+  memset(s, 0, sizeof(*s));
+  s->dir = 1;
+  s->steps = steps;
+  s->num = num;
+  s->ticks = period / num;
+  s->frac = period % num;
+
+  return s;
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * the step k is at floor(k * tim_freq * den / num) ticks, the rounding doesn't drift
+ */
+static void test_slow_exact(void)
+{
+  struct SLOW_t*  s = HOST_slow(1, 1000, 7, 3);
+  uint64_t        t = 0, period = (uint64_t)GEN_tim_freq_get(1) * 3;
+  uint32_t        k, len;
+  int8_t          dir;
+
+  for ( k = 1; k <= 1000; ++k )
+  {
+    dir = 0;
+    len = SLOW_source(s, &dir);
+    t += len;
+    if ( t != k * period / 7 || dir != 1 )
+    {
+      CHECK_EQ(t, k * period / 7);
+      CHECK_EQ(dir, 1);
+      printf("  at the step %u\n", k);
+      return;
+    }
+  }
+
+  CHECK_EQ(SLOW_source(s, &dir), 0);
+}
+
+/*
+ * the step an hour is the waits of SLOW_WAIT_MAX ticks and the rest of the hour
+ */
+static void test_slow_wait(void)
+{
+  struct SLOW_t*  s = HOST_slow(2, 2, 1, 3600);
+  uint64_t        t = 0, period = (uint64_t)GEN_tim_freq_get(2) * 3600;
+  uint32_t        len, waits = 0, steps = 0;
+  int8_t          dir;
+
+  while ( (len = SLOW_source(s, &dir)) != 0 )
+  {
+    CHECK(len <= SLOW_WAIT_MAX);
+    t += len;
+    if ( dir ) ++steps;
+    else ++waits;
+  }
+
+  CHECK_EQ(t, 2 * period);
+  CHECK_EQ(steps, 2);
+  CHECK_EQ(waits, 2 * (period / SLOW_WAIT_MAX));
+}
+
+/*
+ * the move arguments are checked, the started move isn't scaled by the overrides
+ */
+static void test_slow_move(void)
+{
+  uint8_t axis = 3;
+
+  HOST_reset();
+  CHECK_EQ(SLOW_move(GEN_AXIS_CNT, 1, 10, 1, 1), GEN_ERR_AXIS);
+  CHECK_EQ(SLOW_move(axis, 1, 0, 1, 1), GEN_ERR_STEPS);
+  CHECK_EQ(SLOW_move(axis, 1, 10, 0, 1), GEN_ERR_FREQ);
+  CHECK_EQ(SLOW_move(axis, 1, 10, 1, 0), GEN_ERR_FREQ);
+  CHECK_EQ(SLOW_move(axis, 1, 10, GEN_FREQ_MAX, 1), GEN_ERR_FREQ);
+
+  CHECK_EQ(SLOW_move(axis, -1, 10, 1, 60), GEN_OK);
+  CHECK(GEN_busy(axis));
+  CHECK_EQ(profile[axis].exact, 1);
+  CHECK_EQ(slows[axis].dir, -1);
+  CHECK_EQ(slows[axis].ticks, (uint64_t)GEN_tim_freq_get(axis) * 60);
+  CHECK_EQ(SLOW_move(axis, 1, 10, 1, 60), GEN_ERR_BUSY);
+  GEN_stop(axis);
+}
+
+
+
+
+int main(void)
+{
+  HOST_reset();
+
+  test_slow_exact();
+  test_slow_wait();
+  test_slow_move();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,326 @@
+/**
+  ******************************************************************************
+  * File Name          : test_stream.c
+  * Description        : compressed steps intervals stream host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  * the stream is encoded by the genlink encoder, test_stream_host.cpp,
+  * and decoded by the firmware decoder
+  *
+  ******************************************************************************
+  */
+
+#include "fw_host.h"
+#include "../../Src/generator.c"
+#include "../../Src/stream.c"
+
+void HOME_output_complete(uint8_t axis) { (void)axis; }
+void HOME_abort(uint8_t axis) { (void)axis; }
+
+void HOST_enc_reset(void);
+void HOST_enc_step(uint32_t interval, int8_t dir);
+void HOST_enc_wait(uint32_t ticks);
+void HOST_enc_end(void);
+uint32_t HOST_enc_take(uint8_t* buf, uint32_t size);
+
+
+
+
+/* helpers -------------------------------------------------------------------*/
+
+// the expected decoder output, dir 0 is the wait
+struct HOST_STEP_t
+{
+  uint32_t            len;
+  int8_t              dir;
+};
+
+static uint8_t  host_bytes[65536];
+static uint32_t host_len, host_pos;
+
+/*
+ * decoder state of the stream start, the profile isn't started
+ */
+static struct STR_t* HOST_stream(uint8_t axis)
+{
+  struct STR_t* str = &streams[axis];
+
+  memset(str, 0, sizeof(*str));
+  str->dir = 1;
+
+  return str;
+}
+
+/*
+ * the next decoded interval, the FIFO is kept full like the link does
+ */
+static uint32_t HOST_decode(uint8_t axis, int8_t* dir)
+{
+  uint16_t n = STR_free(axis);
+
+  if ( n > host_len - host_pos ) n = host_len - host_pos;
+  CHECK_EQ(STR_write(axis, host_bytes + host_pos, n), GEN_OK);
+  host_pos += n;
+
+  *dir = 0;
+  return STR_source(&streams[axis], dir);
+}
+
+/*
+ * encode the steps and the waits, decode them back
+ */
+static void HOST_round_trip(const struct HOST_STEP_t* in, uint32_t cnt, const struct HOST_STEP_t* exp)
+{
+  struct STR_t* str = HOST_stream(0);
+  uint32_t      i, len, steps = 0;
+  int8_t        dir;
+
+  HOST_enc_reset();
+  for ( i = 0; i < cnt; ++i )
+  {
+    if ( in[i].dir ) HOST_enc_step(in[i].len, in[i].dir);
+    else HOST_enc_wait(in[i].len);
+  }
+  HOST_enc_end();
+
+  host_len = HOST_enc_take(host_bytes, sizeof(host_bytes));
+  host_pos = 0;
+
+  for ( i = 0; i < cnt; ++i )
+  {
+    len = HOST_decode(0, &dir);
+    if ( len != exp[i].len || dir != exp[i].dir )
+    {
+      CHECK_EQ(len, exp[i].len);
+      CHECK_EQ(dir, exp[i].dir);
+      printf("  at the interval %u\n", i);
+      return;
+    }
+
+    steps += exp[i].dir != 0;
+  }
+
+  CHECK_EQ(HOST_decode(0, &dir), 0);
+  CHECK_EQ(str->error, STR_OK);
+  CHECK_EQ(str->steps, steps);
+}
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * every code changes the interval by its 1st and 2nd differences,
+ * the long intervals are saturated to 31 bits
+ */
+static void test_stream_decode(void)
+{
+  static const uint8_t data[] =
+  {
+    STR_OP_SET, 0x10, 0x27, 0x00, 0x00, // 10000
+    STR_OP_DD | 5,
+    STR_OP_DD | 0x3D, // -3
+    STR_OP_RUN | 2,
+    STR_OP_DD_LONG | 0x03, 0xE8, // 1000
+    STR_OP_DIR_BACK,
+    STR_OP_DD,
+    STR_OP_SET, 0x00, 0x00, 0x00, 0x80,
+    STR_OP_SET, 0xFF, 0xFF, 0xFF, 0xFF,
+    STR_OP_END
+  };
+  static const struct HOST_STEP_t exp[] =
+  {
+    {10000, 1}, {10005, 1}, {10007, 1}, {10009, 1}, {10011, 1}, {10013, 1},
+    {11015, 1}, {12017, -1}, {0x7FFFFFFF, -1}, {0x7FFFFFFF, -1}
+  };
+  struct STR_t*         str = HOST_stream(0);
+  uint32_t              i, len;
+  int8_t                dir;
+
+  CHECK_EQ(STR_write(0, data, sizeof(data)), GEN_OK);
+
+  for ( i = 0; i < sizeof(exp) / sizeof(exp[0]); ++i )
+  {
+    len = STR_source(str, &dir);
+    if ( len != exp[i].len || dir != exp[i].dir )
+    {
+      CHECK_EQ(len, exp[i].len);
+      CHECK_EQ(dir, exp[i].dir);
+      printf("  at the interval %u\n", i);
+      return;
+    }
+  }
+
+  CHECK_EQ(STR_source(str, &dir), 0);
+  CHECK_EQ(str->error, STR_OK);
+  CHECK_EQ(str->steps, 10);
+}
+
+/*
+ * the code without all its bytes is decoded later, the unknown code ends the stream
+ */
+static void test_stream_partial(void)
+{
+  static const uint8_t data[] = {STR_OP_SET, 0x20, 0x4E, 0x00, 0x00, 0xC5};
+  struct STR_t*         str = HOST_stream(1);
+  int8_t                dir;
+
+  CHECK_EQ(STR_write(1, data, 3), GEN_OK);
+  CHECK_EQ(STR_source(str, &dir), GEN_PRF_WAIT);
+  CHECK_EQ(STR_write(1, data + 3, 3), GEN_OK);
+  CHECK_EQ(STR_source(str, &dir), 20000);
+  CHECK_EQ(STR_source(str, &dir), 0);
+  CHECK_EQ(str->error, STR_ERR_CODE);
+  CHECK_EQ(STR_source(str, &dir), GEN_PRF_WAIT);
+}
+
+/*
+ * the stream ends at the soft limit, the rest of it is dropped
+ */
+static void test_stream_limits(void)
+{
+  static const uint8_t  data[] = {STR_OP_SET, 0xE8, 0x03, 0x00, 0x00, STR_OP_RUN | 18, STR_OP_END};
+  struct LIMITS_t       lim = {0};
+  struct STR_t*         str;
+  uint32_t              n = 0;
+  int8_t                dir;
+
+  lim.pos_on = 1;
+  lim.pos_min = -5;
+  lim.pos_max = 10;
+  CHECK_EQ(GEN_limits_set(2, &lim), GEN_OK);
+
+  str = HOST_stream(2);
+  str->pos = 3;
+  CHECK_EQ(STR_write(2, data, sizeof(data)), GEN_OK);
+  while ( STR_source(str, &dir) ) ++n;
+
+  CHECK_EQ(n, 7);
+  CHECK_EQ(str->pos, 10);
+  CHECK_EQ(str->error, STR_ERR_LIMIT);
+  CHECK_EQ(STR_free(2), STR_FIFO_SIZE - 1);
+}
+
+/*
+ * the stream is low below the low water without its end, the end code
+ * split over the writes is counted once
+ */
+static void test_stream_low(void)
+{
+  static const uint8_t  data[] = {STR_OP_SET, 0xE8, 0x03, 0x00, 0x00, STR_OP_RUN | 2, STR_OP_END};
+  struct STR_t*         str = HOST_stream(1);
+  int8_t                dir;
+
+  CHECK_EQ(STR_write(1, data, 3), GEN_OK);
+  CHECK_EQ(profile[1].low, 1);
+  CHECK_EQ(STR_write(1, data + 3, 3), GEN_OK);
+  CHECK_EQ(str->ends, 0);
+  CHECK_EQ(STR_write(1, data + 6, 1), GEN_OK);
+  CHECK_EQ(str->ends, 1);
+  CHECK_EQ(profile[1].low, 0);
+
+  while ( STR_source(str, &dir) ) CHECK_EQ(profile[1].low, 0);
+  CHECK_EQ(str->ends, 0);
+  CHECK_EQ(str->error, STR_OK);
+
+  // the next stream is low again
+  CHECK_EQ(STR_write(1, data, 5), GEN_OK);
+  CHECK_EQ(STR_source(str, &dir), 1000);
+  CHECK_EQ(profile[1].low, 1);
+}
+
+/*
+ * the ramp, the runs, the long jumps, the reversals and the waits are decoded exactly
+ */
+static void test_stream_round_trip(void)
+{
+  static struct HOST_STEP_t steps[3000];
+  uint32_t                  n = 0, i;
+
+  // the accelerating ramp, the 2nd differences vary
+  for ( i = 0; i < 1000; ++i ) steps[n++] = (struct HOST_STEP_t){72000000 / (100 + 5*i), 1};
+  // the cruise is the runs
+  for ( i = 0; i < 500; ++i ) steps[n++] = (struct HOST_STEP_t){12000, 1};
+  // the reversal and the short and long jumps
+  steps[n++] = (struct HOST_STEP_t){5000, -1};
+  steps[n++] = (struct HOST_STEP_t){5020, -1};
+  steps[n++] = (struct HOST_STEP_t){13000, -1};
+  steps[n++] = (struct HOST_STEP_t){0x7FFFFFFF, -1};
+  steps[n++] = (struct HOST_STEP_t){1, 1};
+  steps[n++] = (struct HOST_STEP_t){123456, 0};
+  steps[n++] = (struct HOST_STEP_t){1, 1};
+  for ( i = 0; i < 300; ++i ) steps[n++] = (struct HOST_STEP_t){1000 + i*i, i & 64 ? -1 : 1};
+
+  HOST_round_trip(steps, n, steps);
+}
+
+/*
+ * the operands out of the decoder range are clamped by the encoder
+ */
+static void test_stream_encoder_clamp(void)
+{
+  static const struct HOST_STEP_t in[] =
+  {
+    {0xFFFFFFFF, 0}, {0, 0}, {0x80000000, 1}, {0, 1}, {0xFFFFFFFF, -1}
+  };
+  static const struct HOST_STEP_t exp[] =
+  {
+    {0xFFFFFFFE, 0}, {1, 0}, {0x7FFFFFFF, 1}, {1, 1}, {0x7FFFFFFF, -1}
+  };
+
+  HOST_round_trip(in, 5, exp);
+}
+
+/*
+ * the raw wait out of the range isn't the source without data
+ */
+static void test_stream_wait_clamp(void)
+{
+  static const uint8_t  data[] = {STR_OP_WAIT, 0xFF, 0xFF, 0xFF, 0xFF, STR_OP_WAIT, 0, 0, 0, 0, STR_OP_END};
+  struct STR_t*         str = HOST_stream(1);
+  int8_t                dir;
+
+  CHECK_EQ(STR_write(1, data, sizeof(data)), GEN_OK);
+  CHECK_EQ(STR_source(str, &dir), GEN_PRF_WAIT - 1);
+  CHECK_EQ(dir, 0);
+  CHECK_EQ(STR_source(str, &dir), 1);
+  CHECK_EQ(STR_source(str, &dir), 0);
+  CHECK_EQ(str->error, STR_OK);
+  CHECK_EQ(str->steps, 0);
+}
+
+/*
+ * the decode rate is the decoded steps per the CPU time of the decoding
+ */
+static void test_stream_decode_rate(void)
+{
+  struct STR_t* str = HOST_stream(3);
+
+  CHECK_EQ(STR_decode_rate(3), 0);
+  str->steps = 1000;
+  str->cycles = 36000;
+  CHECK_EQ(STR_decode_rate(3), 2000000);
+  CHECK_EQ(STR_decode_rate(GEN_AXIS_CNT), 0);
+}
+
+
+
+
+int main(void)
+{
+  GEN_init();
+
+  test_stream_decode();
+  test_stream_partial();
+  test_stream_limits();
+  test_stream_low();
+  test_stream_decode_rate();
+  test_stream_round_trip();
+  test_stream_encoder_clamp();
+  test_stream_wait_clamp();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * File Name          : test_stream_host.cpp
+  * Description        : host stream encoder of the stream decoder tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  * the C test drives the genlink encoder by these calls
+  *
+  ******************************************************************************
+  */
+
+#include <cstring>
+
+#include "../genlink/stream_encoder.cpp"
+
+static genlink::StreamEncoder enc;
+
+extern "C" void HOST_enc_reset(void)
+{
+  enc = genlink::StreamEncoder();
+}
+
+extern "C" void HOST_enc_step(uint32_t interval, int8_t dir)
+{
+  enc.step(interval, dir);
+}
+
+extern "C" void HOST_enc_wait(uint32_t ticks)
+{
+  enc.wait(ticks);
+}
+
+extern "C" void HOST_enc_end(void)
+{
+  enc.end();
+}
+
+/*
+ * encoded bytes, they are taken out of the encoder
+ */
+extern "C" uint32_t HOST_enc_take(uint8_t* buf, uint32_t size)
+{
+  std::vector<uint8_t>& out = enc.bytes();
+  uint32_t              n = out.size() < size ? out.size() : size;
+
+  std::memcpy(buf, out.data(), n);
+  out.erase(out.begin(), out.begin() + n);
+
+  return n;
+}
@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * File Name          : test_telemetry.c
+  * Description        : axes telemetry stream host tests
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+#include "fw_host.h"
+
+SPI_HandleTypeDef hspi2;
+
+#include "../../Src/generator.c"
+#include "../../Src/ramp.c"
+#include "../../Src/ramp_tables.c"
+#include "../../Src/stream.c"
+#include "../../Src/telemetry.c"
+
+void HOME_output_complete(uint8_t axis) { (void)axis; }
+void HOME_abort(uint8_t axis) { (void)axis; }
+
+
+
+
+/* tests ---------------------------------------------------------------------*/
+
+/*
+ * the frame has its size, the axes state since the previous frame and the xor sum
+ */
+static void test_tlm_frame(void)
+{
+  const uint8_t*  b = (const uint8_t*)&frame;
+  uint8_t         sum = 0;
+  uint8_t         seq = frame.seq;
+
+  GEN_position_set(1, 500);
+  streams[2].steps = 1000;
+  streams[2].cycles = 36000;
+  axes[3].late_stops = 2;
+  last_time = 0;
+  TLM_frame_fill(100);
+
+  CHECK_EQ(frame.sync, TLM_SYNC);
+  CHECK_EQ(frame.seq, (uint8_t)(seq + 1));
+  CHECK_EQ(frame.len, sizeof(frame));
+  CHECK_EQ(frame.time, 100);
+  CHECK_EQ(frame.axis[1].pos, 500);
+  CHECK_EQ(frame.axis[1].vel, 5000);
+  CHECK_EQ(frame.axis[0].vel, 0);
+  CHECK_EQ(frame.axis[2].decode_rate, 2000000);
+  CHECK_EQ(frame.axis[3].decode_rate, 0);
+  CHECK_EQ(frame.axis[3].late_stops, 2);
+
+  for ( uint16_t i = 0; i < sizeof(frame); ++i ) sum ^= b[i];
+  CHECK_EQ(sum, 0);
+
+  // the position doesn't change, the average velocity is zero
+  TLM_frame_fill(300);
+  CHECK_EQ(frame.axis[1].vel, 0);
+}
+
+/*
+ * the frame time slots are ms, the frame transfer fits a half of the frame period
+ */
+static void test_tlm_rate(void)
+{
+  CHECK(2 * 8 * sizeof(struct TLM_FRAME_t) * TLM_RATE_MAX <= TLM_SPI_CLK);
+
+  TLM_rate_set(50);
+  CHECK_EQ(period, 20);
+  TLM_rate_set(TLM_RATE_MAX);
+  CHECK_EQ(period, 1);
+  TLM_rate_set(0);
+  CHECK_EQ(period, 0);
+  TLM_rate_set(TLM_RATE);
+}
+
+
+
+
+int main(void)
+{
+  GEN_init();
+
+  test_tlm_frame();
+  test_tlm_rate();
+
+  return HOST_RESULT();
+}
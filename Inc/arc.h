@@ -0,0 +1,84 @@
+/**
+  ******************************************************************************
+  * File Name          : arc.h
+  * Description        : circular/helical arc interpolation settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __ARC_H
+#define __ARC_H
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+#define ARC_RADIUS_MAX          0x00FFFFFF // steps, max arc centre offset and end offset
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// arc motion command
+struct ARC_t
+{
+  uint8_t             ax; // plane 1st axis
+  uint8_t             ay; // plane 2nd axis
+  uint8_t             az; // helix axis (GEN_AXIS_NONE = plane arc)
+  int32_t             xe; // end point, steps
+  int32_t             ye;
+  int32_t             ze;
+  int32_t             i; // centre offset from the start point, steps
+  int32_t             j;
+  uint8_t             cw; // 1 = clockwise, 0 = counterclockwise
+  uint32_t            feed; // Hz, plane path steps frequency
+};
+
+// arc walk, every axis of the arc runs its own copy
+struct ARC_WALK_t
+{
+  int32_t             x; // point relative to the centre, steps
+  int32_t             y;
+  int32_t             xe; // end point relative to the centre, steps
+  int32_t             ye;
+  int64_t             r2; // radius squared
+  int8_t              cw;
+  uint8_t             away; // the walk has left the end point neighbourhood
+  uint8_t             done;
+  uint32_t            moves; // plane moves of the whole arc, estimated
+  uint32_t            walked; // plane moves done
+  uint32_t            nz; // helix steps of the whole arc
+  uint32_t            zleft; // helix steps left
+  int8_t              zdir; // helix direction
+  uint32_t            zacc; // helix steps accumulator
+  uint32_t            left; // max moves left, the walk safety limit
+  uint64_t            t1; // axial move time, 24.8 fixed point timer ticks
+  uint64_t            td; // diagonal move time, 24.8 fixed point timer ticks
+};
+
+// arc axis steps source data
+struct ARC_AXIS_t
+{
+  struct ARC_WALK_t   walk;
+  uint8_t             role; // 0 = plane 1st axis, 1 = plane 2nd axis, 2 = helix axis
+  uint64_t            now; // arc time, 24.8 fixed point timer ticks
+  uint64_t            last; // the last step time, timer ticks
+};
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+enum GEN_ERR_t ARC_start(const struct ARC_t* arc);
+
+
+
+
+#endif /* __ARC_H */
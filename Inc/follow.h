@@ -0,0 +1,79 @@
+/**
+  ******************************************************************************
+  * File Name          : follow.h
+  * Description        : step/dir input re-generator settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FOLLOW_H
+#define __FOLLOW_H
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+#define FOL_FIFO_SIZE           32 // power of 2, input samples buffer of the axis, 2 bytes of RAM per sample
+#define FOL_AVG_MAX             32 // samples, longest moving average of the input speed, 2 bytes of RAM per sample
+#define FOL_SPLIT               8 // output periods of the sample time with less steps
+#define FOL_DELAY               12 // samples, output start delay, more than 2 * GEN_PRF_HALF_SIZE / FOL_SPLIT
+
+// the input axis steps are sampled at every systick, the output axis plays the samples
+// FOL_DELAY samples later. The output speed is the moving average of the input speed
+// multiplied by num/den, the output steps are evenly spaced inside the sample time.
+// The lag is FOL_DELAY plus half of the average length samples, the output steps
+// count is the input one multiplied by num/den, the fractions are carried
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// axis input re-generator data structure
+struct FOL_t
+{
+  volatile uint8_t    on; // the input is sampled
+  uint8_t             input; // input axis
+  uint32_t            num; // output steps per den input steps
+  uint32_t            den;
+  int16_t             fifo[FOL_FIFO_SIZE]; // input steps of the samples
+  volatile uint16_t   head; // the next sample to play
+  volatile uint16_t   tail; // the next free sample
+  int32_t             carry; // input steps which aren't in the FIFO yet
+  int16_t             hist[FOL_AVG_MAX]; // the last played samples
+  uint8_t             avg; // moving average length, samples
+  uint8_t             hist_i; // the oldest sample in hist[]
+  int32_t             sum; // input steps of hist[]
+  int64_t             acc; // output steps fraction, 1/(avg * den) steps
+  uint32_t            ticks; // timer ticks of the sample time
+  int8_t              dir;
+  uint32_t            steps; // output steps of the sample time
+  uint32_t            slots; // output periods of the sample time
+  uint32_t            slot; // output periods done
+  uint8_t             stop; // the input is stopped, the output ends after the filter is empty
+};
+
+
+
+
+/* handlers ------------------------------------------------------------------*/
+
+void FOL_SYSTICK_IRQHandler(void);
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+enum GEN_ERR_t FOL_start(uint8_t axis, uint8_t input, uint32_t num, uint32_t den, uint8_t avg);
+void FOL_stop(uint8_t axis);
+
+
+
+
+#endif /* __FOLLOW_H */
@@ -21,22 +21,230 @@
 #define GEN_AXIS_CNT            4 // 1..4, max axis count
 #define GEN_DMA_ARRAY_SIZE      512 // 1..1000, DMA transfer array size
 #define GEN_SYSTICK_IRQ_FREQ    1000 // Hz, systick update event frequency
+#define GEN_GEAR_GATE_NS        1000 // ns, geared master pulse width if it isn't set
+#define GEN_FREQ_MAX            500000 // Hz, max steps frequency
+#define GEN_PRF_HALF_SIZE       32 // 8..128, steps periods in the profile DMA ring half
+#define GEN_PRF_PULSE_NS        2000 // ns, profile output pulse width if it isn't set
+#define GEN_PRF_PAD_TICKS       720 // timer ticks, silent period after the profile end
+#define GEN_DIR_SETUP_NS        5000 // ns, direction output setup time before the step
+#define GEN_PRF_CHUNK_MAX       65535 // timer ticks, longest profile timer period, the longer ones are prescaled
+#define GEN_PRF_RUN_MAX         256 // 1..256, equal periods in one DMA burst by the TIM1 repetition counter
+#define GEN_PRF_RUN_TICKS       144000 // timer ticks, longest burst of the equal periods, keeps the override response
+#define GEN_PRF_RUN_MIN_TICKS   256 // timer ticks, shortest repeated period, the stop counts its pulses by the time
+#define GEN_OVR_MAX             200 // %, max feed override
+#define GEN_OVR_MIN             1 // %, min feed override, lower values are raised to it
+#define GEN_OVR_STEP            5 // %, feed override slew step
+#define GEN_OVR_GAP_US          1000 // us, feed override slew step time of the axes without the acceleration limit
+#define GEN_DMA_LOAD_MAX        60 // %, max DMA bus load of the steps outputs, the rest is for the link and telemetry
+#define GEN_DMA_CAL_SIZE        256 // 1..GEN_DMA_ARRAY_SIZE, transfers of the DMA cost benchmark at the init
+
+#define GEN_AXIS_NONE           0xFF // no axis link
+#define GEN_PRF_WAIT            0xFFFFFFFF // profile steps source has no data yet
+
+// DMA1 channels of the axes steps outputs, the requests don't share the channels
+// with SPI1_RX (2), SPI1_TX (3) and SPI2_TX (5):
+// axis 0 TIM1_CH4 (4), axis 1 TIM2_CH4 (7), axis 2 TIM3_CH1 (6), axis 3 TIM4_CH1 (1).
+// The channel 4 compare is frozen, it's the DMA request only.
+// The axes channels priorities are ranked by the outputs rates at every output start.
+// The outputs are admitted by the DMA bus load: the constant frequency step is a transfer,
+// the profile period is a 5 transfers burst, the transfer cost is measured at the init.
+// The constant frequency move over the load is rejected, the profile max rate is throttled
+
+// output modes: step/dir, quadrature A/B (the step is an A or B edge of the Gray code,
+// the profile outputs only) and CW/CCW (the forward and the backward pulses channels)
+
+// step pulses self-verification: the axis step pin is wired to the checker axis step pin,
+// the checker's timer counts the pulses by the TI1 external clock, its pin is the input
 
 
 
 
 /* var types -----------------------------------------------------------------*/
 
+// motion command errors
+enum GEN_ERR_t
+{
+  GEN_OK = 0,
+  GEN_ERR_AXIS, // no such axis
+  GEN_ERR_BUSY, // no free space for the move, the axis output is in progress
+  GEN_ERR_STEPS, // steps out of 1..GEN_DMA_ARRAY_SIZE
+  GEN_ERR_FREQ, // frequency out of the axis range
+  GEN_ERR_GEAR, // geared slave axis, the master's period is shorter than its gate or the ratio doesn't fit
+  GEN_ERR_LIMIT, // the move ends out of the soft limits, or the limits are inverted
+  GEN_ERR_ARC, // the arc end point isn't on the circle
+  GEN_ERR_BUS, // the DMA bus load of the concurrent outputs is too high
+  GEN_ERR_MODE // the command isn't supported by the axis output mode
+};
+
+// axis motion limits
+struct LIMITS_t
+{
+  int32_t             pos_min; // soft limits, steps
+  int32_t             pos_max;
+  uint8_t             pos_on; // soft limits are enabled
+  uint32_t            freq_max; // Hz, max steps frequency (0 = GEN_FREQ_MAX)
+  uint32_t            freq_start; // Hz, max frequency to start/stop without a ramp (0 = any)
+  uint32_t            accel; // steps/s^2, max override and starvation slowdown acceleration (0 = GEN_OVR_GAP_US steps)
+};
+
+// axis backlash compensation
+struct BACKLASH_t
+{
+  uint16_t            steps; // take-up steps on the direction reversal (0 = off)
+  uint32_t            freq; // Hz, take-up steps frequency
+  uint16_t            slack; // take-up position, 0 = engaged backward, steps = engaged forward
+  uint8_t             comp; // the take-up output is in progress
+  uint16_t            next_steps; // the move to start after the take-up
+  uint32_t            next_freq;
+};
+
+// axis output modes
+enum GEN_MODE_t
+{
+  GEN_MODE_STEP_DIR = 0, // channel 1 is the step pulses, channel 2 is the direction
+  GEN_MODE_QUAD, // channel 1 is A, channel 2 is B
+  GEN_MODE_CW_CCW // channel 1 is the forward pulses, channel 2 is the backward ones
+};
+
+// axis step pulses self-verification
+struct VERIFY_t
+{
+  uint8_t             checker; // axis which timer counts the step pulses (GEN_AXIS_NONE = off)
+  uint8_t             counts; // the axis timer counts the step pin pulses, the checker or the step/dir input
+  uint16_t            cnt; // checker's counter at the last count update
+  uint32_t            pulses; // counted step pulses
+  uint32_t            start; // counted step pulses at the output start
+  uint16_t            seg; // outputs started, the output id
+  uint16_t            bad_seg; // the last output with the wrong pulses count (0 = none)
+  int32_t             bad_diff; // its counted minus commanded pulses
+  uint32_t            errors; // outputs with the wrong pulses count
+};
+
 // axis data structure
 struct AXIS_t
 {
   TIM_HandleTypeDef*  htim; // link to timer's init structure
   DMA_HandleTypeDef*  hdma; // link to timer's dma channel init structure
+  uint16_t            dma_req; // TIM_DMA_CC1 or TIM_DMA_CC4, the timer's request of the hdma channel
   uint32_t            tim_freq; // axis timer base frequency, Hz
   uint32_t            presc;
   uint32_t            period;
   uint16_t            steps;
-  uint16_t            freq;
+  uint32_t            freq;
+  uint32_t            pulse_ns; // step pulse width, ns (0 = 50% duty)
+  uint32_t            pulse_clk; // step pulse width, timer base clock ticks
+  uint8_t             gear_master; // master axis of the geared slave axis
+  uint16_t            gear_gate; // master's pulse width while it's geared, timer ticks
+  int8_t              dir; // 1 = forward, -1 = backward
+  uint8_t             busy; // steps output is in progress
+  int32_t             pos; // position at the last output start, steps
+  uint32_t            rate; // steps/s, the output rate, it ranks the DMA channels priorities
+  uint32_t            late_stops; // constant frequency outputs stopped after the next pulse start
+  uint16_t            dma_clk; // CPU clocks of the DMA transfer to the timer, measured at the init
+  uint8_t             mode; // enum GEN_MODE_t output mode
+  uint8_t             quad_q; // quadrature state of the filled periods, 0..3 = AB 00, 10, 11, 01
+};
+
+
+
+
+// axis DMA IRQ handlers timing
+struct GEN_ISR_STAT_t
+{
+  uint32_t            cnt; // handled events
+  uint32_t            max; // CPU clocks, the longest handler
+};
+
+// axis status for the host
+struct GEN_STATUS_t
+{
+  int32_t             pos; // steps
+  uint16_t            depth; // profile periods filled and not read by the DMA
+  uint32_t            underruns; // profile ring halves played silent
+  uint32_t            isr_cnt; // DMA IRQ handlers timing
+  uint32_t            isr_max;
+  uint32_t            late_stops; // constant frequency outputs stopped late
+  uint16_t            seg; // the last output id
+  uint16_t            verify_seg; // the last output with the wrong step pulses count (0 = none)
+  int32_t             verify_diff; // its counted minus commanded pulses
+  uint32_t            verify_errors; // outputs with the wrong step pulses count
+  uint32_t            starves; // profile sources starvation events, all axes
+  uint32_t            starve_time; // ms, the last starvation start
+  uint8_t             starving; // the profile outputs of a starving source axes group are slowed down
+  uint8_t             dma_load; // %, projected DMA bus load of the running outputs
+};
+
+// profile steps source
+// returns the timer base clock ticks from the previous step (from the profile
+// start for the first one) to the next step and sets its direction, 0 = the end,
+// GEN_PRF_WAIT = no data yet, the source is called again later.
+// The direction 0 is the time without a step, the next interval starts at its end
+typedef uint32_t (*GEN_PRF_SRC_t)(void* ctx, int8_t* dir);
+
+// profile ring half states
+enum PRF_HALF_t
+{
+  PRF_FREE = 0, // silent, waits for the data
+  PRF_READY, // filled with the steps periods
+  PRF_SILENT, // the data was late, the half is played silent
+  PRF_LAST // silent tail after the profile end
+};
+
+// axis profile output data
+struct PRF_t
+{
+  GEN_PRF_SRC_t       src; // steps source
+  void*               ctx; // steps source data
+  uint8_t             on; // profile output is in progress
+  uint8_t             end; // 1 = the source is empty, 2 = the last step is filled, 3 = the tail is filled
+  volatile uint8_t    state[2]; // ring halves states
+  int16_t             net[2]; // ring halves position change, steps
+  uint16_t            pulses[2]; // ring halves step pulses
+  uint32_t            pulses_done; // step pulses of the played halves
+  int8_t              last_dir[2]; // ring halves last step direction (0 = no steps)
+  uint16_t            slack[2]; // ring halves backlash take-up position at the end (GEN_SLACK_NONE = no change)
+  uint8_t             fill; // the next ring half to fill
+  uint8_t             staged; // the next half data is ready
+  uint8_t             stage_cnt; // periods of the next half data filled
+  uint8_t             stage_last; // the next half data is the tail
+  int16_t             stage_net;
+  uint16_t            stage_pulses;
+  int8_t              stage_dir;
+  uint16_t            stage_slack;
+  uint16_t            base; // the first ring period which isn't in the position
+  int8_t              tail; // step of the last period of the previous half
+  uint8_t             runs; // the equal periods are repeated by the timer's repetition counter
+  uint64_t            base_time; // the base period start, ticks from the output start
+  uint64_t            clk; // CPU clocks from the output start to the last half done
+  uint32_t            cyc; // CPU clocks counter at the last half done
+  int8_t              lvl; // direction level after the last filled period
+  int8_t              next_dir; // next step direction
+  uint8_t             pulse; // next filled period starts with the step pulse
+  uint8_t             pulse_lash; // the pulse is the backlash take-up, it isn't in the position
+  uint8_t             next_lash; // the next step is the backlash take-up
+  uint64_t            wait; // ticks left to the next step, the slowed down interval may be over 32 bits
+  uint64_t            late; // ticks the steps are delayed by the shortest period and the take-up
+  uint16_t            lash; // backlash take-up pulses left before the held step
+  uint16_t            lash_slack; // backlash take-up position after the filled periods
+  uint32_t            lash_ticks; // backlash take-up pulses interval
+  uint64_t            held; // interval of the step after the take-up, ticks (0 = none)
+  uint16_t            pulse_ticks; // step pulse width
+  uint16_t            setup_ticks; // direction setup time
+  uint32_t            min_ticks; // shortest step interval, it's over 16 bits at the low max rates
+  uint32_t            underruns; // halves played silent
+  uint8_t             group; // axes started together, they share the override switch time
+  uint64_t            src_time; // source time of the fetched steps, ticks
+  uint64_t            real_time; // override scaled time of the fetched steps, 1/256 ticks
+  uint64_t            out_time; // override scaled time of the fetched steps, ticks
+  uint16_t            ovr; // global override of the axis, %
+  uint16_t            ovr_next; // global override after the switch, %
+  uint64_t            ovr_at; // source time of the override switch, ticks
+  uint8_t             ovr_pending; // the override switch isn't passed yet
+  uint16_t            axis_ovr; // axis override, %
+  uint64_t            axis_ovr_at; // source time of the next axis override step, ticks
+  uint32_t            src_len; // the last source interval, ticks
+  uint8_t             low; // the source data is running low
+  uint8_t             exact; // the source rate isn't scaled by the overrides
 };
 
 
@@ -46,6 +254,7 @@ struct AXIS_t
 
 void GEN_SYSTICK_IRQHandler(void);
 void GEN_DMA_transfer_complete(uint8_t axis);
+void GEN_DMA_half_transfer(uint8_t axis);
 
 
 
@@ -54,7 +263,37 @@ void GEN_DMA_transfer_complete(uint8_t axis);
 
 void GEN_system_init(void);
 void GEN_init(void);
-void GEN_steps_output(uint8_t axis, uint16_t steps, uint32_t freq);
+void GEN_process(void);
+enum GEN_ERR_t GEN_steps_output(uint8_t axis, uint16_t steps, uint32_t freq);
+enum GEN_ERR_t GEN_move_check(uint8_t axis, int8_t dir, uint32_t steps, uint32_t freq);
+enum GEN_ERR_t GEN_move(uint8_t axis, int8_t dir, uint32_t steps, uint32_t freq);
+enum GEN_ERR_t GEN_limits_set(uint8_t axis, const struct LIMITS_t* lim);
+enum GEN_ERR_t GEN_limits_check(uint8_t axis, int32_t pos);
+const struct LIMITS_t* GEN_limits_get(uint8_t axis);
+enum GEN_ERR_t GEN_profile_set(uint8_t axis, GEN_PRF_SRC_t src, void* ctx);
+void GEN_profile_start(uint8_t axes_mask);
+enum GEN_ERR_t GEN_override_set(uint16_t percent);
+enum GEN_ERR_t GEN_axis_override_set(uint8_t axis, uint16_t percent);
+void GEN_profile_low_set(uint8_t axis, uint8_t low);
+void GEN_profile_exact_set(uint8_t axis);
+enum GEN_ERR_t GEN_backlash_set(uint8_t axis, uint16_t steps, uint32_t freq);
+enum GEN_ERR_t GEN_pulse_width_set(uint8_t axis, uint32_t ns);
+void GEN_dir_set(uint8_t axis, int8_t dir);
+void GEN_stop(uint8_t axis);
+int32_t GEN_position_get(uint8_t axis);
+void GEN_position_set(uint8_t axis, int32_t pos);
+uint32_t GEN_tim_freq_get(uint8_t axis);
+uint8_t GEN_busy(uint8_t axis);
+void GEN_status_get(uint8_t axis, struct GEN_STATUS_t* st);
+uint32_t GEN_isqrt(uint64_t v);
+enum GEN_ERR_t GEN_gear_set(uint8_t slave, uint8_t master, uint16_t num, uint16_t den);
+void GEN_gear_off(uint8_t slave);
+enum GEN_ERR_t GEN_verify_set(uint8_t axis, uint8_t checker);
+enum GEN_ERR_t GEN_mode_set(uint8_t axis, enum GEN_MODE_t mode);
+void GEN_verify_off(uint8_t axis);
+enum GEN_ERR_t GEN_input_set(uint8_t axis);
+void GEN_input_off(uint8_t axis);
+int32_t GEN_input_get(uint8_t axis);
 
 
 
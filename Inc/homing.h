@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * File Name          : homing.h
+  * Description        : axes homing settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HOMING_H
+#define __HOMING_H
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// homing cycle states
+enum HOME_STATE_t
+{
+  HOME_IDLE = 0,
+  HOME_SEEK_FAST, // fast moving to the switch
+  HOME_BACKOFF, // moving out of the switch
+  HOME_SEEK_SLOW, // slow moving to the switch, latch the position
+  HOME_DONE,
+  HOME_ERROR // no switch edge inside the max travel or the output is rejected
+};
+
+// axis homing data structure
+struct HOME_t
+{
+  GPIO_TypeDef*       port; // home switch input port
+  uint16_t            pin; // home switch input pin, EXTI line
+  IRQn_Type           irq; // EXTI line IRQ
+  int8_t              dir; // direction to the switch
+  uint32_t            fast_freq; // Hz, fast seek frequency
+  uint32_t            slow_freq; // Hz, back-off and slow seek frequency
+  uint16_t            backoff; // back-off steps
+  uint32_t            travel_max; // max steps to find the switch
+  int32_t             home_pos; // axis position at the switch edge
+  volatile uint8_t    state;
+  uint8_t             out; // the axis output is the homing one
+  int32_t             latch; // axis position latched at the switch edge
+};
+
+
+
+
+/* handlers ------------------------------------------------------------------*/
+
+void HOME_EXTI_IRQHandler(uint8_t axis);
+void HOME_output_complete(uint8_t axis);
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+void HOME_init(void);
+enum GEN_ERR_t HOME_config(uint8_t axis, int8_t dir, uint32_t fast_freq, uint32_t slow_freq,
+                           uint16_t backoff, uint32_t travel_max, int32_t home_pos);
+enum GEN_ERR_t HOME_start(uint8_t axis);
+void HOME_abort(uint8_t axis);
+uint8_t HOME_state(uint8_t axis);
+
+
+
+
+#endif /* __HOMING_H */
@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * File Name          : link.h
+  * Description        : host link settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LINK_H
+#define __LINK_H
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+#define LINK_RX_SIZE            1024 // power of 2, SPI receive buffer size
+#define LINK_SYNC               0xA5 // frame start byte
+#define LINK_ERR_CMD            0xFF // command result of an unknown command or a short payload
+#define LINK_DMA_RX             DMA1_Channel2 // SPI1_RX request channel, circular to the receive buffer
+#define LINK_DMA_TX             DMA1_Channel3 // SPI1_TX request channel, circular status frames
+#define LINK_DMA_TX_IRQn        DMA1_Channel3_IRQn
+#define LINK_DMA_TX_HT          DMA_ISR_HTIF3
+#define LINK_DMA_TX_TC          DMA_ISR_TCIF3
+#define LINK_DMA_TX_IFCR        DMA_IFCR_CGIF3
+
+// frame: LINK_SYNC, command, payload length, payload, xor of command, length and payload
+// the bytes out of the frames are skipped, so the host pads the transfers by 0x00
+
+// the slave sends the status frames all the time: LINK_SYNC, LINK_STATUS_t, xor of LINK_STATUS_t
+// the host keeps less than LINK_RX_SIZE bytes unparsed, the DMA doesn't stop at the full buffer
+
+// the payload integers are little endian, the signed ones are two's complement.
+// Every executed command is counted in the status with its GEN_ERR_t result,
+// the full stream FIFO is waited for, the full PVT queue is the GEN_ERR_BUSY result
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// host link commands
+enum LINK_CMD_t
+{
+  LINK_CMD_STREAM = 1, // axis, encoded stream data
+  LINK_CMD_STREAM_START, // axes mask
+  LINK_CMD_STOP, // axis or GEN_AXIS_NONE for all
+  LINK_CMD_MOVE, // axis, dir, steps LE32, freq LE32
+  LINK_CMD_PULSE_WIDTH, // axis, ns LE32
+  LINK_CMD_GEAR, // slave, master or GEN_AXIS_NONE for off, num LE16, den LE16
+  LINK_CMD_HOME_CONFIG, // axis, dir, fast_freq LE32, slow_freq LE32, backoff LE16, travel_max LE32, home_pos LE32
+  LINK_CMD_HOME_START, // axis
+  LINK_CMD_LIMITS, // axis, pos_min LE32, pos_max LE32, pos_on, freq_max LE32, freq_start LE32, accel LE32
+  LINK_CMD_BACKLASH, // axis, steps LE16, freq LE32
+  LINK_CMD_ARC, // ax, ay, az, xe, ye, ze, i, j LE32, cw, feed LE32
+  LINK_CMD_PVT_ADD, // axis, pos LE32, vel LE32, us LE32
+  LINK_CMD_PVT_START, // axes mask
+  LINK_CMD_OVERRIDE, // axis or GEN_AXIS_NONE for all, feed override % LE16
+  LINK_CMD_RAMP, // axis, dir, steps LE32, ramp table, freq LE32
+  LINK_CMD_RAMP_ACCEL, // axis, dir, steps LE32, accel LE32, freq_start LE32, freq LE32
+  LINK_CMD_TLM_RATE, // Hz LE16
+  LINK_CMD_PVT_END, // axes mask
+  LINK_CMD_SLOW, // axis, dir, steps LE32, num LE32, den LE32
+  LINK_CMD_VERIFY, // axis, checker or GEN_AXIS_NONE for off
+  LINK_CMD_MODE, // axis, GEN_MODE_t
+  LINK_CMD_FOLLOW, // axis, input axis, num LE32, den LE32, avg
+  LINK_CMD_FOLLOW_STOP // axis
+};
+
+
+
+
+// host link status, little endian
+struct __attribute__((packed)) LINK_STATUS_t
+{
+  uint16_t            parsed; // received bytes taken out of the receive FIFO, wraps
+  uint16_t            stream_free[GEN_AXIS_CNT]; // stream FIFOs free space, bytes
+  uint8_t             cmds; // executed commands, wraps
+  uint8_t             result; // GEN_ERR_t of the last executed command or LINK_ERR_CMD
+};
+
+
+
+
+/* handlers ------------------------------------------------------------------*/
+
+void LINK_DMA_IRQHandler(void);
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+void LINK_init(void);
+void LINK_process(void);
+
+
+
+
+#endif /* __LINK_H */
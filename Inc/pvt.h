@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * File Name          : pvt.h
+  * Description        : position-velocity-time segments settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PVT_H
+#define __PVT_H
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+#define PVT_QUEUE_SIZE          16 // 2..256, segments queue size of the axis
+#define PVT_STEPS_MAX           0x003FFFFF // steps, max segment move and velocity*duration
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// PVT segment, the start is the end of the previous segment
+struct PVT_SEG_t
+{
+  int32_t             pos; // end position, steps
+  int32_t             vel; // end velocity, steps/s
+  uint32_t            us; // duration, us
+};
+
+// axis PVT data structure
+struct PVT_t
+{
+  struct PVT_SEG_t    queue[PVT_QUEUE_SIZE];
+  volatile uint8_t    head; // the next segment to interpolate
+  volatile uint8_t    tail; // the next free queue cell
+  uint8_t             on; // PVT motion is in progress
+  uint8_t             open; // more segments come, the empty queue waits for them
+  int32_t             q_pos; // queue end position, steps
+  int32_t             q_vel; // queue end velocity, steps/s
+  int32_t             p0; // segment start position, steps
+  int32_t             v0; // segment start velocity, steps/s
+  uint8_t             active; // segment interpolation is in progress
+  int64_t             b; // segment cubic p(u) = b*u + c*u^2 + d*u^3
+  int64_t             c; // relative to the start, 24.8 fixed point steps
+  int64_t             d;
+  int32_t             end; // segment move, steps
+  uint64_t            ticks; // segment duration, timer ticks
+  uint32_t            piece_end[3]; // monotonic pieces ends, 8.24 fixed point segment time
+  uint8_t             pieces;
+  uint8_t             piece; // current piece
+  uint32_t            u; // segment time of the last step, 8.24 fixed point
+  int32_t             s; // steps done in the segment
+  uint64_t            start; // segment start time, timer ticks
+  uint64_t            last; // the last step time, timer ticks
+};
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+enum GEN_ERR_t PVT_add(uint8_t axis, int32_t pos, int32_t vel, uint32_t us);
+enum GEN_ERR_t PVT_start(uint8_t axes_mask);
+enum GEN_ERR_t PVT_end(uint8_t axes_mask);
+
+
+
+
+#endif /* __PVT_H */
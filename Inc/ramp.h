@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * File Name          : ramp.h
+  * Description        : acceleration ramps settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RAMP_H
+#define __RAMP_H
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+#define RAMP_TIM_FREQ           72000000 // Hz, timer clock of the ramp tables
+#define RAMP_TABLE_CNT          3 // ramp tables count, Tools/ramp_gen.py profiles
+
+#define RAMP_CACHE_CNT          2 // computed ramps cache entries, 1 KB of RAM each
+#define RAMP_CACHE_SIZE         256 // steps, max computed ramp, 4 bytes of RAM per step and entry
+
+// the tables are generated by Tools/ramp_gen.py to the Src/ramp_tables.c
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// constant acceleration ramp from zero to the max frequency
+struct RAMP_TABLE_t
+{
+  uint32_t            accel; // steps/s^2
+  uint32_t            freq_max; // Hz
+  uint16_t            size; // steps
+  const uint32_t*     ticks; // steps intervals, RAMP_TIM_FREQ ticks, decreasing
+};
+
+// computed ramps cache entry
+struct RAMP_CACHE_t
+{
+  uint32_t            freq_start; // Hz, the key is the accel, freq_start and table freq_max
+  uint32_t            used; // LRU stamp, 0 = empty
+  struct RAMP_TABLE_t table;
+  uint32_t            ticks[RAMP_CACHE_SIZE];
+};
+
+// computed ramps cache statistics
+struct RAMP_CACHE_STAT_t
+{
+  uint32_t            hits;
+  uint32_t            misses;
+  uint32_t            evictions;
+};
+
+// axis ramp move data structure
+struct RAMP_t
+{
+  const struct RAMP_TABLE_t* table;
+  int8_t              dir;
+  uint32_t            steps; // move steps
+  uint32_t            step; // steps done
+  uint16_t            acc; // acceleration and deceleration steps
+  uint32_t            cruise; // cruise steps interval, timer ticks
+  uint32_t            scale; // 16.16 fixed point, axis timer clock / RAMP_TIM_FREQ
+};
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+extern const struct RAMP_TABLE_t RAMP_tables[RAMP_TABLE_CNT];
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+enum GEN_ERR_t RAMP_move(uint8_t axis, int8_t dir, uint32_t steps, uint8_t table, uint32_t freq);
+enum GEN_ERR_t RAMP_move_accel(uint8_t axis, int8_t dir, uint32_t steps,
+                               uint32_t accel, uint32_t freq_start, uint32_t freq);
+const struct RAMP_CACHE_STAT_t* RAMP_cache_stat(void);
+
+
+
+
+#endif /* __RAMP_H */
@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * File Name          : slow.h
+  * Description        : low speed exact rate moves settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SLOW_H
+#define __SLOW_H
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+#define SLOW_WAIT_MAX           0x40000000 // timer ticks, longest source interval, the longer steps periods are split
+
+// the rate is the fraction num/den steps/s, the steps times are exact to the
+// timer tick and don't drift, so the rate error is the timer clock error only.
+// The feed overrides and the starvation slowdown don't scale the slow moves
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// axis low speed move data structure
+struct SLOW_t
+{
+  int8_t              dir;
+  uint32_t            steps; // move steps
+  uint32_t            step; // steps done
+  uint32_t            num; // rate, num/den steps/s
+  uint64_t            ticks; // integer part of the steps period, timer ticks
+  uint64_t            frac; // fraction part of the steps period, 1/num ticks
+  uint64_t            acc; // fraction part accumulator, 1/num ticks
+  uint64_t            left; // ticks left to the next step
+};
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+enum GEN_ERR_t SLOW_move(uint8_t axis, int8_t dir, uint32_t steps, uint32_t num, uint32_t den);
+
+
+
+
+#endif /* __SLOW_H */
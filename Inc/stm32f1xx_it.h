@@ -49,9 +49,9 @@
 
 void SysTick_Handler(void);
 void DMA1_Channel1_IRQHandler(void);
-void DMA1_Channel2_IRQHandler(void);
-void DMA1_Channel5_IRQHandler(void);
+void DMA1_Channel4_IRQHandler(void);
 void DMA1_Channel6_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
 void SPI1_IRQHandler(void);
 void SPI2_IRQHandler(void);
 
@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * File Name          : stream.h
+  * Description        : compressed steps intervals stream settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STREAM_H
+#define __STREAM_H
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+#define STR_FIFO_SIZE           512 // power of 2, encoded stream buffer of the axis
+#define STR_LOW_WATER           128 // bytes, the outputs slow down below it if the stream end isn't received
+
+// encoded stream codes, the interval is in the timer base clock ticks
+// every step changes the 1st difference by the 2nd difference
+// and the interval by the 1st difference
+#define STR_OP_DD               0x00 // 00dddddd, step, 6 bit signed 2nd difference
+#define STR_OP_RUN              0x40 // 01nnnnnn, n+1 steps with zero 2nd difference
+#define STR_OP_DD_LONG          0x80 // 10dddddd dddddddd, step, 14 bit signed 2nd difference
+#define STR_OP_DIR_FWD          0xC0 // the next steps are forward
+#define STR_OP_DIR_BACK         0xC1 // the next steps are backward
+#define STR_OP_SET              0xC2 // + 32 bit little endian interval, step, 1st difference = 0
+#define STR_OP_WAIT             0xC3 // + 32 bit little endian ticks without a step, the differences stay
+#define STR_OP_END              0xFF // the stream end
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// stream decoding errors, the stream is ended by them
+enum STR_ERR_t
+{
+  STR_OK = 0,
+  STR_ERR_CODE, // unknown code
+  STR_ERR_LIMIT // the next step is out of the soft limits
+};
+
+// axis stream decoder data structure
+struct STR_t
+{
+  uint8_t             fifo[STR_FIFO_SIZE];
+  volatile uint16_t   head; // the next byte to decode
+  volatile uint16_t   tail; // the next free byte
+  uint16_t            scan; // the next code to check for the stream end
+  uint8_t             ends; // stream ends in the FIFO
+  int8_t              dir;
+  int32_t             pos; // axis position after the decoded steps
+  int32_t             interval; // the last step interval, ticks
+  int32_t             delta; // 1st difference, ticks
+  uint8_t             run; // steps left of the run
+  uint8_t             error; // STR_ERR_t
+  uint32_t            steps; // decoded steps
+  uint32_t            cycles; // CPU clocks of the decoding
+};
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+void STR_init(void);
+uint16_t STR_free(uint8_t axis);
+enum GEN_ERR_t STR_write(uint8_t axis, const uint8_t* data, uint16_t len);
+enum GEN_ERR_t STR_start(uint8_t axes_mask);
+uint32_t STR_decode_rate(uint8_t axis);
+
+
+
+
+#endif /* __STREAM_H */
@@ -0,0 +1,91 @@
+/**
+  ******************************************************************************
+  * File Name          : telemetry.h
+  * Description        : axes telemetry stream settings
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+
+
+
+/* settings ------------------------------------------------------------------*/
+
+#define TLM_RATE                100 // Hz, default frames rate
+#define TLM_SPI_CLK             4500000 // Hz, SPI2 clock, APB1 36 MHz / 8 of MX_SPI2_Init()
+// Hz, the frame transfer takes a half of the frame period at most,
+// the frame is 195 bytes now, 1560 bits are 347 us at the SPI2 clock
+#define TLM_RATE_MAX            (TLM_SPI_CLK / (2 * 8 * sizeof(struct TLM_FRAME_t)))
+#define TLM_SYNC                0x5A // frame start byte
+#define TLM_DMA                 DMA1_Channel5 // SPI2_TX request channel
+#define TLM_DMA_IFCR            DMA_IFCR_CGIF5
+
+// frame: TLM_FRAME_t, little endian, the last byte is xor of all the bytes before
+
+
+
+
+/* var types -----------------------------------------------------------------*/
+
+// axis telemetry data
+struct __attribute__((packed)) TLM_AXIS_t
+{
+  int32_t             pos; // steps
+  int32_t             vel; // steps/s, average since the previous frame
+  uint16_t            depth; // profile periods filled and not played
+  uint32_t            underruns; // profile ring halves played silent
+  uint32_t            isr_cnt; // DMA IRQ handlers count
+  uint32_t            isr_max; // CPU clocks, the longest DMA IRQ handler
+  uint32_t            late_stops; // constant frequency outputs stopped after the next pulse start
+  uint16_t            seg; // the last output id
+  uint16_t            verify_seg; // the last output with the wrong step pulses count (0 = none)
+  int32_t             verify_diff; // its counted minus commanded pulses
+  uint32_t            verify_errors; // outputs with the wrong step pulses count
+  uint32_t            decode_rate; // steps/s of the CPU time, the stream decoder throughput (0 = no stream yet)
+};
+
+// telemetry frame
+struct __attribute__((packed)) TLM_FRAME_t
+{
+  uint8_t             sync;
+  uint8_t             seq; // frame counter, a gap is the skipped frames
+  uint16_t            len; // frame size, bytes
+  uint32_t            time; // ms
+  struct TLM_AXIS_t   axis[GEN_AXIS_CNT];
+  uint32_t            cache_hits; // computed ramps cache
+  uint32_t            cache_misses;
+  uint32_t            starves; // profile sources starvation events
+  uint32_t            starve_time; // ms, the last starvation start
+  uint8_t             starving; // the profile outputs of a starving source axes group are slowed down
+  uint8_t             dma_load; // %, projected DMA bus load of the running outputs
+  uint8_t             sum;
+};
+
+// telemetry stream statistics
+struct TLM_STAT_t
+{
+  uint32_t            sent;
+  uint32_t            skipped; // the previous frame was still sent at the frame time
+};
+
+
+
+
+/* functions -----------------------------------------------------------------*/
+
+void TLM_init(void);
+void TLM_process(void);
+void TLM_rate_set(uint16_t hz);
+const struct TLM_STAT_t* TLM_stat(void);
+
+
+
+
+#endif /* __TELEMETRY_H */
@@ -0,0 +1,358 @@
+/**
+  ******************************************************************************
+  * File Name          : arc.c
+  * Description        : circular/helical arc interpolation functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "arc.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+// pseudo-angle of the quarter circle
+#define ARC_QUARTER 0x10000
+
+// plane moves, the moves estimate error of the short arcs, they don't leave the end point
+#define ARC_END_MARGIN 4
+
+// steps sources data of the output axes, the arcs of the other axes run at the same time
+static struct ARC_AXIS_t arcs[GEN_AXIS_CNT] = {{{0},0,0,0}};
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+static uint32_t ARC_abs(int32_t v)
+{
+  return v < 0 ? -(uint32_t)v : (uint32_t)v;
+}
+
+static int8_t ARC_sign(int32_t v)
+{
+  return v > 0 ? 1 : v < 0 ? -1 : 0;
+}
+
+/*
+ * pseudo-angle of the point, 0..4*ARC_QUARTER counterclockwise from the 1st axis
+ *
+ * it has the same order as the angle, so it's enough to find the crossed extremes
+ */
+static uint32_t ARC_angle(int32_t x, int32_t y)
+{
+  uint64_t ax = ARC_abs(x), ay = ARC_abs(y);
+
+  if ( x > 0 && y >= 0 ) return (uint32_t)(ay * ARC_QUARTER / (ax + ay));
+  if ( x <= 0 && y > 0 ) return (uint32_t)(ARC_QUARTER + ax * ARC_QUARTER / (ax + ay));
+  if ( x < 0 && y <= 0 ) return (uint32_t)(2*ARC_QUARTER + ay * ARC_QUARTER / (ax + ay));
+  return (uint32_t)(3*ARC_QUARTER + ax * ARC_QUARTER / (ax + ay));
+}
+
+/*
+ * circle error of the point, it's 0 at the circle
+ */
+static int64_t ARC_error(const struct ARC_WALK_t* w, int32_t x, int32_t y)
+{
+  int64_t e = (int64_t)x*x + (int64_t)y*y - w->r2;
+
+  return e < 0 ? -e : e;
+}
+
+/*
+ * the next arc move
+ *
+ * the move is one step along the tangent for one or both plane axes,
+ * the nearest point to the circle is taken. Returns 0 at the arc end
+ */
+static uint8_t ARC_walk(struct ARC_WALK_t* w, int8_t* dx, int8_t* dy, int8_t* dz)
+{
+  int8_t  sx, sy;
+  int64_t e, best;
+
+  if ( w->done )
+  {
+    *dx = 0;
+    *dy = 0;
+  }
+  else if ( ((w->away || w->walked + ARC_END_MARGIN >= w->moves) &&
+              ARC_abs(w->xe - w->x) <= 1 && ARC_abs(w->ye - w->y) <= 1) || !w->left )
+  {
+    // the last moves go straight to the end point, the walk is done there only.
+    // The end point next to the start one is reached after the walk left it,
+    // or after the estimated moves of the short arc
+    *dx = ARC_sign(w->xe - w->x);
+    *dy = ARC_sign(w->ye - w->y);
+    w->done = w->x + *dx == w->xe && w->y + *dy == w->ye;
+  }
+  else
+  {
+    --w->left;
+
+    // tangent direction
+    sx = ARC_sign(w->cw ? w->y : -w->y);
+    sy = ARC_sign(w->cw ? -w->x : w->x);
+
+    *dx = sx;
+    *dy = 0;
+    best = sx ? ARC_error(w, w->x + sx, w->y) : INT64_MAX;
+
+    if ( sy && (e = ARC_error(w, w->x, w->y + sy)) < best )
+    {
+      *dx = 0;
+      *dy = sy;
+      best = e;
+    }
+
+    if ( sx && sy && ARC_error(w, w->x + sx, w->y + sy) < best )
+    {
+      *dx = sx;
+      *dy = sy;
+    }
+  }
+
+  if ( !*dx && !*dy )
+  {
+    // the plane end is reached, the helix steps left by the moves estimate finish the arc
+    if ( !w->zleft ) return 0;
+    --w->zleft;
+    *dz = w->zdir;
+    return 1;
+  }
+
+  w->x += *dx;
+  w->y += *dy;
+  ++w->walked;
+  if ( ARC_abs(w->xe - w->x) > 1 || ARC_abs(w->ye - w->y) > 1 ) w->away = 1;
+
+  // helix steps are spread over the plane moves
+  *dz = 0;
+  if ( w->zleft )
+  {
+    w->zacc += w->nz;
+    if ( w->zacc >= w->moves )
+    {
+      w->zacc -= w->moves;
+      --w->zleft;
+      *dz = w->zdir;
+    }
+  }
+
+  return 1;
+}
+
+/*
+ * Chebyshev distance of the points, the walk moves between them
+ */
+static uint32_t ARC_cheb(int32_t dx, int32_t dy)
+{
+  return ARC_abs(dx) > ARC_abs(dy) ? ARC_abs(dx) : ARC_abs(dy);
+}
+
+/*
+ * plane moves of the arc from the pseudo-angle a0 along the span
+ *
+ * the walk moves the axis along the tangent by one step every move, it's the
+ * same axis inside the octant. So the moves are the Chebyshev distances between
+ * the crossed octant borders, the walk differs by a few moves at the borders
+ */
+static uint32_t ARC_moves(const struct ARC_WALK_t* w, uint32_t a0, uint32_t span)
+{
+  // the octant borders counterclockwise from the 1st axis, 2 = radius, 1 = radius/sqrt(2)
+  static const int8_t ox[8] = {2, 1, 0, -1, -2, -1, 0, 1};
+  static const int8_t oy[8] = {0, 1, 2, 1, 0, -1, -2, -1};
+  int32_t   r = (int32_t)GEN_isqrt(w->r2), d = (int32_t)GEN_isqrt(w->r2 / 2);
+  int32_t   x = w->x, y = w->y, bx, by;
+  uint32_t  part = a0 % (ARC_QUARTER/2), dist, moves = 0;
+  uint8_t   k = a0 / (ARC_QUARTER/2);
+
+  // the first border on the way
+  if ( w->cw )
+  {
+    dist = part ? part : ARC_QUARTER/2;
+    if ( !part ) k = (k + 7) & 7;
+  }
+  else
+  {
+    dist = ARC_QUARTER/2 - part;
+    k = (k + 1) & 7;
+  }
+
+  for ( ; dist < span; dist += ARC_QUARTER/2 )
+  {
+    bx = ox[k] & 1 ? ox[k] * d : ox[k] / 2 * r;
+    by = oy[k] & 1 ? oy[k] * d : oy[k] / 2 * r;
+    moves += ARC_cheb(bx - x, by - y);
+    x = bx;
+    y = by;
+    k = (k + (w->cw ? 7 : 1)) & 7;
+  }
+
+  return moves + ARC_cheb(w->xe - x, w->ye - y);
+}
+
+/*
+ * arc axis steps source
+ *
+ * every axis walks the whole arc and takes its own steps,
+ * so the steps of all axes are at the same arc time
+ */
+static uint32_t ARC_source(void* ctx, int8_t* dir)
+{
+  struct ARC_AXIS_t*  a = ctx;
+  int8_t              d[3];
+  uint32_t            ticks;
+
+  while ( ARC_walk(&a->walk, &d[0], &d[1], &d[2]) )
+  {
+    a->now += d[0] && d[1] ? a->walk.td : a->walk.t1;
+
+    if ( d[a->role] )
+    {
+      *dir = d[a->role];
+      ticks = (uint32_t)((a->now >> 8) - a->last);
+      a->last = a->now >> 8;
+      return ticks;
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * start the arc motion from the current position
+ *
+ * the feed is the plane path steps frequency, the helix axis moves
+ * linearly with the plane path. The arc must end on the circle
+ */
+enum GEN_ERR_t ARC_start(const struct ARC_t* arc)
+{
+  struct ARC_WALK_t   w = {0};
+  uint8_t             ax[3] = {arc->ax, arc->ay, arc->az};
+  uint8_t             cnt = arc->az == GEN_AXIS_NONE ? 2 : 3;
+  uint8_t             mask = 0;
+  uint8_t             n, k;
+  int32_t             cx, cy, zn;
+  int64_t             re2;
+  uint32_t            rmax, rext, a0, a1, from, span;
+  uint8_t             full;
+  enum GEN_ERR_t      err;
+
+  if ( arc->ax >= GEN_AXIS_CNT || arc->ay >= GEN_AXIS_CNT || arc->ax == arc->ay ) return GEN_ERR_AXIS;
+  if ( cnt == 3 && (arc->az >= GEN_AXIS_CNT || arc->az == arc->ax || arc->az == arc->ay) )
+  {
+    return GEN_ERR_AXIS;
+  }
+
+  // the arc has no ramp, it runs at the feed from the start to the end
+  for ( n = 0; n < cnt; ++n )
+  {
+    err = GEN_move_check(ax[n], 1, 1, arc->feed);
+    if ( err != GEN_OK && err != GEN_ERR_LIMIT ) return err;
+  }
+
+  // the walk is relative to the centre
+  cx = GEN_position_get(arc->ax) + arc->i;
+  cy = GEN_position_get(arc->ay) + arc->j;
+  w.x = -arc->i;
+  w.y = -arc->j;
+  w.xe = arc->xe - cx;
+  w.ye = arc->ye - cy;
+
+  if ( ARC_abs(w.x) > ARC_RADIUS_MAX || ARC_abs(w.y) > ARC_RADIUS_MAX ||
+       ARC_abs(w.xe) > ARC_RADIUS_MAX || ARC_abs(w.ye) > ARC_RADIUS_MAX )
+  {
+    return GEN_ERR_ARC;
+  }
+
+  w.r2 = (int64_t)w.x*w.x + (int64_t)w.y*w.y;
+  re2 = (int64_t)w.xe*w.xe + (int64_t)w.ye*w.ye;
+  rmax = ARC_abs(w.x) > ARC_abs(w.y) ? ARC_abs(w.x) : ARC_abs(w.y);
+
+  // the end point radius must be within a half step of the start point radius
+  if ( !w.r2 || (re2 > w.r2 ? re2 - w.r2 : w.r2 - re2) > rmax ) return GEN_ERR_ARC;
+
+  w.cw = arc->cw ? 1 : 0;
+  // the end point at the start point is the full circle
+  full = w.x == w.xe && w.y == w.ye;
+  // the full circle is 8 radii of moves max
+  w.left = 16*rmax + 16;
+  w.t1 = ((uint64_t)GEN_tim_freq_get(arc->ax) << 8) / arc->feed;
+  // sqrt(2) = 46341/32768
+  w.td = w.t1 * 46341 >> 15;
+
+  // soft limits at the end points and the circle extremes crossed by the arc
+  if ( (err = GEN_limits_check(arc->ax, arc->xe)) != GEN_OK ) return err;
+  if ( (err = GEN_limits_check(arc->ay, arc->ye)) != GEN_OK ) return err;
+  if ( cnt == 3 && (err = GEN_limits_check(arc->az, arc->ze)) != GEN_OK ) return err;
+
+  rext = GEN_isqrt(w.r2) + 1;
+  a0 = ARC_angle(w.x, w.y);
+  a1 = ARC_angle(w.xe, w.ye);
+  from = w.cw ? a1 : a0;
+  span = (w.cw ? a0 - a1 : a1 - a0) & (4*ARC_QUARTER - 1);
+
+  for ( k = 0; k < 4; ++k )
+  {
+    if ( !full && ((k*ARC_QUARTER - from) & (4*ARC_QUARTER - 1)) >= span ) continue;
+
+    switch ( k )
+    {
+      case 0: err = GEN_limits_check(arc->ax, cx + (int32_t)rext); break;
+      case 1: err = GEN_limits_check(arc->ay, cy + (int32_t)rext); break;
+      case 2: err = GEN_limits_check(arc->ax, cx - (int32_t)rext); break;
+      default: err = GEN_limits_check(arc->ay, cy - (int32_t)rext); break;
+    }
+
+    if ( err != GEN_OK ) return err;
+  }
+
+  w.moves = ARC_moves(&w, a0, full ? 4*ARC_QUARTER : span);
+
+  if ( cnt == 3 )
+  {
+    // the helix steps are spread over the plane moves, the steps left
+    // by the estimate error are at the arc end
+    zn = arc->ze - GEN_position_get(arc->az);
+    w.nz = ARC_abs(zn);
+    w.zleft = w.nz;
+    w.zdir = zn < 0 ? -1 : 1;
+    w.zacc = w.moves / 2;
+
+    // one helix step per plane move max
+    if ( w.nz > w.moves ) return GEN_ERR_STEPS;
+  }
+
+  // the axes are checked not busy, their data isn't used by a running arc
+  for ( n = 0; n < cnt; ++n )
+  {
+    arcs[ax[n]].walk = w;
+    arcs[ax[n]].role = n;
+    arcs[ax[n]].now = 0;
+    arcs[ax[n]].last = 0;
+
+    err = GEN_profile_set(ax[n], ARC_source, &arcs[ax[n]]);
+    if ( err != GEN_OK )
+    {
+      // release the prepared axes
+      while ( n-- ) GEN_stop(ax[n]);
+      return err;
+    }
+
+    mask |= 1 << ax[n];
+  }
+
+  GEN_profile_start(mask);
+
+  return GEN_OK;
+}
@@ -0,0 +1,228 @@
+/**
+  ******************************************************************************
+  * File Name          : follow.c
+  * Description        : step/dir input re-generator functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "follow.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+#define FOL_MASK (FOL_FIFO_SIZE - 1)
+
+// axes input re-generators data array
+static struct FOL_t follows[GEN_AXIS_CNT] = {0};
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * take the next sample to the moving average and get its output steps
+ *
+ * returns 0 if there is no sample yet
+ */
+static uint8_t FOL_sample(struct FOL_t* f)
+{
+  int64_t q = (int64_t)f->avg * f->den;
+  int64_t steps;
+  int32_t n = 0;
+
+  if ( f->head != f->tail )
+  {
+    n = f->fifo[f->head];
+    f->head = (f->head + 1) & FOL_MASK;
+  }
+  // the stopped input is the steps left out of the FIFO, then zeros flush the filter
+  else if ( f->stop )
+  {
+    n = f->carry > INT16_MAX ? INT16_MAX : f->carry < -INT16_MAX ? -INT16_MAX : f->carry;
+    f->carry -= n;
+  }
+  else return 0;
+
+  f->sum += n - f->hist[f->hist_i];
+  f->hist[f->hist_i] = n;
+  if ( ++f->hist_i >= f->avg ) f->hist_i = 0;
+
+  f->acc += (int64_t)f->sum * f->num;
+  steps = f->acc / q;
+
+  // the steps over the max frequency are done later
+  if ( steps > GEN_FREQ_MAX / GEN_SYSTICK_IRQ_FREQ ) steps = GEN_FREQ_MAX / GEN_SYSTICK_IRQ_FREQ;
+  if ( steps < -(GEN_FREQ_MAX / GEN_SYSTICK_IRQ_FREQ) ) steps = -(GEN_FREQ_MAX / GEN_SYSTICK_IRQ_FREQ);
+  f->acc -= steps * q;
+
+  f->dir = steps < 0 ? -1 : 1;
+  f->steps = steps < 0 ? -steps : steps;
+  f->slots = f->steps > FOL_SPLIT ? f->steps : FOL_SPLIT;
+  f->slot = 0;
+
+  return 1;
+}
+
+/*
+ * input re-generator, the output axis steps source
+ *
+ * the sample time is split to the equal periods, the short periods
+ * of the slow speed keep the profile ring time and the lag short
+ */
+static uint32_t FOL_source(void* ctx, int8_t* dir)
+{
+  struct FOL_t* f = ctx;
+  uint32_t      j;
+
+  if ( f->slot >= f->slots )
+  {
+    // the filter is empty, less than a step is left
+    if ( f->stop && f->head == f->tail && !f->carry && !f->sum &&
+         (f->acc < 0 ? -f->acc : f->acc) < (int64_t)f->avg * f->den )
+    {
+      f->on = 0;
+      return 0;
+    }
+
+    if ( !FOL_sample(f) ) return GEN_PRF_WAIT;
+  }
+
+  j = f->slot++;
+  *dir = (uint64_t)f->slot * f->steps / f->slots != (uint64_t)j * f->steps / f->slots ? f->dir : 0;
+
+  return (uint64_t)f->slot * f->ticks / f->slots - (uint64_t)j * f->ticks / f->slots;
+}
+
+/*
+ * release the input of the aborted re-generator
+ *
+ * GEN_stop() ends the output without the source end,
+ * the output axis isn't busy while the re-generator is on
+ */
+static void FOL_abort_check(uint8_t axis)
+{
+  struct FOL_t* f = &follows[axis];
+
+  if ( !f->on || GEN_busy(axis) ) return;
+
+  f->on = 0;
+  if ( !f->stop ) GEN_input_off(f->input);
+}
+
+/*
+ * re-generate the input axis step/dir at the axis output
+ *
+ * num/den is the output steps per input step, avg is the speed
+ * moving average length in the systick periods
+ */
+enum GEN_ERR_t FOL_start(uint8_t axis, uint8_t input, uint32_t num, uint32_t den, uint8_t avg)
+{
+  struct FOL_t*   f;
+  enum GEN_ERR_t  err;
+
+  if ( axis >= GEN_AXIS_CNT || input >= GEN_AXIS_CNT || axis == input ) return GEN_ERR_AXIS;
+  if ( !num || !den || !avg || avg > FOL_AVG_MAX ) return GEN_ERR_FREQ;
+  // the running re-generator data must stay intact
+  FOL_abort_check(axis);
+  if ( follows[axis].on || GEN_busy(axis) ) return GEN_ERR_BUSY;
+
+  err = GEN_input_set(input);
+  if ( err != GEN_OK ) return err;
+
+  f = &follows[axis];
+
+  f->input = input;
+  f->num = num;
+  f->den = den;
+  f->avg = avg;
+  f->hist_i = 0;
+  f->sum = 0;
+  f->carry = 0;
+  f->acc = 0;
+  f->ticks = GEN_tim_freq_get(axis) / GEN_SYSTICK_IRQ_FREQ;
+  f->steps = 0;
+  f->slots = 0;
+  f->slot = 0;
+  f->stop = 0;
+  for ( uint8_t i = 0; i < FOL_AVG_MAX; ++i ) f->hist[i] = 0;
+
+  // the output starts with the empty samples, the ring is filled ahead of the input
+  for ( uint16_t i = 0; i < FOL_DELAY; ++i ) f->fifo[i] = 0;
+  f->head = 0;
+  f->tail = FOL_DELAY;
+
+  err = GEN_profile_set(axis, FOL_source, f);
+  if ( err != GEN_OK )
+  {
+    GEN_input_off(input);
+    return err;
+  }
+
+  f->on = 1;
+  GEN_profile_start(1 << axis);
+
+  return GEN_OK;
+}
+
+/*
+ * stop the input sampling of the axis re-generator
+ *
+ * the sampled steps are output, so the output stops smoothly
+ * with the moving average length
+ */
+void FOL_stop(uint8_t axis)
+{
+  if ( axis >= GEN_AXIS_CNT ) return;
+
+  FOL_abort_check(axis);
+  if ( !follows[axis].on || follows[axis].stop ) return;
+
+  follows[axis].stop = 1;
+  GEN_input_off(follows[axis].input);
+}
+
+
+
+
+/* Handlers ------------------------------------------------------------------*/
+
+/*
+ * sample the inputs steps
+ *
+ * uses in the SysTick_Handler()
+ */
+void FOL_SYSTICK_IRQHandler(void)
+{
+  struct FOL_t* f;
+  uint16_t      next;
+  int32_t       n;
+
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    f = &follows[axis];
+    FOL_abort_check(axis);
+    if ( !f->on || f->stop ) continue;
+
+    f->carry += GEN_input_get(f->input);
+
+    // the output is late, the steps wait for the free sample, so they aren't lost
+    next = (f->tail + 1) & FOL_MASK;
+    if ( next == f->head ) continue;
+
+    n = f->carry > INT16_MAX ? INT16_MAX : f->carry < -INT16_MAX ? -INT16_MAX : f->carry;
+    f->carry -= n;
+    f->fifo[f->tail] = n;
+    f->tail = next;
+  }
+}
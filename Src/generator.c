@@ -13,13 +13,14 @@
 
 #include "stm32f1xx_hal.h"
 #include "generator.h"
+#include "homing.h"
 
 
 
 
 /* Global vars ---------------------------------------------------------------*/
 
-#define TEST_1_ENABLED 1
+#define TEST_1_ENABLED 0 // the bench steps bursts at all axes, they bypass the motion checks
 
 // array uses by axis DMA channels
 static uint8_t DMA_array[GEN_AXIS_CNT][GEN_DMA_ARRAY_SIZE] = {{0}};
@@ -29,112 +30,2165 @@ extern TIM_HandleTypeDef htim1;
 extern TIM_HandleTypeDef htim2;
 extern TIM_HandleTypeDef htim3;
 extern TIM_HandleTypeDef htim4;
-extern DMA_HandleTypeDef hdma_tim1_ch1;
-extern DMA_HandleTypeDef hdma_tim2_ch1;
+extern DMA_HandleTypeDef hdma_tim1_ch4_trig_com;
+extern DMA_HandleTypeDef hdma_tim2_ch2_ch4;
 extern DMA_HandleTypeDef hdma_tim3_ch1_trig;
 extern DMA_HandleTypeDef hdma_tim4_ch1;
 
 // axis data array
+// TIM1_CH1 and TIM2_CH1 requests share the channels with SPI1_RX and SPI2_TX,
+// so these axes use the CC4 requests
 static struct AXIS_t axes[GEN_AXIS_CNT] =
 {
-  {&htim1,  &hdma_tim1_ch1,      72000000,0,0,0,0},
-  {&htim2,  &hdma_tim2_ch1,      72000000,0,0,0,0},
-  {&htim3,  &hdma_tim3_ch1_trig, 72000000,0,0,0,0},
-  {&htim4,  &hdma_tim4_ch1,      72000000,0,0,0,0}
+  {&htim1,  &hdma_tim1_ch4_trig_com, TIM_DMA_CC4, 72000000,0,0,0,0,0,0,GEN_AXIS_NONE,0,1,0,0,0,0,0,0,0},
+  {&htim2,  &hdma_tim2_ch2_ch4,      TIM_DMA_CC4, 72000000,0,0,0,0,0,0,GEN_AXIS_NONE,0,1,0,0,0,0,0,0,0},
+  {&htim3,  &hdma_tim3_ch1_trig,     TIM_DMA_CC1, 72000000,0,0,0,0,0,0,GEN_AXIS_NONE,0,1,0,0,0,0,0,0,0},
+  {&htim4,  &hdma_tim4_ch1,          TIM_DMA_CC1, 72000000,0,0,0,0,0,0,GEN_AXIS_NONE,0,1,0,0,0,0,0,0,0}
 };
 
+// axes motion limits
+static struct LIMITS_t limits[GEN_AXIS_CNT] = {{0}};
 
+// axes backlash compensation
+static struct BACKLASH_t backlash[GEN_AXIS_CNT] = {{0}};
 
+// slave timer's trigger selection to get the master timer's TRGO
+// [slave axis][master axis], the axes[] timers order TIM1..TIM4
+static const uint32_t GEN_ITR[4][4] =
+{
+  {0,           TIM_TS_ITR1, TIM_TS_ITR2, TIM_TS_ITR3},
+  {TIM_TS_ITR0, 0,           TIM_TS_ITR2, TIM_TS_ITR3},
+  {TIM_TS_ITR0, TIM_TS_ITR1, 0,           TIM_TS_ITR3},
+  {TIM_TS_ITR0, TIM_TS_ITR1, TIM_TS_ITR2, 0          }
+};
+
+// axes step outputs pins, the axes[] timers order TIM1..TIM4
+static GPIO_TypeDef* const GEN_STEP_PORT[4] = {GPIOA, GPIOA, GPIOB, GPIOB};
+static const uint16_t GEN_STEP_PIN[4] = {GPIO_PIN_8, GPIO_PIN_0, GPIO_PIN_4, GPIO_PIN_6};
+// axes direction outputs pins, the same ports
+static const uint16_t GEN_DIR_PIN[4] = {GPIO_PIN_9, GPIO_PIN_1, GPIO_PIN_5, GPIO_PIN_7};
+
+// axes step pulses self-verification
+static struct VERIFY_t verify[GEN_AXIS_CNT] =
+{
+  {GEN_AXIS_NONE,0,0,0,0,0,0,0,0},
+  {GEN_AXIS_NONE,0,0,0,0,0,0,0,0},
+  {GEN_AXIS_NONE,0,0,0,0,0,0,0,0},
+  {GEN_AXIS_NONE,0,0,0,0,0,0,0,0}
+};
+
+// DMA channels settings of the constant frequency output
+static uint32_t dma_ccr[GEN_AXIS_CNT] = {0};
+
+// profile DMA rings, every period is the timer's PSC, ARR, RCR, CCR1, CCR2 burst,
+// the TIM1 period is repeated RCR + 1 times
+#define PRF_RING_SIZE (2*GEN_PRF_HALF_SIZE)
+static uint16_t PRF_ring[GEN_AXIS_CNT][PRF_RING_SIZE][5] = {{{0}}};
+// ring periods steps, 1 = forward step, -1 = backward step, 0 = no step, every repetition,
+// 2 and -2 are the backlash take-up pulses, they aren't in the position
+#define PRF_LASH 2
+#define PRF_POS(s) ((s) == PRF_LASH || (s) == -PRF_LASH ? 0 : (s))
+#define GEN_SLACK_NONE 0xFFFF
+static int8_t PRF_step[GEN_AXIS_CNT][PRF_RING_SIZE] = {{0}};
+// the next ring half data, it's filled before the half is free
+static uint16_t PRF_stage[GEN_AXIS_CNT][GEN_PRF_HALF_SIZE][5] = {{{0}}};
+static int8_t PRF_stage_step[GEN_AXIS_CNT][GEN_PRF_HALF_SIZE] = {{0}};
+
+// axes profile output data
+static struct PRF_t profile[GEN_AXIS_CNT] = {{0}};
+
+// feed override, %
+static uint16_t ovr_req = 100; // requested global override
+static uint16_t ovr_cur = 100; // global override, it slews to the requested one
+
+// the profile sources starvation, the profile outputs of the starving
+// source axes group are slowed down to GEN_OVR_MIN
+static uint8_t  starve_on = 0;
+static uint32_t starves = 0; // starvation events
+static uint32_t starve_time = 0; // ms, the last starvation start
+static uint16_t axis_ovr_req[GEN_AXIS_CNT] = {100, 100, 100, 100};
+// the next profile of the axis isn't scaled by the overrides
+static uint8_t  exact_req[GEN_AXIS_CNT] = {0};
+
+// axes DMA IRQ handlers timing
+static struct GEN_ISR_STAT_t isr_stat[GEN_AXIS_CNT] = {{0}};
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * step pulse width in the prescaled timer ticks
+ *
+ * the pulse width doesn't depend on the step rate,
+ * it's clamped to 1..period-1 to keep the low level between steps
+ */
+static uint32_t GEN_pulse_ticks(uint8_t axis, uint32_t presc, uint32_t period)
+{
+  uint32_t ticks;
+
+  // no pulse width was set, use 50% duty
+  if ( !axes[axis].pulse_ns ) return period/2;
+
+  // round up, the pulse must not be shorter than requested
+  ticks = (axes[axis].pulse_clk + presc) / (presc + 1);
+
+  if ( ticks >= period ) ticks = period - 1;
+  if ( !ticks ) ticks = 1;
+
+  return ticks;
+}
+
+/*
+ * disable the steps output hardware after the output end
+ */
+static void GEN_output_finish(uint8_t axis)
+{
+  /* Disable the TIM Capture/Compare DMA request */
+  __HAL_TIM_DISABLE_DMA(axes[axis].htim, axes[axis].dma_req);
+  /* Disable the Capture compare channel */
+  TIM_CCxChannelCmd(axes[axis].htim->Instance, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+  if ( axes[axis].mode == GEN_MODE_CW_CCW )
+  {
+    TIM_CCxChannelCmd(axes[axis].htim->Instance, TIM_CHANNEL_2, TIM_CCx_DISABLE);
+  }
+  // the Main Output stays enabled, it drives the direction output
+
+  // set the CR1 timer enable bit in the DMA array cell
+  DMA_array[axis][axes[axis].steps - 1] |= (TIM_CR1_CEN);
+}
+
+/*
+ * stop the geared slaves of the master axis
+ *
+ * uses before the master's counter reset, the master's OC1REF is high after it
+ */
+static void GEN_gear_pause(uint8_t master)
+{
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( axes[axis].gear_master == master )
+    {
+      axes[axis].htim->Instance->CR1 &= ~(TIM_CR1_CEN);
+    }
+  }
+}
+
+/*
+ * apply the master's prescaler to the geared slaves and restart them
+ *
+ * slave's counter keeps the fraction of the slave step, so the ratio
+ * stays exact through any number of the master's frequency changes
+ */
+static void GEN_gear_resume(uint8_t master)
+{
+  TIM_TypeDef*  tim;
+  uint32_t      cnt;
+
+  // close the gate, the next master's tick starts a new pulse
+  axes[master].htim->Instance->CNT = axes[master].period - 1;
+
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( axes[axis].gear_master != master ) continue;
+
+    tim = axes[axis].htim->Instance;
+
+    if ( tim->PSC != axes[master].presc )
+    {
+      cnt = tim->CNT;
+      // the Update event resets the counter, don't let it make a pulse
+      tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M)) | TIM_OCMODE_FORCED_INACTIVE;
+      tim->PSC = axes[master].presc;
+      tim->EGR = TIM_EGR_UG;
+      tim->CNT = cnt;
+      tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M)) | TIM_OCMODE_PWM1;
+    }
+
+    tim->CR1 |= (TIM_CR1_CEN);
+  }
+}
+
+/*
+ * add the checker's counted edges to the axis pulses
+ *
+ * the 16 bit counter is read at least every systick, so it doesn't wrap
+ */
+static void GEN_verify_count(uint8_t axis)
+{
+  struct VERIFY_t*  v = &verify[axis];
+  uint32_t          primask;
+  uint16_t          cnt;
+
+  if ( v->checker == GEN_AXIS_NONE ) return;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  cnt = axes[v->checker].htim->Instance->CNT;
+  v->pulses += (uint16_t)(cnt - v->cnt);
+  v->cnt = cnt;
+  __set_PRIMASK(primask);
+}
+
+/*
+ * start the pulses count of the new axis output
+ */
+static void GEN_verify_start(uint8_t axis)
+{
+  // 0 is no output id
+  if ( !++verify[axis].seg ) verify[axis].seg = 1;
+
+  GEN_verify_count(axis);
+  verify[axis].start = verify[axis].pulses;
+}
+
+/*
+ * compare the counted pulses with the commanded ones at the output end
+ */
+static void GEN_verify_check(uint8_t axis, uint32_t pulses)
+{
+  struct VERIFY_t* v = &verify[axis];
+
+  if ( v->checker == GEN_AXIS_NONE ) return;
+
+  GEN_verify_count(axis);
+  if ( v->pulses - v->start == pulses ) return;
+
+  v->bad_seg = v->seg;
+  v->bad_diff = (int32_t)(v->pulses - v->start - pulses);
+  ++v->errors;
+}
+
+/*
+ * source time of the override step, ticks
+ *
+ * the step changes the axis speed inside its acceleration limit,
+ * the speed is the last source interval one. The step of one override
+ * is scaled by the other one, ovr and axis_ovr are the faster sides
+ * of the step
+ */
+static uint64_t GEN_override_gap(uint8_t axis, uint16_t ovr, uint16_t axis_ovr, uint16_t scale)
+{
+  struct PRF_t* prf = &profile[axis];
+  uint64_t      us = GEN_OVR_GAP_US;
+  uint32_t      dv;
+
+  if ( limits[axis].accel && prf->src_len )
+  {
+    // Hz, the speed change of the step
+    dv = axes[axis].tim_freq / prf->src_len * GEN_OVR_STEP * scale / 10000;
+    us = (uint64_t)dv * 1000000 / limits[axis].accel;
+  }
+
+  // the source time runs at the override speed
+  return us * (axes[axis].tim_freq / 1000000) * ovr * axis_ovr / 10000;
+}
+
+/*
+ * axis override slew
+ *
+ * the step is at the source time which keeps the axis acceleration limit
+ * like the global override step, the fetched intervals are at the new override
+ */
+static void GEN_axis_override_slew(uint8_t axis)
+{
+  struct PRF_t* prf = &profile[axis];
+  uint16_t      req = axis_ovr_req[axis];
+  uint16_t      prev = prf->axis_ovr;
+
+  if ( prf->exact || prev == req || prf->src_time < prf->axis_ovr_at ) return;
+
+  if ( prev < req ) prf->axis_ovr = prev + GEN_OVR_STEP < req ? prev + GEN_OVR_STEP : req;
+  else prf->axis_ovr = prev > req + GEN_OVR_STEP ? prev - GEN_OVR_STEP : req;
+
+  prf->axis_ovr_at = prf->src_time +
+    GEN_override_gap(axis, prf->ovr, prev > prf->axis_ovr ? prev : prf->axis_ovr, prf->ovr);
+}
+
+/*
+ * scale the source interval by the feed override
+ *
+ * the global override changes at the same source time for all axes started
+ * together, so the override doesn't break the contour synchronization
+ */
+static uint64_t GEN_profile_warp(struct PRF_t* prf, uint32_t dt)
+{
+  uint64_t  end = prf->src_time + dt;
+  uint64_t  part, out;
+  uint32_t  a = prf->axis_ovr;
+
+  // the exact rate source time is the output time
+  if ( prf->exact )
+  {
+    prf->src_time = end;
+    return dt;
+  }
+
+  if ( prf->ovr_pending && end >= prf->ovr_at )
+  {
+    part = prf->ovr_at > prf->src_time ? prf->ovr_at - prf->src_time : 0;
+    prf->real_time += part * 2560000 / (prf->ovr * a);
+    prf->ovr = prf->ovr_next;
+    prf->ovr_pending = 0;
+    dt -= part;
+  }
+
+  // 1/256 ticks, 100% * 100% = 10000
+  prf->real_time += (uint64_t)dt * 2560000 / (prf->ovr * a);
+  prf->src_time = end;
+
+  // the override below 100% makes the interval longer than 32 bits
+  out = (prf->real_time >> 8) - prf->out_time;
+  prf->out_time = prf->real_time >> 8;
+
+  return out;
+}
+
+/*
+ * backlash take-up pulses before the step of the direction
+ *
+ * the take-up position is 0 at the backward engaged side
+ * and the take-up steps at the forward one
+ */
+static uint16_t GEN_backlash_need(uint8_t axis, int8_t dir, uint16_t slack)
+{
+  return dir > 0 ? backlash[axis].steps - slack : slack;
+}
+
+/*
+ * fill the next profile period
+ *
+ * long intervals are split into silent chunks, the direction output toggles
+ * by the compare match GEN_DIR_SETUP_NS before the step. The prescaler is
+ * preloaded like ARR, so the prescaled chunk starts at the Update event
+ * without a counter restart
+ */
+static uint8_t GEN_profile_period(uint8_t axis, uint16_t* p, int8_t* step)
+{
+  struct PRF_t* prf = &profile[axis];
+  uint32_t      len;
+  uint32_t      tail = prf->min_ticks + prf->setup_ticks;
+  // the last unprescaled chunk keeps the DMA bursts apart like the shortest
+  // period does, but it must fit the timer with the room for the prescaled rest
+  uint32_t      room = tail < GEN_PRF_CHUNK_MAX/2 ? tail : GEN_PRF_CHUNK_MAX/2;
+  uint32_t      floor, psc;
+  uint64_t      w;
+  int8_t        dir = 1;
+  int8_t        out;
+
+  // get the next step
+  if ( !prf->end && !prf->wait )
+  {
+    if ( !prf->lash && !prf->held )
+    {
+      GEN_axis_override_slew(axis);
+      len = prf->src(prf->ctx, &dir);
+
+      // the source has no data yet, the period is filled later
+      if ( len == GEN_PRF_WAIT ) return 0;
+
+      if ( !len ) prf->end = 1;
+      else
+      {
+        prf->src_len = len;
+        prf->wait = GEN_profile_warp(prf, len);
+        if ( !prf->wait ) prf->wait = 1;
+
+        // 0 is the interval without a step
+        prf->next_dir = dir < 0 ? -1 : dir > 0 ? 1 : 0;
+        prf->next_lash = 0;
+
+        // the backlash is taken up before the reversal step, the step is held
+        if ( prf->next_dir ) prf->lash = GEN_backlash_need(axis, prf->next_dir, prf->lash_slack);
+        if ( prf->lash ) prf->held = prf->wait;
+      }
+    }
+
+    if ( prf->lash )
+    {
+      // the take-up pulses are at the take-up frequency
+      --prf->lash;
+      prf->wait = prf->lash_ticks;
+      prf->next_lash = 1;
+    }
+    else if ( prf->held )
+    {
+      prf->wait = prf->held;
+      prf->held = 0;
+      prf->next_lash = 0;
+    }
+
+    if ( !prf->end )
+    {
+      // the direction reversal needs the setup time after the pulse
+      floor = prf->next_dir && prf->next_dir != prf->lvl ? tail : prf->min_ticks;
+
+      // the delayed step is caught up by the next intervals,
+      // so the steps of the synchronized axes stay at the same time
+      if ( prf->late && !prf->next_lash && prf->wait > floor )
+      {
+        w = prf->wait - floor < prf->late ? prf->wait - floor : prf->late;
+        prf->wait -= w;
+        prf->late -= w;
+      }
+
+      if ( prf->wait < floor )
+      {
+        if ( !prf->next_lash ) prf->late += floor - prf->wait;
+        prf->wait = floor;
+      }
+
+      // the take-up time isn't in the source intervals, it's caught up too
+      if ( prf->next_lash ) prf->late += prf->wait;
+    }
+  }
+
+  // the period starts with the step pulse
+  p[0] = 0;
+  p[2] = 0;
+  p[3] = prf->pulse ? prf->pulse_ticks : 0;
+  p[4] = 0xFFFF; // no direction toggle, ARR is 0xFFFE max
+  out = prf->pulse ? prf->lvl : 0;
+  *step = prf->pulse_lash ? out*PRF_LASH : out;
+  if ( prf->pulse_lash ) prf->lash_slack += out;
+
+  // the quadrature step is the A or B edge at the period start,
+  // the forward step toggles A at the even state
+  if ( axes[axis].mode == GEN_MODE_QUAD )
+  {
+    p[3] = 0xFFFF;
+    if ( out )
+    {
+      if ( !(axes[axis].quad_q & 1) == (out > 0) ) p[3] = 0;
+      else p[4] = 0;
+      axes[axis].quad_q = (axes[axis].quad_q + out) & 3;
+    }
+  }
+  else if ( axes[axis].mode == GEN_MODE_CW_CCW )
+  {
+    // the backward pulse is at the channel 2
+    p[4] = out < 0 ? p[3] : 0;
+    if ( out < 0 ) p[3] = 0;
+  }
+
+  if ( prf->end )
+  {
+    // the last step pulse and the silent tail
+    len = prf->min_ticks > GEN_PRF_PAD_TICKS ? prf->min_ticks : GEN_PRF_PAD_TICKS;
+    if ( len > GEN_PRF_CHUNK_MAX ) len = GEN_PRF_CHUNK_MAX;
+    prf->pulse = 0;
+    prf->pulse_lash = 0;
+    prf->end = 2;
+    p[1] = len - 1;
+    return 1;
+  }
+
+  psc = 0;
+  if ( prf->wait > GEN_PRF_CHUNK_MAX )
+  {
+    // the long interval is one prescaled chunk, the last chunk isn't prescaled
+    // and must have the room for the direction toggle
+    w = prf->wait > room ? prf->wait - room : 0;
+    psc = w / GEN_PRF_CHUNK_MAX > 0xFFFF ? 0xFFFF : (uint32_t)(w / GEN_PRF_CHUNK_MAX);
+
+    if ( !psc ) len = (uint32_t)(prf->wait / 2);
+    else
+    {
+      // the chunk is 65535 * 65536 ticks max, the rest is the next chunks
+      len = w / (psc + 1) > GEN_PRF_CHUNK_MAX ? GEN_PRF_CHUNK_MAX : (uint32_t)(w / (psc + 1));
+      len *= psc + 1;
+    }
+  }
+  else len = (uint32_t)prf->wait;
+
+  prf->wait -= len;
+  prf->pulse = !prf->wait && prf->next_dir;
+  prf->pulse_lash = prf->pulse && prf->next_lash;
+
+  if ( prf->pulse && prf->next_dir != prf->lvl )
+  {
+    // the other modes direction is the edges order or the pulses channel
+    if ( axes[axis].mode == GEN_MODE_STEP_DIR ) p[4] = len - prf->setup_ticks;
+    prf->lvl = prf->next_dir;
+  }
+
+  // round up, the pulse must not be shorter than the set one
+  if ( psc && axes[axis].mode != GEN_MODE_QUAD )
+  {
+    p[3] = (p[3] + psc) / (psc + 1);
+    if ( axes[axis].mode == GEN_MODE_CW_CCW ) p[4] = (p[4] + psc) / (psc + 1);
+  }
+
+  p[0] = psc;
+  p[1] = len / (psc + 1) - 1;
+
+  return 1;
+}
+
+/*
+ * repeat the previous staged period instead of the period i
+ *
+ * the last two periods of the half aren't repeated, the position
+ * of the stop right after the half done event is exact by the DMA counter
+ *
+ * returns 1 if the period i is the repetition
+ */
+static uint8_t GEN_profile_repeat(uint8_t axis, uint32_t i)
+{
+  uint16_t* q;
+  uint16_t* p;
+
+  if ( !profile[axis].runs || !i || i > GEN_PRF_HALF_SIZE - 2 ) return 0;
+
+  q = PRF_stage[axis][i - 1];
+  p = PRF_stage[axis][i];
+
+  // the direction toggle would be repeated too, the prescaled chunks are long already
+  if ( p[0] || q[0] ) return 0;
+  if ( p[1] != q[1] || p[3] != q[3] || p[4] != q[4] ) return 0;
+  if ( axes[axis].mode == GEN_MODE_STEP_DIR && p[4] != 0xFFFF ) return 0;
+  if ( PRF_stage_step[axis][i] != PRF_stage_step[axis][i - 1] ) return 0;
+
+  if ( q[1] + 1 < GEN_PRF_RUN_MIN_TICKS || q[2] + 1 >= GEN_PRF_RUN_MAX ) return 0;
+  if ( (uint32_t)(q[1] + 1) * (q[2] + 2) > GEN_PRF_RUN_TICKS ) return 0;
+
+  ++q[2];
+
+  return 1;
+}
+
+/*
+ * fill the free profile ring half
+ *
+ * the half data is prepared out of the interrupts, the copy is short
+ */
+static void GEN_profile_fill(uint8_t axis)
+{
+  struct PRF_t* prf = &profile[axis];
+  uint8_t       h = prf->fill;
+  uint32_t      primask;
+  uint32_t      i;
+
+  if ( !prf->staged )
+  {
+    // the silent tail is filled already
+    if ( prf->end > 2 ) return;
+
+    if ( !prf->stage_cnt )
+    {
+      // all periods of the half are the tail
+      prf->stage_last = prf->end == 2;
+      prf->stage_net = 0;
+      prf->stage_pulses = 0;
+      prf->stage_dir = 0;
+    }
+
+    for ( i = prf->stage_cnt; i < GEN_PRF_HALF_SIZE; )
+    {
+      if ( !GEN_profile_period(axis, PRF_stage[axis][i], &PRF_stage_step[axis][i]) )
+      {
+        // continue from this period at the next call
+        prf->stage_cnt = i;
+        return;
+      }
+
+      prf->stage_net += PRF_POS(PRF_stage_step[axis][i]);
+      prf->stage_pulses += PRF_stage_step[axis][i] != 0;
+      if ( PRF_stage_step[axis][i] ) prf->stage_dir = PRF_stage_step[axis][i] > 0 ? 1 : -1;
+
+      // the equal period is one more repetition of the previous one
+      if ( !GEN_profile_repeat(axis, i) ) ++i;
+    }
+
+    prf->stage_slack = prf->lash_slack;
+    prf->stage_cnt = 0;
+    prf->staged = 1;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  if ( prf->state[h] == PRF_FREE )
+  {
+    for ( i = 0; i < GEN_PRF_HALF_SIZE; ++i )
+    {
+      PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][0] = PRF_stage[axis][i][0];
+      PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][1] = PRF_stage[axis][i][1];
+      PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][2] = PRF_stage[axis][i][2];
+      PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][3] = PRF_stage[axis][i][3];
+      PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][4] = PRF_stage[axis][i][4];
+      PRF_step[axis][h*GEN_PRF_HALF_SIZE + i] = PRF_stage_step[axis][i];
+    }
+
+    prf->net[h] = prf->stage_net;
+    prf->pulses[h] = prf->stage_pulses;
+    prf->last_dir[h] = prf->stage_dir;
+    prf->slack[h] = prf->stage_slack;
+    prf->state[h] = prf->stage_last ? PRF_LAST : PRF_READY;
+    if ( prf->stage_last ) prf->end = 3;
+
+    prf->fill ^= 1;
+    prf->staged = 0;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/*
+ * ring period ticks with its repetitions
+ */
+static uint64_t GEN_profile_period_ticks(uint8_t axis, uint32_t i)
+{
+  return (uint64_t)(PRF_ring[axis][i][0] + 1) * (PRF_ring[axis][i][1] + 1) * (PRF_ring[axis][i][2] + 1);
+}
+
+/*
+ * ring period steps with its repetitions
+ */
+static int32_t GEN_profile_period_steps(uint8_t axis, uint32_t i)
+{
+  return PRF_POS(PRF_step[axis][i]) * (PRF_ring[axis][i][2] + 1);
+}
+
+/*
+ * steps of the profile output in progress, which aren't in the position yet
+ *
+ * the CC1 DMA request reads the period data at the previous period's pulse end,
+ * so the last read period is preloaded or its pulse is in progress
+ */
+static int32_t GEN_profile_steps(uint8_t axis)
+{
+  struct PRF_t* prf = &profile[axis];
+  TIM_TypeDef*  tim = axes[axis].htim->Instance;
+  uint32_t      cyc = DWT->CYCCNT;
+  uint32_t      cnt = tim->CNT;
+  uint32_t      r, i, p, period, rep;
+  uint64_t      t, now;
+  int32_t       done = 0;
+
+  r = (PRF_RING_SIZE*5 - axes[axis].hdma->Instance->CNDTR + 4) / 5 % PRF_RING_SIZE;
+
+  // the periods read after the last half done event
+  for ( i = prf->base; i != r; i = (i + 1) % PRF_RING_SIZE ) done += GEN_profile_period_steps(axis, i);
+
+  // the last read period, its pulse is done at the CC1 match only,
+  // the Update event request reads the period at the previous period start
+  if ( (tim->CR2 & TIM_CR2_CCDS) || cnt >= tim->CCR1 )
+  {
+    done -= r != prf->base ? GEN_profile_period_steps(axis, (r + PRF_RING_SIZE - 1) % PRF_RING_SIZE) : PRF_POS(prf->tail);
+  }
+
+  // the repeated period in progress, the repetition counter isn't readable,
+  // so its pulses are counted by the time from the output start
+  p = (r + PRF_RING_SIZE - 2) % PRF_RING_SIZE;
+  if ( prf->runs && (r + PRF_RING_SIZE - prf->base) % PRF_RING_SIZE >= 2 && PRF_ring[axis][p][2] )
+  {
+    t = prf->base_time;
+    for ( i = prf->base; i != p; i = (i + 1) % PRF_RING_SIZE ) t += GEN_profile_period_ticks(axis, i);
+
+    now = prf->clk + (uint32_t)(cyc - prf->cyc);
+    now = now / SystemCoreClock * axes[axis].tim_freq +
+          now % SystemCoreClock * axes[axis].tim_freq / SystemCoreClock;
+
+    // every repetition starts with the pulse
+    period = PRF_ring[axis][p][1] + 1;
+    rep = now > t + cnt ? (uint32_t)((now - t - cnt + period/2) / period) + 1 : 1;
+    if ( rep > PRF_ring[axis][p][2] + 1U ) rep = PRF_ring[axis][p][2] + 1;
+
+    done -= PRF_POS(PRF_step[axis][p]) * (int32_t)(PRF_ring[axis][p][2] + 1 - rep);
+  }
+
+  return done;
+}
+
+/*
+ * backlash take-up position of the profile output in progress
+ *
+ * the played take-up pulses of the ring half are walked in order after
+ * the position of the half start, the repeated take-up period is counted whole
+ */
+static uint16_t GEN_profile_slack(uint8_t axis)
+{
+  struct PRF_t* prf = &profile[axis];
+  TIM_TypeDef*  tim = axes[axis].htim->Instance;
+  int32_t       slack = backlash[axis].slack;
+  uint32_t      r, i;
+  int8_t        s;
+
+  r = (PRF_RING_SIZE*5 - axes[axis].hdma->Instance->CNDTR + 4) / 5 % PRF_RING_SIZE;
+
+  // the last read period pulse isn't done, see GEN_profile_steps()
+  if ( (tim->CR2 & TIM_CR2_CCDS) || tim->CNT >= tim->CCR1 )
+  {
+    if ( r == prf->base ) slack -= PRF_POS(prf->tail) ? 0 : prf->tail / PRF_LASH;
+    else r = (r + PRF_RING_SIZE - 1) % PRF_RING_SIZE;
+  }
+
+  for ( i = prf->base; i != r; i = (i + 1) % PRF_RING_SIZE )
+  {
+    s = PRF_step[axis][i];
+    if ( s && !PRF_POS(s) ) slack += s / PRF_LASH * (PRF_ring[axis][i][2] + 1);
+  }
+
+  if ( slack < 0 ) slack = 0;
+  if ( slack > backlash[axis].steps ) slack = backlash[axis].steps;
+
+  return slack;
+}
+
+/*
+ * restore the constant frequency output settings after the profile output
+ */
+static void GEN_profile_finish(uint8_t axis)
+{
+  TIM_TypeDef* tim = axes[axis].htim->Instance;
+
+  tim->CR1 &= ~(TIM_CR1_CEN | TIM_CR1_ARPE);
+  __HAL_TIM_DISABLE_DMA(axes[axis].htim, axes[axis].dma_req);
+  __HAL_DMA_DISABLE(axes[axis].hdma);
+  axes[axis].hdma->Instance->CCR = dma_ccr[axis];
+  tim->DCR = 0;
+  tim->CR2 &= ~(TIM_CR2_CCDS);
+  if ( IS_TIM_REPETITION_COUNTER_INSTANCE(tim) ) tim->RCR = 0;
+  tim->CCMR1 &= ~(TIM_CCMR1_OC1PE | TIM_CCMR1_OC2PE);
+
+  profile[axis].on = 0;
+
+  if ( axes[axis].mode == GEN_MODE_QUAD )
+  {
+    // A and B stay at the played state, the stopped output didn't play all filled periods
+    axes[axis].quad_q =
+      HAL_GPIO_ReadPin(GEN_STEP_PORT[axis], GEN_DIR_PIN[axis]) ?
+      (HAL_GPIO_ReadPin(GEN_STEP_PORT[axis], GEN_STEP_PIN[axis]) ? 2 : 3) :
+      (HAL_GPIO_ReadPin(GEN_STEP_PORT[axis], GEN_STEP_PIN[axis]) ? 1 : 0);
+  }
+  else
+  {
+    TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+    if ( axes[axis].mode == GEN_MODE_CW_CCW ) TIM_CCxChannelCmd(tim, TIM_CHANNEL_2, TIM_CCx_DISABLE);
+    // the direction output stays at the last step direction level
+    GEN_dir_set(axis, axes[axis].dir);
+  }
+
+  // force the timer's data update at the next output start
+  axes[axis].freq = 0;
+  axes[axis].busy = 0;
+}
+
+/*
+ * carry the CPU clocks counter to the profile output clock
+ *
+ * the counter wraps in 59.6 s at 72 MHz, the halves of the prescaled
+ * periods are longer than that
+ */
+static void GEN_profile_clock(uint8_t axis)
+{
+  struct PRF_t* prf = &profile[axis];
+  uint32_t      primask, cyc;
+
+  // the output isn't started yet
+  if ( !prf->on || !prf->runs || !(axes[axis].htim->Instance->CR1 & TIM_CR1_CEN) ) return;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  cyc = DWT->CYCCNT;
+  prf->clk += (uint32_t)(cyc - prf->cyc);
+  prf->cyc = cyc;
+  __set_PRIMASK(primask);
+}
+
+/*
+ * profile ring half is read by the DMA
+ */
+static void GEN_profile_half_done(uint8_t axis, uint8_t h)
+{
+  struct PRF_t* prf = &profile[axis];
+  uint32_t      i;
+
+  if ( !prf->on ) return;
+
+  axes[axis].pos += prf->net[h];
+  prf->pulses_done += prf->pulses[h];
+  if ( prf->last_dir[h] ) axes[axis].dir = prf->last_dir[h];
+  if ( prf->slack[h] != GEN_SLACK_NONE ) backlash[axis].slack = prf->slack[h];
+  prf->base = (h ^ 1) * GEN_PRF_HALF_SIZE;
+  prf->tail = PRF_step[axis][h*GEN_PRF_HALF_SIZE + GEN_PRF_HALF_SIZE - 1];
+
+  if ( prf->runs )
+  {
+    // the next half start time, the clocks counter is carried by the SysTick too
+    for ( i = 0; i < GEN_PRF_HALF_SIZE; ++i )
+    {
+      prf->base_time += GEN_profile_period_ticks(axis, h*GEN_PRF_HALF_SIZE + i);
+    }
+
+    i = DWT->CYCCNT;
+    prf->clk += (uint32_t)(i - prf->cyc);
+    prf->cyc = i;
+  }
+
+  // the last step pulse was played in the previous half
+  if ( prf->state[h] == PRF_LAST )
+  {
+    GEN_verify_check(axis, prf->pulses_done);
+    GEN_profile_finish(axis);
+    return;
+  }
+
+  // make the half silent, it plays so if the data are late
+  for ( i = 0; i < GEN_PRF_HALF_SIZE; ++i )
+  {
+    PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][0] = 0;
+    PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][1] = GEN_PRF_PAD_TICKS - 1;
+    PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][2] = 0;
+    PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][3] = axes[axis].mode == GEN_MODE_QUAD ? 0xFFFF : 0;
+    PRF_ring[axis][h*GEN_PRF_HALF_SIZE + i][4] = axes[axis].mode == GEN_MODE_CW_CCW ? 0 : 0xFFFF;
+    PRF_step[axis][h*GEN_PRF_HALF_SIZE + i] = 0;
+  }
+
+  prf->net[h] = 0;
+  prf->pulses[h] = 0;
+  prf->last_dir[h] = 0;
+  prf->slack[h] = GEN_SLACK_NONE;
+  prf->state[h] = PRF_FREE;
+
+  // the DMA reads the next half now, it isn't filled
+  if ( prf->state[h ^ 1] == PRF_FREE )
+  {
+    prf->state[h ^ 1] = PRF_SILENT;
+    ++prf->underruns;
+  }
+}
+
+/*
+ * DMA transfer complete event of the axis output
+ */
+static void GEN_output_complete(uint8_t axis)
+{
+  if ( profile[axis].on )
+  {
+    GEN_profile_half_done(axis, 1);
+    return;
+  }
+
+  // the output was stopped already
+  if ( !axes[axis].busy ) return;
+
+  // the stop write was late, the counter wrapped and the next pulse started
+  if ( axes[axis].htim->Instance->CNT < axes[axis].htim->Instance->CCR1 ) ++axes[axis].late_stops;
+
+  GEN_verify_check(axis, axes[axis].steps);
+
+  GEN_output_finish(axis);
+  axes[axis].busy = 0;
+
+  if ( backlash[axis].comp )
+  {
+    // backlash is taken up, start the move without a stop
+    backlash[axis].comp = 0;
+    GEN_steps_output(axis, backlash[axis].next_steps, backlash[axis].next_freq);
+    return;
+  }
+
+  axes[axis].pos += axes[axis].dir * axes[axis].steps;
+
+  HOME_output_complete(axis);
+}
+
+/*
+ * add the DMA IRQ handler time to the axis timing stats
+ */
+static void GEN_isr_stat_add(uint8_t axis, uint32_t start)
+{
+  uint32_t cycles = DWT->CYCCNT - start;
+
+  ++isr_stat[axis].cnt;
+  if ( cycles > isr_stat[axis].max ) isr_stat[axis].max = cycles;
+}
+
+/*
+ * DMA bus load of the running outputs except the skipped axis, CPU clocks/s
+ *
+ * the constant frequency step is a CR1 write, the profile period is
+ * the PSC, ARR, RCR, CCR1, CCR2 burst, the rate is the max one
+ */
+static uint64_t GEN_dma_load(uint8_t skip)
+{
+  uint64_t load = 0;
+
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( axis == skip || !axes[axis].busy ) continue;
+
+    load += (uint64_t)axes[axis].rate * (profile[axis].on ? 5 : 1) * axes[axis].dma_clk;
+  }
+
+  return load;
+}
+
+/*
+ * DMA bus share of the steps outputs, CPU clocks/s
+ */
+static uint64_t GEN_dma_budget(void)
+{
+  return (uint64_t)HAL_RCC_GetHCLKFreq() * GEN_DMA_LOAD_MAX / 100;
+}
+
+/*
+ * measure the DMA transfer cost to the axis timer
+ *
+ * the memory to memory transfers write the unused CCR3 without the requests,
+ * the cost is the CPU clocks per transfer rounded up
+ */
+static void GEN_dma_calibrate(uint8_t axis)
+{
+  DMA_Channel_TypeDef*  ch = axes[axis].hdma->Instance;
+  uint32_t              start;
+
+  // the CPU clocks counter measures the transfers time
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  // the source is the axis steps array before it's filled, the bytes
+  // are read like the constant frequency output does
+  ch->CCR = DMA_CCR_MEM2MEM | DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_PSIZE_0;
+  ch->CNDTR = GEN_DMA_CAL_SIZE;
+  ch->CPAR = (uint32_t)&(axes[axis].htim->Instance->CCR3);
+  ch->CMAR = (uint32_t)&DMA_array[axis][0];
+
+  start = DWT->CYCCNT;
+  ch->CCR |= (DMA_CCR_EN);
+  while ( !(DMA1->ISR & (DMA_ISR_TCIF1 << axes[axis].hdma->ChannelIndex)) );
+  axes[axis].dma_clk = (DWT->CYCCNT - start + GEN_DMA_CAL_SIZE - 1) / GEN_DMA_CAL_SIZE;
+
+  ch->CCR = dma_ccr[axis];
+  DMA1->IFCR = DMA_IFCR_CGIF1 << axes[axis].hdma->ChannelIndex;
+}
+
+/*
+ * rank the axes DMA channels priorities by the outputs rates
+ *
+ * the fastest axis has the shortest time for its DMA request,
+ * the idle axes are the slowest ones
+ */
+static void GEN_dma_priorities_update(void)
+{
+  uint32_t  rate, other, pl;
+  uint32_t  primask = __get_PRIMASK();
+  uint8_t   rank;
+
+  // the DMA IRQ handlers rewrite the channels CCR at the output end
+  // and the backlash move start, the read-modify-write isn't split by them
+  __disable_irq();
+
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    rate = axes[axis].busy ? axes[axis].rate : 0;
+
+    // the equal rates keep the axes order
+    rank = 0;
+    for ( uint8_t i = GEN_AXIS_CNT; i--; )
+    {
+      other = axes[i].busy ? axes[i].rate : 0;
+      if ( other > rate || (other == rate && i < axis) ) ++rank;
+    }
+
+    pl = (uint32_t)(3 - rank) << DMA_CCR_PL_Pos;
+
+    // the priority is changed at the running channel too
+    dma_ccr[axis] = (dma_ccr[axis] & ~(DMA_CCR_PL)) | pl;
+    axes[axis].hdma->Instance->CCR = (axes[axis].hdma->Instance->CCR & ~(DMA_CCR_PL)) | pl;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/*
+ * generation system core init
+ *
+ * uses in the main() after SystemClock_Config()
+ */
+void GEN_system_init(void)
+{
+  // set systick update frequency
+  HAL_SYSTICK_Config(HAL_RCC_GetHCLKFreq()/GEN_SYSTICK_IRQ_FREQ);
+}
+
+/*
+ * generation init
+ *
+ * uses in the main() before infinite loop start
+ */
+void GEN_init(void)
+{
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    // channel 2 is the direction output, the forward direction is the low level
+    GEN_dir_set(axis, 1);
+    TIM_CCxChannelCmd(axes[axis].htim->Instance, TIM_CHANNEL_2, TIM_CCx_ENABLE);
+    __HAL_TIM_MOE_ENABLE(axes[axis].htim);
+
+    // DMA channel settings of the constant frequency output
+    dma_ccr[axis] = axes[axis].hdma->Instance->CCR & ~(DMA_CCR_EN);
+    GEN_dma_calibrate(axis);
+
+    // fill the array with timer's CR1 values with timer enable bit
+    // this array uses to stop timer immidiately after DMA transfer complete
+    for (
+      uint32_t  i = GEN_DMA_ARRAY_SIZE,
+                v = axes[axis].htim->Instance->CR1 | (TIM_CR1_CEN);
+      i--;
+    ) {
+      DMA_array[axis][i] = v;
+    }
+
+    /* reset the Preload enable bit for OC channel */
+    axes[axis].htim->Instance->CCMR1 &= ~(TIM_CCMR1_OC1PE);
+  }
+}
+
+/*
+ * low level steps generation function
+ *
+ * uses to generate a limit number of steps at the constant frequency
+ */
+enum GEN_ERR_t GEN_steps_output(uint8_t axis, uint16_t steps, uint32_t freq)
+{
+  // don't let a wrong call to damage the DMA array
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  // the checker's timer counts the other axis pulses
+  if ( axes[axis].busy || verify[axis].counts ) return GEN_ERR_BUSY;
+  if ( axes[axis].mode == GEN_MODE_QUAD ) return GEN_ERR_MODE;
+  if ( !steps || steps > GEN_DMA_ARRAY_SIZE ) return GEN_ERR_STEPS;
+  if ( !freq ) return GEN_ERR_FREQ;
+  // geared slave gets its steps from the master
+  if ( axes[axis].gear_master != GEN_AXIS_NONE ) return GEN_ERR_GEAR;
+
+  // save last generation steps value
+  axes[axis].steps = steps;
+  axes[axis].busy = 1;
+  axes[axis].rate = freq;
+  GEN_verify_start(axis);
+
+  // change prescaler/period only when new frequency is different
+  if ( freq != axes[axis].freq )
+  {
+    // save last generation frequency value
+    axes[axis].freq = freq;
+
+    // calculate the period and prescaler
+    axes[axis].presc = axes[axis].tim_freq / freq / 65536;
+    axes[axis].period = axes[axis].tim_freq / freq / (axes[axis].presc + 1);
+
+    if ( axes[axis].gear_gate ) GEN_gear_pause(axis);
+
+    // set timer's data
+    __HAL_TIM_SET_AUTORELOAD(axes[axis].htim, axes[axis].period - 1);
+    // geared master's pulse is the slaves gate, it isn't clamped
+    // to keep the ratio exact, the period must be longer than the gate
+    __HAL_TIM_SET_COMPARE(axes[axis].htim, TIM_CHANNEL_1,
+      axes[axis].gear_gate ? axes[axis].gear_gate :
+      GEN_pulse_ticks(axis, axes[axis].presc, axes[axis].period));
+    // the CC4 DMA request is at the pulse end too
+    axes[axis].htim->Instance->CCR4 = axes[axis].htim->Instance->CCR1;
+    // the backward pulses channel
+    if ( axes[axis].mode == GEN_MODE_CW_CCW ) axes[axis].htim->Instance->CCR2 = axes[axis].htim->Instance->CCR1;
+    __HAL_TIM_SET_PRESCALER(axes[axis].htim, axes[axis].presc);
+    // generate the Update event to apply the new prescaler
+    axes[axis].htim->Instance->EGR |= (TIM_EGR_UG);
+
+    if ( axes[axis].gear_gate ) GEN_gear_resume(axis);
+  }
+
+  // reset the CR1 timer enable bit in the DMA array cell
+  // this uses to stop timer immidiately after DMA transfer complete
+  DMA_array[axis][steps - 1] &= ~(TIM_CR1_CEN);
+
+  GEN_dma_priorities_update();
+
+  /* Disable the peripheral */
+  __HAL_DMA_DISABLE(axes[axis].hdma);
+  /* Configure DMA Channel data length */
+  axes[axis].hdma->Instance->CNDTR = steps;
+  /* Configure DMA Channel destination address */
+  axes[axis].hdma->Instance->CPAR = (uint32_t)&(axes[axis].htim->Instance->CR1);
+  /* Configure DMA Channel source address */
+  axes[axis].hdma->Instance->CMAR = (uint32_t)&DMA_array[axis][0];
+  /* Enable the Peripheral */
+  __HAL_DMA_ENABLE(axes[axis].hdma);
+  /* Enable the transfer complete interrupt */
+  __HAL_DMA_ENABLE_IT(axes[axis].hdma, DMA_IT_TC);
+  /* Enable the TIM Capture/Compare DMA request */
+  __HAL_TIM_ENABLE_DMA(axes[axis].htim, axes[axis].dma_req);
+  /* Enable the Capture compare channel */
+  if ( axes[axis].mode == GEN_MODE_CW_CCW )
+  {
+    // the pulses go to the channel of the move direction
+    TIM_CCxChannelCmd(axes[axis].htim->Instance, axes[axis].dir < 0 ? TIM_CHANNEL_1 : TIM_CHANNEL_2, TIM_CCx_DISABLE);
+    TIM_CCxChannelCmd(axes[axis].htim->Instance, axes[axis].dir < 0 ? TIM_CHANNEL_2 : TIM_CHANNEL_1, TIM_CCx_ENABLE);
+  }
+  else TIM_CCxChannelCmd(axes[axis].htim->Instance, TIM_CHANNEL_1, TIM_CCx_ENABLE);
+  /* Enable the main output */
+  __HAL_TIM_MOE_ENABLE(axes[axis].htim);
+  /* Enable the Peripheral */
+  __HAL_TIM_ENABLE(axes[axis].htim);
+
+  return GEN_OK;
+}
+
+/*
+ * constant frequency output admission by the axis limits and the DMA bus load
+ */
+static enum GEN_ERR_t GEN_freq_check(uint8_t axis, uint32_t freq)
+{
+  const struct LIMITS_t* lim = &limits[axis];
+
+  if ( !freq || freq > (lim->freq_max ? lim->freq_max : GEN_FREQ_MAX) ) return GEN_ERR_FREQ;
+  // the constant frequency output has no ramp
+  if ( lim->freq_start && freq > lim->freq_start ) return GEN_ERR_FREQ;
+
+  // the running outputs and this one must fit the DMA bus share
+  if ( GEN_dma_load(axis) + (uint64_t)freq * axes[axis].dma_clk > GEN_dma_budget() ) return GEN_ERR_BUS;
+
+  // geared master's pulse is the fixed gate, it must be shorter than the period
+  if ( axes[axis].gear_gate &&
+       axes[axis].tim_freq / freq <= (uint32_t)axes[axis].gear_gate * (axes[axis].tim_freq / freq / 65536 + 1) )
+  {
+    return GEN_ERR_GEAR;
+  }
+
+  return GEN_OK;
+}
+
+/*
+ * motion command validation
+ *
+ * uses in front of every motion command, so it has integer compares only,
+ * a division for the geared master and the DMA bus load sum. The output
+ * mode isn't checked, the profile sources run the quadrature too
+ */
+enum GEN_ERR_t GEN_move_check(uint8_t axis, int8_t dir, uint32_t steps, uint32_t freq)
+{
+  const struct LIMITS_t* lim;
+  enum GEN_ERR_t err;
+  int32_t end;
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( axes[axis].gear_master != GEN_AXIS_NONE ) return GEN_ERR_GEAR;
+  // the checker's timer counts the other axis pulses
+  if ( axes[axis].busy || verify[axis].counts ) return GEN_ERR_BUSY;
+  if ( !steps || steps > GEN_DMA_ARRAY_SIZE ) return GEN_ERR_STEPS;
+
+  err = GEN_freq_check(axis, freq);
+  if ( err != GEN_OK ) return err;
+
+  lim = &limits[axis];
+  if ( lim->pos_on )
+  {
+    end = axes[axis].pos + (dir < 0 ? -(int32_t)steps : (int32_t)steps);
+    if ( end < lim->pos_min || end > lim->pos_max ) return GEN_ERR_LIMIT;
+  }
+
+  return GEN_OK;
+}
+
+/*
+ * validated steps output
+ *
+ * uses for the motion commands, the move is rejected with the error code
+ * instead of being executed
+ */
+enum GEN_ERR_t GEN_move(uint8_t axis, int8_t dir, uint32_t steps, uint32_t freq)
+{
+  enum GEN_ERR_t err;
+  uint16_t lash;
+
+  // the feed override is applied at the output start
+  if ( axis < GEN_AXIS_CNT )
+  {
+    freq = (uint32_t)((uint64_t)freq * ovr_req * axis_ovr_req[axis] / 10000);
+    if ( !freq ) freq = 1;
+  }
+
+  err = GEN_move_check(axis, dir, steps, freq);
+  if ( err != GEN_OK ) return err;
+  // the constant frequency output has no quadrature
+  if ( axes[axis].mode == GEN_MODE_QUAD ) return GEN_ERR_MODE;
+
+  dir = dir < 0 ? -1 : 1;
+  lash = GEN_backlash_need(axis, dir, backlash[axis].slack);
+
+  GEN_dir_set(axis, dir);
+
+  if ( lash )
+  {
+    // the take-up frequency is admitted like the move one,
+    // the limits could be changed after GEN_backlash_set()
+    err = GEN_freq_check(axis, backlash[axis].freq);
+    if ( err != GEN_OK ) return err;
+
+    // take up the backlash first, the move starts right after it
+    // from the output complete handler
+    backlash[axis].next_steps = steps;
+    backlash[axis].next_freq = freq;
+    backlash[axis].comp = 1;
+
+    err = GEN_steps_output(axis, lash, backlash[axis].freq);
+    if ( err != GEN_OK ) backlash[axis].comp = 0;
+    // the take-up is engaged at the end, the stop sets the steps left
+    else backlash[axis].slack = dir > 0 ? backlash[axis].steps : 0;
+
+    return err;
+  }
+
+  return GEN_steps_output(axis, steps, freq);
+}
+
+/*
+ * set the axis motion limits
+ *
+ * the zero max frequency and acceleration are the defaults, see LIMITS_t
+ */
+enum GEN_ERR_t GEN_limits_set(uint8_t axis, const struct LIMITS_t* lim)
+{
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( lim->pos_on && lim->pos_min > lim->pos_max ) return GEN_ERR_LIMIT;
+  if ( lim->freq_max > GEN_FREQ_MAX ) return GEN_ERR_FREQ;
+  if ( lim->freq_start > (lim->freq_max ? lim->freq_max : GEN_FREQ_MAX) ) return GEN_ERR_FREQ;
+
+  limits[axis] = *lim;
+
+  return GEN_OK;
+}
+
+/*
+ * check the position against the axis soft limits
+ */
+enum GEN_ERR_t GEN_limits_check(uint8_t axis, int32_t pos)
+{
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+
+  if ( limits[axis].pos_on && (pos < limits[axis].pos_min || pos > limits[axis].pos_max) )
+  {
+    return GEN_ERR_LIMIT;
+  }
+
+  return GEN_OK;
+}
+
+/*
+ * set the axis backlash compensation
+ *
+ * the take-up steps are inserted on every direction reversal by GEN_move()
+ * and the profile outputs, they don't change the axis position.
+ * The backlash is engaged at the current direction side
+ */
+enum GEN_ERR_t GEN_backlash_set(uint8_t axis, uint16_t steps, uint32_t freq)
+{
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( steps > GEN_DMA_ARRAY_SIZE ) return GEN_ERR_STEPS;
+  // the output in progress takes up the backlash of the old settings
+  if ( axes[axis].busy ) return GEN_ERR_BUSY;
+  // the take-up is the constant frequency output without a ramp
+  if ( steps && (!freq || freq > (limits[axis].freq_max ? limits[axis].freq_max : GEN_FREQ_MAX) ||
+                 (limits[axis].freq_start && freq > limits[axis].freq_start)) )
+  {
+    return GEN_ERR_FREQ;
+  }
+
+  backlash[axis].steps = steps;
+  backlash[axis].freq = freq;
+  backlash[axis].slack = axes[axis].dir > 0 ? steps : 0;
+
+  return GEN_OK;
+}
+
+/*
+ * set the axis direction
+ *
+ * uses between the steps outputs only
+ */
+void GEN_dir_set(uint8_t axis, int8_t dir)
+{
+  uint32_t mode = dir < 0 ? TIM_OCMODE_FORCED_ACTIVE : TIM_OCMODE_FORCED_INACTIVE;
+
+  axes[axis].dir = dir < 0 ? -1 : 1;
+
+  // the channel 2 is the direction output in the step/dir mode only
+  if ( axes[axis].mode != GEN_MODE_STEP_DIR ) return;
+
+  // channel 2 output is forced to the direction level,
+  // the profile output toggles it by the compare match
+  for ( uint8_t a = GEN_AXIS_CNT; a--; )
+  {
+    // geared slaves follow the master's direction
+    if ( a == axis || axes[a].gear_master == axis )
+    {
+      axes[a].htim->Instance->CCMR1 =
+        (axes[a].htim->Instance->CCMR1 & ~(TIM_CCMR1_OC2M)) | (mode << 8);
+    }
+  }
+}
+
+/*
+ * stop the steps output immediately
+ *
+ * the position keeps all steps which were started at the output pin,
+ * the homing cycle of the axis is stopped too
+ */
+void GEN_stop(uint8_t axis)
+{
+  uint32_t done;
+  uint32_t primask;
+
+  HOME_abort(axis);
+  if ( !axes[axis].busy ) return;
+
+  if ( profile[axis].on )
+  {
+    primask = __get_PRIMASK();
+    __disable_irq();
+    // the repeated period pulses are counted by the time of the timer stop
+    axes[axis].htim->Instance->CR1 &= ~(TIM_CR1_CEN);
+    axes[axis].pos += GEN_profile_steps(axis);
+    backlash[axis].slack = GEN_profile_slack(axis);
+    GEN_profile_finish(axis);
+    __set_PRIMASK(primask);
+    return;
+  }
+
+  // stop the timer first, after that the DMA counter doesn't change
+  axes[axis].htim->Instance->CR1 &= ~(TIM_CR1_CEN);
+
+  __HAL_DMA_DISABLE(axes[axis].hdma);
+  __HAL_DMA_DISABLE_IT(axes[axis].hdma, DMA_IT_TC);
+
+  // DMA counts the finished pulses, the pulse in progress is a step too
+  done = axes[axis].steps - axes[axis].hdma->Instance->CNDTR;
+  if ( axes[axis].htim->Instance->CNT < axes[axis].htim->Instance->CCR1 )
+  {
+    ++done;
+    // finish the pulse, the next output starts from a new period
+    axes[axis].htim->Instance->CNT = axes[axis].htim->Instance->CCR1;
+  }
+
+  GEN_output_finish(axis);
+
+  if ( done > axes[axis].steps ) done = axes[axis].steps;
+
+  // backlash take-up steps aren't the position, the next move is dropped,
+  // the direction stays and the rest of the take-up is left for the next move
+  if ( backlash[axis].comp )
+  {
+    backlash[axis].comp = 0;
+    done = axes[axis].steps - done;
+    backlash[axis].slack = axes[axis].dir > 0 ? backlash[axis].steps - done : done;
+  }
+  else axes[axis].pos += axes[axis].dir * (int32_t)done;
+
+  axes[axis].busy = 0;
+}
+
+/*
+ * live axis position, steps
+ */
+int32_t GEN_position_get(uint8_t axis)
+{
+  int32_t   pos;
+  uint32_t  primask = __get_PRIMASK();
+
+  __disable_irq();
+  pos = axes[axis].pos;
+  if ( profile[axis].on ) pos += GEN_profile_steps(axis);
+  // DMA counts the finished steps of the output in progress
+  else if ( axes[axis].busy && !backlash[axis].comp )
+  {
+    pos += axes[axis].dir *
+      (int32_t)(axes[axis].steps - axes[axis].hdma->Instance->CNDTR);
+  }
+  __set_PRIMASK(primask);
+
+  return pos;
+}
+
+/*
+ * axis timer base clock frequency, Hz
+ */
+uint32_t GEN_tim_freq_get(uint8_t axis)
+{
+  return axes[axis].tim_freq;
+}
+
+/*
+ * axis motion limits, the zero values are the defaults
+ */
+const struct LIMITS_t* GEN_limits_get(uint8_t axis)
+{
+  return &limits[axis];
+}
+
+/*
+ * the axis steps output is in progress
+ */
+uint8_t GEN_busy(uint8_t axis)
+{
+  return axes[axis].busy;
+}
+
+/*
+ * axis status for the host
+ */
+void GEN_status_get(uint8_t axis, struct GEN_STATUS_t* st)
+{
+  struct PRF_t* prf = &profile[axis];
+  uint16_t      depth = 0;
+
+  if ( prf->on )
+  {
+    // the ring periods and the staged ones which wait for the DMA
+    depth = (prf->state[0] == PRF_READY) + (prf->state[1] == PRF_READY);
+    depth = depth * GEN_PRF_HALF_SIZE + prf->stage_cnt;
+  }
+
+  st->pos = GEN_position_get(axis);
+  st->depth = depth;
+  st->underruns = prf->underruns;
+  st->isr_cnt = isr_stat[axis].cnt;
+  st->isr_max = isr_stat[axis].max;
+  st->late_stops = axes[axis].late_stops;
+  st->seg = verify[axis].seg;
+  st->verify_seg = verify[axis].bad_seg;
+  st->verify_diff = verify[axis].bad_diff;
+  st->verify_errors = verify[axis].errors;
+  st->starves = starves;
+  st->starve_time = starve_time;
+  st->starving = starve_on;
+  st->dma_load = (uint8_t)(GEN_dma_load(GEN_AXIS_NONE) * 100 / HAL_RCC_GetHCLKFreq());
+}
+
+/*
+ * integer square root
+ *
+ * uses in the motion planners
+ */
+uint32_t GEN_isqrt(uint64_t v)
+{
+  uint64_t r = 0, b = (uint64_t)1 << 62;
+
+  while ( b > v ) b >>= 2;
+
+  while ( b )
+  {
+    if ( v >= r + b )
+    {
+      v -= r + b;
+      r = (r >> 1) + b;
+    }
+    else r >>= 1;
+
+    b >>= 2;
+  }
+
+  return (uint32_t)r;
+}
+
+/*
+ * set the axis position, steps
+ *
+ * uses for the idle axis only
+ */
+void GEN_position_set(uint8_t axis, int32_t pos)
+{
+  axes[axis].pos = pos;
+}
+
+/*
+ * set the step pulse width
+ *
+ * ns = 0 restores the 50% duty pulse
+ */
+enum GEN_ERR_t GEN_pulse_width_set(uint8_t axis, uint32_t ns)
+{
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+
+  axes[axis].pulse_ns = ns;
+  // convert to the timer base clock ticks here, not at every output start
+  axes[axis].pulse_clk = (uint32_t)
+    (((uint64_t)ns * axes[axis].tim_freq + 999999999) / 1000000000);
+
+  // force the timer's data update at the next output start
+  axes[axis].freq = 0;
+
+  return GEN_OK;
+}
+
+
+/*
+ * electronic gearing, the slave axis makes num/den steps per master's step
+ *
+ * the slave timer is in the gated mode by the master's OC1REF, so it counts
+ * (master's pulse width) ticks per master's step. With the master's pulse width
+ * of num*k ticks and the slave's period of den*k ticks the ratio is exact
+ * and it costs no CPU time per step
+ */
+enum GEN_ERR_t GEN_gear_set(uint8_t slave, uint8_t master, uint16_t num, uint16_t den)
+{
+  TIM_TypeDef*  tim;
+  uint32_t      k;
+
+  if ( slave >= GEN_AXIS_CNT || master >= GEN_AXIS_CNT || slave == master ) return GEN_ERR_AXIS;
+  if ( axes[slave].busy || verify[slave].counts || verify[master].counts ) return GEN_ERR_BUSY;
+  if ( axes[slave].mode != GEN_MODE_STEP_DIR || axes[master].mode != GEN_MODE_STEP_DIR ) return GEN_ERR_MODE;
+  if ( !num || !den ) return GEN_ERR_GEAR;
+  // no chains, the slave can't be a master and vice versa
+  if ( axes[slave].gear_master != GEN_AXIS_NONE || axes[slave].gear_gate ) return GEN_ERR_GEAR;
+  if ( axes[master].gear_master != GEN_AXIS_NONE ) return GEN_ERR_GEAR;
+
+  if ( axes[master].gear_gate )
+  {
+    // all slaves of the master share its pulse width
+    if ( axes[master].gear_gate % num ) return GEN_ERR_GEAR;
+    k = axes[master].gear_gate / num;
+  }
+  else
+  {
+    // make the gate as near as possible to the master's pulse width
+    k = axes[master].pulse_clk ? axes[master].pulse_clk :
+        (uint32_t)((uint64_t)GEN_GEAR_GATE_NS * axes[master].tim_freq / 1000000000);
+    k /= num;
+    if ( (uint32_t)den * k > 65536 ) k = 65536 / den;
+    if ( (uint32_t)num * k > 65535 ) k = 65535 / num;
+    // slave's own pulse needs 2 ticks at least
+    if ( k < 2 ) k = 2;
+  }
 
-/* functions ------------------------------------------------------------------*/
+  if ( (uint32_t)den * k > 65536 || (uint32_t)num * k > 65535 ) return GEN_ERR_GEAR;
+
+  axes[slave].gear_master = master;
+  axes[master].gear_gate = num * k;
+  // force the master's timer data update at the next output start
+  axes[master].freq = 0;
+
+  // slave counts the master's prescaled clock while the master's pulse is high
+  tim = axes[slave].htim->Instance;
+  tim->CR1 &= ~(TIM_CR1_CEN);
+  tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M)) | TIM_OCMODE_FORCED_INACTIVE;
+  tim->PSC = axes[master].presc;
+  tim->ARR = den * k - 1;
+  tim->CCR1 = den * k / 2;
+  tim->EGR = TIM_EGR_UG;
+  // start from the middle of the slave's step with the low output
+  tim->CNT = tim->CCR1;
+  tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M)) | TIM_OCMODE_PWM1;
+
+  // trigger selection must be changed only while the slave mode is off
+  tim->SMCR &= ~(TIM_SMCR_SMS);
+  tim->SMCR = (tim->SMCR & ~(TIM_SMCR_TS)) | GEN_ITR[slave][master];
+  tim->SMCR |= TIM_SLAVEMODE_GATED;
+
+  // master's OC1REF is the slave's gate
+  axes[master].htim->Instance->CR2 =
+    (axes[master].htim->Instance->CR2 & ~(TIM_CR2_MMS)) | TIM_TRGO_OC1REF;
+
+  TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_ENABLE);
+  __HAL_TIM_MOE_ENABLE(axes[slave].htim);
+  tim->CR1 |= (TIM_CR1_CEN);
+
+  // slave's direction output follows the master's one
+  GEN_dir_set(master, axes[master].dir);
+
+  return GEN_OK;
+}
 
 /*
- * generation system core init
+ * turn the electronic gearing off for the slave axis
+ */
+void GEN_gear_off(uint8_t slave)
+{
+  TIM_TypeDef*  tim;
+  uint8_t       master = axes[slave].gear_master;
+  uint8_t       axis;
+
+  if ( master == GEN_AXIS_NONE ) return;
+
+  tim = axes[slave].htim->Instance;
+  tim->CR1 &= ~(TIM_CR1_CEN);
+  TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+  tim->SMCR &= ~(TIM_SMCR_SMS);
+
+  axes[slave].gear_master = GEN_AXIS_NONE;
+  // force the timer data update at the next output start
+  axes[slave].freq = 0;
+
+  // the master stays geared while it has any slave
+  for ( axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( axes[axis].gear_master == master ) return;
+  }
+
+  axes[master].gear_gate = 0;
+  axes[master].freq = 0;
+  axes[master].htim->Instance->CR2 &= ~(TIM_CR2_MMS);
+}
+
+/*
+ * count the step pin pulses of the axis by its timer
  *
- * uses in the main() after SystemClock_Config()
+ * the step pin is the input, TI1 rising edges clock the counter
  */
-void GEN_system_init(void)
+static void GEN_counter_on(uint8_t axis)
 {
-  // set systick update frequency
-  HAL_SYSTICK_Config(HAL_RCC_GetHCLKFreq()/GEN_SYSTICK_IRQ_FREQ);
+  GPIO_InitTypeDef  gpio = {0};
+  TIM_TypeDef*      tim = axes[axis].htim->Instance;
+
+  TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+  gpio.Pin = GEN_STEP_PIN[axis];
+  gpio.Mode = GPIO_MODE_INPUT;
+  gpio.Pull = GPIO_NOPULL;
+  HAL_GPIO_Init(GEN_STEP_PORT[axis], &gpio);
+
+  tim->CR1 &= ~(TIM_CR1_CEN);
+  tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M | TIM_CCMR1_OC1PE | TIM_CCMR1_CC1S)) | TIM_CCMR1_CC1S_0;
+  tim->CCER &= ~(TIM_CCER_CC1P);
+  tim->SMCR &= ~(TIM_SMCR_SMS);
+  tim->SMCR = (tim->SMCR & ~(TIM_SMCR_TS)) | TIM_TS_TI1FP1;
+  tim->SMCR |= TIM_SLAVEMODE_EXTERNAL1;
+  tim->PSC = 0;
+  tim->ARR = 0xFFFF;
+  tim->EGR = TIM_EGR_UG;
+  tim->CR1 |= (TIM_CR1_CEN);
+
+  verify[axis].counts = 1;
 }
 
 /*
- * generation init
+ * the axis step pin is the output again
+ */
+static void GEN_counter_off(uint8_t axis)
+{
+  GPIO_InitTypeDef  gpio = {0};
+  TIM_TypeDef*      tim = axes[axis].htim->Instance;
+
+  verify[axis].counts = 0;
+
+  tim->CR1 &= ~(TIM_CR1_CEN);
+  tim->SMCR &= ~(TIM_SMCR_SMS);
+  tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M)) | TIM_OCMODE_PWM1;
+
+  gpio.Pin = GEN_STEP_PIN[axis];
+  gpio.Mode = GPIO_MODE_AF_PP;
+  gpio.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(GEN_STEP_PORT[axis], &gpio);
+
+  // force the timer data update at the next output start
+  axes[axis].freq = 0;
+}
+
+/*
+ * count the step pulses of the axis by the checker axis timer
  *
- * uses in the main() before infinite loop start
+ * the axis step pin must be wired to the checker's step pin, the checker
+ * isn't an output until GEN_verify_off(), every output end compares
+ * the counted pulses with the commanded ones
  */
-void GEN_init(void)
+enum GEN_ERR_t GEN_verify_set(uint8_t axis, uint8_t checker)
 {
-  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  if ( axis >= GEN_AXIS_CNT || checker >= GEN_AXIS_CNT || axis == checker ) return GEN_ERR_AXIS;
+  if ( verify[axis].checker != GEN_AXIS_NONE || verify[axis].counts ) return GEN_ERR_BUSY;
+  if ( axes[checker].busy || verify[checker].counts || verify[checker].checker != GEN_AXIS_NONE ) return GEN_ERR_BUSY;
+  if ( axes[checker].gear_master != GEN_AXIS_NONE || axes[checker].gear_gate ) return GEN_ERR_GEAR;
+  // the channel 1 pulses are all steps in the step/dir mode only
+  if ( axes[axis].mode != GEN_MODE_STEP_DIR || axes[checker].mode != GEN_MODE_STEP_DIR ) return GEN_ERR_MODE;
+
+  // the checker's pin is driven by the axis pin
+  GEN_counter_on(checker);
+
+  verify[axis].cnt = axes[checker].htim->Instance->CNT;
+  verify[axis].pulses = 0;
+  verify[axis].start = 0;
+  verify[axis].checker = checker;
+
+  return GEN_OK;
+}
+
+/*
+ * set the axis output mode
+ *
+ * the quadrature A and B start low, the state is kept between the outputs,
+ * the quadrature axis runs the profile outputs only. The CW/CCW pulses
+ * channels are off between the outputs
+ */
+enum GEN_ERR_t GEN_mode_set(uint8_t axis, enum GEN_MODE_t mode)
+{
+  TIM_TypeDef* tim;
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( mode > GEN_MODE_CW_CCW ) return GEN_ERR_MODE;
+  if ( axes[axis].busy || verify[axis].counts ) return GEN_ERR_BUSY;
+  if ( verify[axis].checker != GEN_AXIS_NONE ) return GEN_ERR_MODE;
+  if ( axes[axis].gear_master != GEN_AXIS_NONE || axes[axis].gear_gate ) return GEN_ERR_GEAR;
+
+  tim = axes[axis].htim->Instance;
+  axes[axis].mode = mode;
+  // force the timer data update at the next output start
+  axes[axis].freq = 0;
+
+  switch ( mode )
   {
-    // fill the array with timer's CR1 values with timer enable bit
-    // this array uses to stop timer immidiately after DMA transfer complete
-    for (
-      uint32_t  i = GEN_DMA_ARRAY_SIZE,
-                v = axes[axis].htim->Instance->CR1 | (TIM_CR1_CEN);
-      i--;
-    ) {
-      DMA_array[axis][i] = v;
-    }
+    case GEN_MODE_QUAD:
+      // both references low, then the compare matches toggle them
+      tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M | TIM_CCMR1_OC2M)) |
+                   TIM_OCMODE_FORCED_INACTIVE | (TIM_OCMODE_FORCED_INACTIVE << 8);
+      tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M | TIM_CCMR1_OC2M)) |
+                   TIM_OCMODE_TOGGLE | (TIM_OCMODE_TOGGLE << 8);
+      TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_ENABLE);
+      TIM_CCxChannelCmd(tim, TIM_CHANNEL_2, TIM_CCx_ENABLE);
+      __HAL_TIM_MOE_ENABLE(axes[axis].htim);
+      axes[axis].quad_q = 0;
+      break;
 
-    /* reset the Preload enable bit for OC channel */
-    axes[axis].htim->Instance->CCMR1 &= ~(TIM_CCMR1_OC1PE);
+    case GEN_MODE_CW_CCW:
+      // the same pulses at both channels, the output enables one of them
+      tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M | TIM_CCMR1_OC2M)) |
+                   TIM_OCMODE_PWM1 | (TIM_OCMODE_PWM1 << 8);
+      tim->CCR1 = 0;
+      tim->CCR2 = 0;
+      TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+      TIM_CCxChannelCmd(tim, TIM_CHANNEL_2, TIM_CCx_DISABLE);
+      break;
+
+    default:
+      tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC1M)) | TIM_OCMODE_PWM1;
+      TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+      TIM_CCxChannelCmd(tim, TIM_CHANNEL_2, TIM_CCx_ENABLE);
+      GEN_dir_set(axis, axes[axis].dir);
+      break;
   }
+
+  return GEN_OK;
 }
 
 /*
- * low level steps generation function
+ * turn the step pulses self-verification off for the axis
  *
- * uses to generate a limit number of steps at the constant frequency
+ * the checker axis is the steps output again
  */
-void GEN_steps_output(uint8_t axis, uint16_t steps, uint32_t freq)
+void GEN_verify_off(uint8_t axis)
 {
-  // save last generation steps value
-  axes[axis].steps = steps;
+  uint8_t checker = verify[axis].checker;
 
-  // change prescaler/period only when new frequency is different
-  if ( freq != axes[axis].freq )
+  if ( checker == GEN_AXIS_NONE ) return;
+
+  verify[axis].checker = GEN_AXIS_NONE;
+  GEN_counter_off(checker);
+}
+
+/*
+ * use the axis timer as the step/dir input
+ *
+ * the step pin pulses are counted, the direction pin level is read,
+ * the forward direction is the low level as at the output
+ */
+enum GEN_ERR_t GEN_input_set(uint8_t axis)
+{
+  GPIO_InitTypeDef gpio = {0};
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( axes[axis].busy || verify[axis].counts || verify[axis].checker != GEN_AXIS_NONE ) return GEN_ERR_BUSY;
+  if ( axes[axis].gear_master != GEN_AXIS_NONE || axes[axis].gear_gate ) return GEN_ERR_GEAR;
+  if ( axes[axis].mode != GEN_MODE_STEP_DIR ) return GEN_ERR_MODE;
+
+  TIM_CCxChannelCmd(axes[axis].htim->Instance, TIM_CHANNEL_2, TIM_CCx_DISABLE);
+  gpio.Pin = GEN_DIR_PIN[axis];
+  gpio.Mode = GPIO_MODE_INPUT;
+  gpio.Pull = GPIO_NOPULL;
+  HAL_GPIO_Init(GEN_STEP_PORT[axis], &gpio);
+
+  GEN_counter_on(axis);
+  verify[axis].cnt = axes[axis].htim->Instance->CNT;
+
+  return GEN_OK;
+}
+
+/*
+ * the step/dir input axis is the steps output again
+ */
+void GEN_input_off(uint8_t axis)
+{
+  GPIO_InitTypeDef gpio = {0};
+
+  if ( axis >= GEN_AXIS_CNT || !verify[axis].counts ) return;
+  // the checker is released by its axis
+  for ( uint8_t a = GEN_AXIS_CNT; a--; ) if ( verify[a].checker == axis ) return;
+
+  GEN_counter_off(axis);
+
+  gpio.Pin = GEN_DIR_PIN[axis];
+  gpio.Mode = GPIO_MODE_AF_PP;
+  gpio.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(GEN_STEP_PORT[axis], &gpio);
+  TIM_CCxChannelCmd(axes[axis].htim->Instance, TIM_CHANNEL_2, TIM_CCx_ENABLE);
+  GEN_dir_set(axis, axes[axis].dir);
+}
+
+/*
+ * input steps since the previous call, signed by the direction input
+ *
+ * the direction is sampled at the call, so the calls period must be
+ * shorter than the input direction changes period and 65536 steps
+ */
+int32_t GEN_input_get(uint8_t axis)
+{
+  uint16_t  cnt = axes[axis].htim->Instance->CNT;
+  int32_t   n = (uint16_t)(cnt - verify[axis].cnt);
+
+  verify[axis].cnt = cnt;
+
+  return HAL_GPIO_ReadPin(GEN_STEP_PORT[axis], GEN_DIR_PIN[axis]) ? -n : n;
+}
+
+/*
+ * the override slew step from the override to the target one
+ */
+static uint16_t GEN_override_step(uint16_t ovr, uint16_t target)
+{
+  if ( ovr < target ) return ovr + GEN_OVR_STEP < target ? ovr + GEN_OVR_STEP : target;
+  return ovr > target + GEN_OVR_STEP ? ovr - GEN_OVR_STEP : target;
+}
+
+/*
+ * the source data of the axes group is running low
+ */
+static uint8_t GEN_group_low(uint8_t group)
+{
+  for ( uint8_t a = GEN_AXIS_CNT; a--; )
   {
-    // save last generation frequency value
-    axes[axis].freq = freq;
+    if ( (group & (1 << a)) && profile[a].on && profile[a].low ) return 1;
+  }
 
-    // calculate the period and prescaler
-    axes[axis].presc = axes[axis].tim_freq / freq / 65536;
-    axes[axis].period = axes[axis].tim_freq / freq / (axes[axis].presc + 1);
+  return 0;
+}
 
-    // set timer's data
-    __HAL_TIM_SET_AUTORELOAD(axes[axis].htim, axes[axis].period - 1);
-    __HAL_TIM_SET_COMPARE(axes[axis].htim, TIM_CHANNEL_1, axes[axis].period/2 - 1);
-    __HAL_TIM_SET_PRESCALER(axes[axis].htim, axes[axis].presc);
-    // generate the Update event to apply the new prescaler
-    axes[axis].htim->Instance->EGR |= (TIM_EGR_UG);
+/*
+ * global override slew
+ *
+ * the next override step is scheduled when all profile outputs have passed
+ * the previous one, at the source time of the axes started together which keeps
+ * their acceleration limits. The starving source slows the outputs of its axes
+ * group down to GEN_OVR_MIN, they speed up back when the data comes.
+ * The other outputs keep the global override
+ */
+static void GEN_override_process(void)
+{
+  struct PRF_t* prf;
+  uint64_t      at, gap;
+  uint16_t      next, top;
+  uint8_t       axis, a, low = 0;
+
+  for ( axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( profile[axis].on && profile[axis].low ) low = 1;
   }
 
-  // reset the CR1 timer enable bit in the DMA array cell
-  // this uses to stop timer immidiately after DMA transfer complete
-  DMA_array[axis][steps - 1] &= ~(TIM_CR1_CEN);
+  if ( low && !starve_on )
+  {
+    ++starves;
+    starve_time = HAL_GetTick();
+  }
+  starve_on = low;
+
+  for ( axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( profile[axis].on && !profile[axis].exact && profile[axis].ovr_pending ) return;
+  }
+
+  ovr_cur = GEN_override_step(ovr_cur, ovr_req);
+
+  for ( axis = GEN_AXIS_CNT; axis--; )
+  {
+    prf = &profile[axis];
+
+    // the exact rate output doesn't wait for the override step
+    if ( !prf->on || prf->exact )
+    {
+      prf->ovr = ovr_cur;
+      continue;
+    }
+
+    // the axes of the group have the same override, they step together
+    next = GEN_override_step(prf->ovr, GEN_group_low(prf->group) ? GEN_OVR_MIN : ovr_cur);
+    if ( next == prf->ovr ) continue;
+    top = next > prf->ovr ? next : prf->ovr;
+
+    for ( at = 0, gap = 0, a = GEN_AXIS_CNT; a--; )
+    {
+      if ( !(prf->group & (1 << a)) || !profile[a].on || profile[a].exact ) continue;
+
+      if ( profile[a].src_time > at ) at = profile[a].src_time;
+      // the step is slow enough for every axis of the group
+      if ( GEN_override_gap(a, top, profile[a].axis_ovr, profile[a].axis_ovr) > gap )
+      {
+        gap = GEN_override_gap(a, top, profile[a].axis_ovr, profile[a].axis_ovr);
+      }
+    }
+
+    prf->ovr_at = at + gap;
+    prf->ovr_next = next;
+    prf->ovr_pending = 1;
+  }
+}
+
+/*
+ * set the global feed override, %
+ *
+ * it scales the profile outputs on the fly and the next GEN_move() outputs,
+ * the change slews by GEN_OVR_STEP inside the axes acceleration limits
+ */
+enum GEN_ERR_t GEN_override_set(uint16_t percent)
+{
+  if ( percent > GEN_OVR_MAX ) return GEN_ERR_FREQ;
+
+  // the time scale can't be infinite
+  ovr_req = percent < GEN_OVR_MIN ? GEN_OVR_MIN : percent;
+
+  return GEN_OK;
+}
+
+/*
+ * set the axis feed override, %
+ *
+ * it breaks the contour synchronization of the axes started together,
+ * so it's for the independent axes
+ */
+enum GEN_ERR_t GEN_axis_override_set(uint8_t axis, uint16_t percent)
+{
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( percent > GEN_OVR_MAX ) return GEN_ERR_FREQ;
+
+  axis_ovr_req[axis] = percent < GEN_OVR_MIN ? GEN_OVR_MIN : percent;
+
+  return GEN_OK;
+}
+
+/*
+ * the profile source data is running low
+ *
+ * uses by the steps sources which get the data from the host,
+ * the profile outputs of the axes started together slow down until the data comes
+ */
+void GEN_profile_low_set(uint8_t axis, uint8_t low)
+{
+  profile[axis].low = low;
+}
+
+/*
+ * the next profile of the axis runs at the source rate
+ *
+ * uses by the exact rate sources right before GEN_profile_set(),
+ * the feed overrides and the starvation slowdown don't scale the output
+ */
+void GEN_profile_exact_set(uint8_t axis)
+{
+  exact_req[axis] = 1;
+}
+
+/*
+ * prepare the variable periods steps output
+ *
+ * every timer period is loaded by the DMA burst from the circular ring,
+ * the ring halves are filled by GEN_process() from the steps source.
+ * The output starts by GEN_profile_start()
+ */
+enum GEN_ERR_t GEN_profile_set(uint8_t axis, GEN_PRF_SRC_t src, void* ctx)
+{
+  struct PRF_t* prf;
+  TIM_TypeDef*  tim;
+  uint32_t      ticks, freq_max, i;
+  uint64_t      load;
+  uint8_t       exact;
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  // the exact rate request is for this profile only
+  exact = exact_req[axis];
+  exact_req[axis] = 0;
+  // the geared master's pulse is the slaves gate, the profile pulse isn't
+  if ( axes[axis].gear_master != GEN_AXIS_NONE || axes[axis].gear_gate ) return GEN_ERR_GEAR;
+  // the checker's timer counts the other axis pulses
+  if ( axes[axis].busy || verify[axis].counts ) return GEN_ERR_BUSY;
+  if ( !src ) return GEN_ERR_STEPS;
+
+  prf = &profile[axis];
+  tim = axes[axis].htim->Instance;
+
+  prf->src = src;
+  prf->ctx = ctx;
+  prf->exact = exact;
+  prf->end = 0;
+  prf->wait = 0;
+  prf->late = 0;
+  prf->pulse = 0;
+  prf->pulse_lash = 0;
+  prf->next_lash = 0;
+  prf->lash = 0;
+  prf->held = 0;
+  prf->lash_slack = backlash[axis].slack;
+  prf->lash_ticks = backlash[axis].steps ? axes[axis].tim_freq / backlash[axis].freq : 0;
+  prf->slack[0] = GEN_SLACK_NONE;
+  prf->slack[1] = GEN_SLACK_NONE;
+  prf->lvl = axes[axis].dir;
+  prf->fill = 0;
+  prf->staged = 0;
+  prf->stage_cnt = 0;
+  prf->base = 0;
+  prf->tail = 0;
+  prf->underruns = 0;
+  prf->group = 1 << axis;
+  prf->src_time = 0;
+  prf->real_time = 0;
+  prf->out_time = 0;
+  prf->ovr = ovr_cur;
+  prf->ovr_pending = 0;
+  prf->axis_ovr = axis_ovr_req[axis];
+  prf->axis_ovr_at = 0;
+  prf->src_len = 0;
+  prf->low = 0;
+  // the update DMA request reads the period once for all its repetitions
+  // the quadrature edge isn't repeated, it would toggle back
+  prf->runs = IS_TIM_REPETITION_COUNTER_INSTANCE(tim) && axes[axis].dma_req == TIM_DMA_CC4 &&
+              axes[axis].mode != GEN_MODE_QUAD;
+  prf->base_time = GEN_PRF_PAD_TICKS;
+  prf->clk = 0;
+  prf->state[0] = PRF_FREE;
+  prf->state[1] = PRF_FREE;
+  prf->pulses[0] = 0;
+  prf->pulses[1] = 0;
+  prf->pulses_done = 0;
+
+  // periods are in the timer base clock ticks
+  ticks = axes[axis].pulse_clk ? axes[axis].pulse_clk :
+          (uint32_t)((uint64_t)GEN_PRF_PULSE_NS * axes[axis].tim_freq / 1000000000);
+  prf->pulse_ticks = ticks > 0x3FFF ? 0x3FFF : ticks ? ticks : 1;
+  ticks = (uint32_t)((uint64_t)GEN_DIR_SETUP_NS * axes[axis].tim_freq / 1000000000);
+  prf->setup_ticks = ticks > 0x3FFF ? 0x3FFF : ticks ? ticks : 1;
+  freq_max = limits[axis].freq_max ? limits[axis].freq_max : GEN_FREQ_MAX;
+  ticks = axes[axis].tim_freq / freq_max;
+  prf->min_ticks = ticks > 2*prf->pulse_ticks ? ticks : 2*prf->pulse_ticks;
+
+  // the max rate is throttled to the DMA bus share left by the running outputs,
+  // the shorter source intervals are delayed and caught up, no step is lost
+  load = GEN_dma_load(axis);
+  if ( load >= GEN_dma_budget() ) return GEN_ERR_BUS;
+  freq_max = (uint32_t)((GEN_dma_budget() - load) / (5 * axes[axis].dma_clk));
+  if ( freq_max < axes[axis].tim_freq / prf->min_ticks )
+  {
+    if ( !freq_max || axes[axis].tim_freq / freq_max > GEN_PRF_CHUNK_MAX ) return GEN_ERR_BUS;
+    prf->min_ticks = (axes[axis].tim_freq + freq_max - 1) / freq_max;
+  }
+  // the take-up pulses are inside the admitted max rate too
+  if ( prf->lash_ticks && prf->lash_ticks < prf->min_ticks ) prf->lash_ticks = prf->min_ticks;
+
+  // the ring is silent until the halves are filled
+  for ( i = 0; i < PRF_RING_SIZE; ++i )
+  {
+    PRF_ring[axis][i][0] = 0;
+    PRF_ring[axis][i][1] = GEN_PRF_PAD_TICKS - 1;
+    PRF_ring[axis][i][2] = 0;
+    PRF_ring[axis][i][3] = axes[axis].mode == GEN_MODE_QUAD ? 0xFFFF : 0;
+    PRF_ring[axis][i][4] = axes[axis].mode == GEN_MODE_CW_CCW ? 0 : 0xFFFF;
+    PRF_step[axis][i] = 0;
+  }
+
+  // both halves are ready at the start if the source has the data
+  GEN_profile_fill(axis);
+  GEN_profile_fill(axis);
+  if ( prf->state[0] == PRF_FREE ) prf->state[0] = PRF_SILENT;
+
+  // the silent period before the ring, its CC1 match or the CC4 request
+  // of the Update event below loads the first period
+  tim->CR1 &= ~(TIM_CR1_CEN);
+  tim->CR1 |= (TIM_CR1_ARPE);
+  tim->CCMR1 |= (TIM_CCMR1_OC1PE | TIM_CCMR1_OC2PE);
+  tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_OC2M)) |
+    ((axes[axis].mode == GEN_MODE_CW_CCW ? TIM_OCMODE_PWM1 : TIM_OCMODE_TOGGLE) << 8);
+  tim->PSC = 0;
+  tim->ARR = GEN_PRF_PAD_TICKS - 1;
+  tim->CCR1 = axes[axis].mode == GEN_MODE_QUAD ? 0xFFFF : 0;
+  tim->CCR2 = axes[axis].mode == GEN_MODE_CW_CCW ? 0 : 0xFFFF;
+  if ( IS_TIM_REPETITION_COUNTER_INSTANCE(tim) ) tim->RCR = 0;
+  tim->EGR = TIM_EGR_UG;
+
+  // the CC4 request is at the Update event, the whole period is for the burst
+  // and the repeated period is read once. The quadrature CC1 isn't at every period
+  if ( axes[axis].dma_req == TIM_DMA_CC4 || axes[axis].mode == GEN_MODE_QUAD ) tim->CR2 |= (TIM_CR2_CCDS);
+
+  // the DMA burst writes PSC, ARR, RCR, CCR1, CCR2 (RCR is reserved at TIM2..TIM4),
+  // all of them are preloaded to the next Update event
+  tim->DCR = TIM_DMABASE_PSC | TIM_DMABURSTLENGTH_5TRANSFERS;
 
-  /* Disable the peripheral */
   __HAL_DMA_DISABLE(axes[axis].hdma);
-  /* Configure DMA Channel data length */
-  axes[axis].hdma->Instance->CNDTR = steps;
-  /* Configure DMA Channel destination address */
-  axes[axis].hdma->Instance->CPAR = (uint32_t)&(axes[axis].htim->Instance->CR1);
-  /* Configure DMA Channel source address */
-  axes[axis].hdma->Instance->CMAR = (uint32_t)&DMA_array[axis][0];
-  /* Enable the Peripheral */
+  axes[axis].hdma->Instance->CCR = (dma_ccr[axis] & DMA_CCR_PL) |
+    DMA_CCR_DIR | DMA_CCR_CIRC | DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0 |
+    DMA_CCR_HTIE | DMA_CCR_TCIE;
+  axes[axis].hdma->Instance->CNDTR = PRF_RING_SIZE*5;
+  axes[axis].hdma->Instance->CPAR = (uint32_t)&(tim->DMAR);
+  axes[axis].hdma->Instance->CMAR = (uint32_t)&PRF_ring[axis][0][0];
   __HAL_DMA_ENABLE(axes[axis].hdma);
-  /* Enable the transfer complete interrupt */
-  __HAL_DMA_ENABLE_IT(axes[axis].hdma, DMA_IT_TC);
-  /* Enable the TIM Capture/Compare 1 DMA request */
-  __HAL_TIM_ENABLE_DMA(axes[axis].htim, TIM_DMA_CC1);
-  /* Enable the Capture compare channel */
-  TIM_CCxChannelCmd(axes[axis].htim->Instance, TIM_CHANNEL_1, TIM_CCx_ENABLE);
-  /* Enable the main output */
+
+  __HAL_TIM_ENABLE_DMA(axes[axis].htim, axes[axis].dma_req);
+  if ( tim->CR2 & TIM_CR2_CCDS ) tim->EGR = TIM_EGR_UG;
+  TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_ENABLE);
+  // the profile routes every pulse to its channel by the compares
+  if ( axes[axis].mode == GEN_MODE_CW_CCW ) TIM_CCxChannelCmd(tim, TIM_CHANNEL_2, TIM_CCx_ENABLE);
   __HAL_TIM_MOE_ENABLE(axes[axis].htim);
-  /* Enable the Peripheral */
-  __HAL_TIM_ENABLE(axes[axis].htim);
+
+  prf->on = 1;
+  axes[axis].busy = 1;
+  // the profile may reach the axis max rate
+  axes[axis].rate = axes[axis].tim_freq / prf->min_ticks;
+  GEN_dma_priorities_update();
+  GEN_verify_start(axis);
+
+  return GEN_OK;
+}
+
+/*
+ * start the prepared profile outputs of the axes at the same time
+ *
+ * axes_mask bit 0 is the axis 0
+ */
+void GEN_profile_start(uint8_t axes_mask)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( (axes_mask & (1 << axis)) && profile[axis].on )
+    {
+      // the axes started together share the override switch time
+      profile[axis].group = axes_mask;
+      // the repeated periods pulses are counted by the time from here
+      profile[axis].cyc = DWT->CYCCNT;
+      axes[axis].htim->Instance->CR1 |= (TIM_CR1_CEN);
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+/*
+ * background generation tasks
+ *
+ * uses in the main() infinite loop
+ */
+void GEN_process(void)
+{
+  GEN_override_process();
+
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( profile[axis].on ) GEN_profile_fill(axis);
+  }
 }
 
 
@@ -149,6 +2203,13 @@ void GEN_steps_output(uint8_t axis, uint16_t steps, uint32_t freq)
  */
 void GEN_SYSTICK_IRQHandler(void)
 {
+  // the checkers counters and the profiles clocks counter don't wrap between the reads
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    GEN_verify_count(axis);
+    GEN_profile_clock(axis);
+  }
+
 #if TEST_1_ENABLED
 #define CNT 8
   static uint8_t axis = 0;
@@ -177,13 +2238,21 @@ void GEN_SYSTICK_IRQHandler(void)
  */
 void GEN_DMA_transfer_complete(uint8_t axis)
 {
-  /* Disable the TIM Capture/Compare 1 DMA request */
-  __HAL_TIM_DISABLE_DMA(axes[axis].htim, TIM_DMA_CC1);
-  /* Disable the Capture compare channel */
-  TIM_CCxChannelCmd(axes[axis].htim->Instance, TIM_CHANNEL_1, TIM_CCx_DISABLE);
-  /* Disable the Main Output */
-  __HAL_TIM_MOE_DISABLE(axes[axis].htim);
+  uint32_t start = DWT->CYCCNT;
 
-  // set the CR1 timer enable bit in the DMA array cell
-  DMA_array[axis][axes[axis].steps - 1] |= (TIM_CR1_CEN);
+  GEN_output_complete(axis);
+  GEN_isr_stat_add(axis, start);
+}
+
+/*
+ * DMA half transfer handler
+ *
+ * uses in the DMA channel IRQ handlers
+ */
+void GEN_DMA_half_transfer(uint8_t axis)
+{
+  uint32_t start = DWT->CYCCNT;
+
+  GEN_profile_half_done(axis, 0);
+  GEN_isr_stat_add(axis, start);
 }
@@ -0,0 +1,255 @@
+/**
+  ******************************************************************************
+  * File Name          : homing.c
+  * Description        : axes homing functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "homing.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+// axes homing data array
+static struct HOME_t homes[GEN_AXIS_CNT] =
+{
+  {GPIOA, GPIO_PIN_2, EXTI2_IRQn,   1,0,0,0,0,0,HOME_IDLE,0,0},
+  {GPIOA, GPIO_PIN_3, EXTI3_IRQn,   1,0,0,0,0,0,HOME_IDLE,0,0},
+  {GPIOB, GPIO_PIN_8, EXTI9_5_IRQn, 1,0,0,0,0,0,HOME_IDLE,0,0},
+  {GPIOB, GPIO_PIN_9, EXTI9_5_IRQn, 1,0,0,0,0,0,HOME_IDLE,0,0}
+};
+
+// axis position at the current homing state start
+static int32_t start_pos[GEN_AXIS_CNT] = {0};
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * home switch is pressed, it closes the input to the ground
+ */
+static uint8_t HOME_switch(uint8_t axis)
+{
+  return HAL_GPIO_ReadPin(homes[axis].port, homes[axis].pin) == GPIO_PIN_RESET;
+}
+
+/*
+ * steps done in the current homing state
+ */
+static uint32_t HOME_travel(uint8_t axis)
+{
+  int32_t travel = GEN_position_get(axis) - start_pos[axis];
+
+  return travel < 0 ? -travel : travel;
+}
+
+/*
+ * start the next homing steps output
+ *
+ * long moves are made by bursts of the DMA array size,
+ * the next burst starts from the output complete handler without a stop.
+ * The rejected output stops the homing with the error
+ */
+static enum GEN_ERR_t HOME_move(uint8_t axis, int8_t dir, uint32_t freq, uint32_t steps)
+{
+  uint32_t        travel = HOME_travel(axis);
+  enum GEN_ERR_t  err;
+
+  if ( travel >= homes[axis].travel_max )
+  {
+    homes[axis].state = HOME_ERROR;
+    return GEN_ERR_LIMIT;
+  }
+
+  if ( steps > homes[axis].travel_max - travel ) steps = homes[axis].travel_max - travel;
+  if ( steps > GEN_DMA_ARRAY_SIZE ) steps = GEN_DMA_ARRAY_SIZE;
+
+  GEN_dir_set(axis, dir);
+  err = GEN_steps_output(axis, steps, freq);
+  if ( err != GEN_OK ) homes[axis].state = HOME_ERROR;
+  else homes[axis].out = 1;
+
+  return err;
+}
+
+/*
+ * homing init
+ *
+ * uses in the main() after GEN_init()
+ */
+void HOME_init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct;
+
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    GPIO_InitStruct.Pin = homes[axis].pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    HAL_GPIO_Init(homes[axis].port, &GPIO_InitStruct);
+
+    HAL_NVIC_SetPriority(homes[axis].irq, 0, 0);
+    HAL_NVIC_EnableIRQ(homes[axis].irq);
+  }
+}
+
+/*
+ * axis homing settings
+ *
+ * the back-off must leave the switch, the zero one would stop the cycle
+ * at the switch, so it's rejected like the zero travel and frequencies
+ */
+enum GEN_ERR_t HOME_config(uint8_t axis, int8_t dir, uint32_t fast_freq, uint32_t slow_freq,
+                           uint16_t backoff, uint32_t travel_max, int32_t home_pos)
+{
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( homes[axis].state > HOME_IDLE && homes[axis].state < HOME_DONE ) return GEN_ERR_BUSY;
+  if ( !fast_freq || !slow_freq || fast_freq > GEN_FREQ_MAX || slow_freq > GEN_FREQ_MAX ) return GEN_ERR_FREQ;
+  if ( !backoff || !travel_max ) return GEN_ERR_STEPS;
+
+  homes[axis].dir = dir < 0 ? -1 : 1;
+  homes[axis].fast_freq = fast_freq;
+  homes[axis].slow_freq = slow_freq;
+  homes[axis].backoff = backoff;
+  homes[axis].travel_max = travel_max;
+  homes[axis].home_pos = home_pos;
+
+  return GEN_OK;
+}
+
+/*
+ * start the axis homing cycle
+ *
+ * fast seek -> back-off -> slow seek -> the position latch at the switch edge
+ */
+enum GEN_ERR_t HOME_start(uint8_t axis)
+{
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+
+  GEN_stop(axis);
+
+  start_pos[axis] = GEN_position_get(axis);
+
+  if ( HOME_switch(axis) )
+  {
+    // we are at the switch already
+    homes[axis].state = HOME_BACKOFF;
+    return HOME_move(axis, -homes[axis].dir, homes[axis].slow_freq, homes[axis].backoff);
+  }
+
+  homes[axis].state = HOME_SEEK_FAST;
+  return HOME_move(axis, homes[axis].dir, homes[axis].fast_freq, homes[axis].travel_max);
+}
+
+/*
+ * stop the axis homing cycle
+ *
+ * uses in the GEN_stop(), the stopped cycle is idle and the next outputs
+ * of the axis aren't the homing ones
+ */
+void HOME_abort(uint8_t axis)
+{
+  if ( axis >= GEN_AXIS_CNT ) return;
+
+  homes[axis].out = 0;
+  if ( homes[axis].state > HOME_IDLE && homes[axis].state < HOME_DONE ) homes[axis].state = HOME_IDLE;
+}
+
+/*
+ * axis homing state
+ */
+uint8_t HOME_state(uint8_t axis)
+{
+  return homes[axis].state;
+}
+
+
+
+
+/* Handlers ------------------------------------------------------------------*/
+
+/*
+ * home switch edge handler
+ *
+ * uses in the EXTI IRQ handlers
+ */
+void HOME_EXTI_IRQHandler(uint8_t axis)
+{
+  // read the live position before anything else
+  int32_t pos = GEN_position_get(axis);
+
+  switch ( homes[axis].state )
+  {
+    case HOME_SEEK_FAST:
+      GEN_stop(axis);
+      start_pos[axis] = GEN_position_get(axis);
+      homes[axis].state = HOME_BACKOFF;
+      HOME_move(axis, -homes[axis].dir, homes[axis].slow_freq, homes[axis].backoff);
+      break;
+
+    case HOME_SEEK_SLOW:
+      GEN_stop(axis);
+      homes[axis].latch = pos;
+      // the steps done after the edge are kept
+      GEN_position_set(axis, homes[axis].home_pos + GEN_position_get(axis) - pos);
+      homes[axis].state = HOME_DONE;
+      break;
+  }
+}
+
+/*
+ * steps output complete handler
+ *
+ * uses in the GEN_DMA_transfer_complete()
+ */
+void HOME_output_complete(uint8_t axis)
+{
+  uint32_t travel;
+
+  // the output isn't started by the homing
+  if ( !homes[axis].out ) return;
+  homes[axis].out = 0;
+
+  switch ( homes[axis].state )
+  {
+    case HOME_SEEK_FAST:
+      // no switch edge yet
+      HOME_move(axis, homes[axis].dir, homes[axis].fast_freq, homes[axis].travel_max);
+      break;
+
+    case HOME_SEEK_SLOW:
+      HOME_move(axis, homes[axis].dir, homes[axis].slow_freq, homes[axis].travel_max);
+      break;
+
+    case HOME_BACKOFF:
+      travel = HOME_travel(axis);
+      if ( travel < homes[axis].backoff )
+      {
+        HOME_move(axis, -homes[axis].dir, homes[axis].slow_freq, homes[axis].backoff - travel);
+      }
+      else if ( HOME_switch(axis) )
+      {
+        // the switch is still pressed, move further
+        HOME_move(axis, -homes[axis].dir, homes[axis].slow_freq, homes[axis].backoff);
+      }
+      else
+      {
+        start_pos[axis] = GEN_position_get(axis);
+        homes[axis].state = HOME_SEEK_SLOW;
+        HOME_move(axis, homes[axis].dir, homes[axis].slow_freq, homes[axis].travel_max);
+      }
+      break;
+  }
+}
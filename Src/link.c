@@ -0,0 +1,362 @@
+/**
+  ******************************************************************************
+  * File Name          : link.c
+  * Description        : host link functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "stream.h"
+#include "ramp.h"
+#include "slow.h"
+#include "arc.h"
+#include "pvt.h"
+#include "homing.h"
+#include "follow.h"
+#include "telemetry.h"
+#include "link.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+#define LINK_MASK (LINK_RX_SIZE - 1)
+#define LINK_FRAME_SIZE (sizeof(struct LINK_STATUS_t) + 2)
+
+// host link SPI slave
+extern SPI_HandleTypeDef hspi1;
+
+// received bytes ring, the DMA writes it
+static uint8_t rx[LINK_RX_SIZE] = {0};
+static uint16_t rx_head = 0;
+
+// received bytes taken out of the ring, the host flow control
+static volatile uint16_t parsed = 0;
+
+// executed commands count and the last one result << 8,
+// the status snapshot reads them by one load
+static volatile uint16_t done = 0;
+
+// two status frames, the DMA sends one while the other one is updated
+static uint8_t tx[2][LINK_FRAME_SIZE] = {{0}};
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * little endian payload fields
+ */
+static uint16_t LINK_u16(const uint8_t* p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t LINK_u32(const uint8_t* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * axis of the commands without a result, GEN_AXIS_NONE is allowed if any
+ */
+static uint8_t LINK_axis_check(uint8_t axis, uint8_t any)
+{
+  return axis < GEN_AXIS_CNT || (any && axis == GEN_AXIS_NONE) ? GEN_OK : GEN_ERR_AXIS;
+}
+
+/*
+ * execute the host command
+ *
+ * returns 0 if the command must be repeated later
+ */
+static uint8_t LINK_command(uint8_t cmd, const uint8_t* data, uint8_t len)
+{
+  struct LIMITS_t lim;
+  struct ARC_t    arc;
+  uint8_t         err = LINK_ERR_CMD;
+  uint8_t         axis;
+
+  switch ( cmd )
+  {
+    case LINK_CMD_STREAM:
+      if ( !len ) break;
+      err = STR_write(data[0], &data[1], len - 1);
+      // wait for the free space in the axis stream FIFO
+      if ( err == GEN_ERR_BUSY ) return 0;
+      break;
+
+    case LINK_CMD_STREAM_START:
+      if ( len >= 1 ) err = STR_start(data[0]);
+      break;
+
+    case LINK_CMD_OVERRIDE:
+      if ( len < 3 ) break;
+      if ( data[0] == GEN_AXIS_NONE ) err = GEN_override_set(LINK_u16(&data[1]));
+      else err = GEN_axis_override_set(data[0], LINK_u16(&data[1]));
+      break;
+
+    case LINK_CMD_STOP:
+      if ( len < 1 || (err = LINK_axis_check(data[0], 1)) != GEN_OK ) break;
+      for ( axis = GEN_AXIS_CNT; axis--; )
+      {
+        if ( data[0] == axis || data[0] == GEN_AXIS_NONE ) GEN_stop(axis);
+      }
+      break;
+
+    case LINK_CMD_MOVE:
+      if ( len >= 10 ) err = GEN_move(data[0], (int8_t)data[1], LINK_u32(&data[2]), LINK_u32(&data[6]));
+      break;
+
+    case LINK_CMD_PULSE_WIDTH:
+      if ( len >= 5 ) err = GEN_pulse_width_set(data[0], LINK_u32(&data[1]));
+      break;
+
+    case LINK_CMD_GEAR:
+      if ( len < 6 ) break;
+      if ( data[1] != GEN_AXIS_NONE ) err = GEN_gear_set(data[0], data[1], LINK_u16(&data[2]), LINK_u16(&data[4]));
+      else if ( (err = LINK_axis_check(data[0], 0)) == GEN_OK ) GEN_gear_off(data[0]);
+      break;
+
+    case LINK_CMD_HOME_CONFIG:
+      if ( len < 20 ) break;
+      err = HOME_config(data[0], (int8_t)data[1], LINK_u32(&data[2]), LINK_u32(&data[6]),
+                        LINK_u16(&data[10]), LINK_u32(&data[12]), (int32_t)LINK_u32(&data[16]));
+      break;
+
+    case LINK_CMD_HOME_START:
+      if ( len >= 1 ) err = HOME_start(data[0]);
+      break;
+
+    case LINK_CMD_LIMITS:
+      if ( len < 22 ) break;
+      lim.pos_min = (int32_t)LINK_u32(&data[1]);
+      lim.pos_max = (int32_t)LINK_u32(&data[5]);
+      lim.pos_on = data[9];
+      lim.freq_max = LINK_u32(&data[10]);
+      lim.freq_start = LINK_u32(&data[14]);
+      lim.accel = LINK_u32(&data[18]);
+      err = GEN_limits_set(data[0], &lim);
+      break;
+
+    case LINK_CMD_BACKLASH:
+      if ( len >= 7 ) err = GEN_backlash_set(data[0], LINK_u16(&data[1]), LINK_u32(&data[3]));
+      break;
+
+    case LINK_CMD_RAMP:
+      if ( len >= 11 ) err = RAMP_move(data[0], (int8_t)data[1], LINK_u32(&data[2]), data[6], LINK_u32(&data[7]));
+      break;
+
+    case LINK_CMD_RAMP_ACCEL:
+      if ( len < 18 ) break;
+      err = RAMP_move_accel(data[0], (int8_t)data[1], LINK_u32(&data[2]),
+                            LINK_u32(&data[6]), LINK_u32(&data[10]), LINK_u32(&data[14]));
+      break;
+
+    case LINK_CMD_ARC:
+      if ( len < 28 ) break;
+      arc.ax = data[0];
+      arc.ay = data[1];
+      arc.az = data[2];
+      arc.xe = (int32_t)LINK_u32(&data[3]);
+      arc.ye = (int32_t)LINK_u32(&data[7]);
+      arc.ze = (int32_t)LINK_u32(&data[11]);
+      arc.i = (int32_t)LINK_u32(&data[15]);
+      arc.j = (int32_t)LINK_u32(&data[19]);
+      arc.cw = data[23];
+      arc.feed = LINK_u32(&data[24]);
+      err = ARC_start(&arc);
+      break;
+
+    case LINK_CMD_PVT_ADD:
+      if ( len < 13 ) break;
+      err = PVT_add(data[0], (int32_t)LINK_u32(&data[1]), (int32_t)LINK_u32(&data[5]), LINK_u32(&data[9]));
+      break;
+
+    case LINK_CMD_PVT_START:
+      if ( len >= 1 ) err = PVT_start(data[0]);
+      break;
+
+    case LINK_CMD_PVT_END:
+      if ( len >= 1 ) err = PVT_end(data[0]);
+      break;
+
+    case LINK_CMD_TLM_RATE:
+      if ( len < 2 ) break;
+      TLM_rate_set(LINK_u16(&data[0]));
+      err = GEN_OK;
+      break;
+
+    case LINK_CMD_SLOW:
+      if ( len < 14 ) break;
+      err = SLOW_move(data[0], (int8_t)data[1], LINK_u32(&data[2]), LINK_u32(&data[6]), LINK_u32(&data[10]));
+      break;
+
+    case LINK_CMD_VERIFY:
+      if ( len < 2 ) break;
+      if ( data[1] != GEN_AXIS_NONE ) err = GEN_verify_set(data[0], data[1]);
+      else if ( (err = LINK_axis_check(data[0], 0)) == GEN_OK ) GEN_verify_off(data[0]);
+      break;
+
+    case LINK_CMD_MODE:
+      if ( len >= 2 ) err = GEN_mode_set(data[0], (enum GEN_MODE_t)data[1]);
+      break;
+
+    case LINK_CMD_FOLLOW:
+      if ( len >= 11 ) err = FOL_start(data[0], data[1], LINK_u32(&data[2]), LINK_u32(&data[6]), data[10]);
+      break;
+
+    case LINK_CMD_FOLLOW_STOP:
+      if ( len < 1 || (err = LINK_axis_check(data[0], 0)) != GEN_OK ) break;
+      FOL_stop(data[0]);
+      break;
+
+    default: break;
+  }
+
+  done = ((done + 1) & 0xFF) | (err << 8);
+
+  return 1;
+}
+
+/*
+ * take the bytes out of the receive ring
+ */
+static void LINK_skip(uint16_t n)
+{
+  rx_head = (rx_head + n) & LINK_MASK;
+  parsed += n;
+}
+
+/*
+ * fill the status frame, it's a snapshot at the fill time
+ */
+static void LINK_status_fill(uint8_t* frame)
+{
+  struct LINK_STATUS_t  st;
+  uint16_t              cmd = done;
+  uint8_t               sum = 0;
+  uint8_t               i;
+
+  st.parsed = parsed;
+  for ( i = 0; i < GEN_AXIS_CNT; ++i ) st.stream_free[i] = STR_free(i);
+  st.cmds = cmd & 0xFF;
+  st.result = cmd >> 8;
+
+  frame[0] = LINK_SYNC;
+  for ( i = 0; i < sizeof(st); ++i )
+  {
+    frame[1 + i] = ((uint8_t*)&st)[i];
+    sum ^= frame[1 + i];
+  }
+  frame[LINK_FRAME_SIZE - 1] = sum;
+}
+
+/*
+ * host link init
+ *
+ * uses in the main() before infinite loop start
+ */
+void LINK_init(void)
+{
+  LINK_status_fill(tx[0]);
+  LINK_status_fill(tx[1]);
+
+  // the master's bytes go to the ring without the CPU
+  LINK_DMA_RX->CCR = DMA_CCR_PL_1 | DMA_CCR_CIRC | DMA_CCR_MINC;
+  LINK_DMA_RX->CNDTR = LINK_RX_SIZE;
+  LINK_DMA_RX->CPAR = (uint32_t)&(hspi1.Instance->DR);
+  LINK_DMA_RX->CMAR = (uint32_t)&rx[0];
+  LINK_DMA_RX->CCR |= (DMA_CCR_EN);
+
+  // the status frames are sent all the time, the sent one is updated
+  LINK_DMA_TX->CCR = DMA_CCR_PL_0 | DMA_CCR_DIR | DMA_CCR_CIRC | DMA_CCR_MINC |
+                     DMA_CCR_HTIE | DMA_CCR_TCIE;
+  LINK_DMA_TX->CNDTR = sizeof(tx);
+  LINK_DMA_TX->CPAR = (uint32_t)&(hspi1.Instance->DR);
+  LINK_DMA_TX->CMAR = (uint32_t)&tx[0][0];
+  LINK_DMA_TX->CCR |= (DMA_CCR_EN);
+
+  HAL_NVIC_SetPriority(LINK_DMA_TX_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(LINK_DMA_TX_IRQn);
+
+  hspi1.Instance->CR2 |= (SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+  __HAL_SPI_ENABLE(&hspi1);
+}
+
+/*
+ * parse and execute the received frames
+ *
+ * uses in the main() infinite loop
+ */
+void LINK_process(void)
+{
+  static uint8_t  data[255];
+  uint16_t        avail, i;
+  uint8_t         len, sum;
+
+  for ( ;; )
+  {
+    avail = (LINK_RX_SIZE - LINK_DMA_RX->CNDTR - rx_head) & LINK_MASK;
+
+    // skip the bytes out of the frames
+    while ( avail && rx[rx_head] != LINK_SYNC )
+    {
+      LINK_skip(1);
+      --avail;
+    }
+
+    if ( avail < 3 ) return;
+
+    len = rx[(rx_head + 2) & LINK_MASK];
+    if ( avail < len + 4 ) return;
+
+    sum = rx[(rx_head + 1) & LINK_MASK] ^ len;
+    for ( i = 0; i < len; ++i )
+    {
+      data[i] = rx[(rx_head + 3 + i) & LINK_MASK];
+      sum ^= data[i];
+    }
+
+    if ( sum != rx[(rx_head + 3 + len) & LINK_MASK] )
+    {
+      // wrong frame, look for the next sync byte
+      LINK_skip(1);
+      continue;
+    }
+
+    if ( !LINK_command(rx[(rx_head + 1) & LINK_MASK], data, len) ) return;
+
+    LINK_skip(len + 4);
+  }
+}
+
+
+
+
+/* Handlers ------------------------------------------------------------------*/
+
+/*
+ * status frame is sent handler
+ *
+ * uses in the DMA1_Channel3_IRQHandler()
+ */
+void LINK_DMA_IRQHandler(void)
+{
+  uint32_t isr = DMA1->ISR;
+
+  DMA1->IFCR = LINK_DMA_TX_IFCR;
+
+  // the half is read by the DMA, its frame is free for the next snapshot
+  if ( isr & LINK_DMA_TX_HT ) LINK_status_fill(tx[0]);
+  if ( isr & LINK_DMA_TX_TC ) LINK_status_fill(tx[1]);
+}
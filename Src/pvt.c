@@ -0,0 +1,316 @@
+/**
+  ******************************************************************************
+  * File Name          : pvt.c
+  * Description        : position-velocity-time segments functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "pvt.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+// segment time of the segment end, 8.24 fixed point
+#define PVT_U_END (1L << 24)
+
+// axes PVT data array
+static struct PVT_t pvts[GEN_AXIS_CNT] = {0};
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * segment position at the segment time u, 24.8 fixed point steps
+ */
+static int64_t PVT_position(const struct PVT_t* pvt, uint32_t u)
+{
+  int64_t p = pvt->d;
+
+  p = pvt->c + (p * u >> 24);
+  p = pvt->b + (p * u >> 24);
+
+  return p * u >> 24;
+}
+
+/*
+ * add the velocity extremum of the segment to the pieces ends
+ */
+static void PVT_piece_add(struct PVT_t* pvt, int64_t u)
+{
+  if ( u <= 0 || u >= PVT_U_END ) return;
+
+  if ( pvt->pieces && pvt->piece_end[0] > u )
+  {
+    pvt->piece_end[1] = pvt->piece_end[0];
+    pvt->piece_end[0] = (uint32_t)u;
+  }
+  else pvt->piece_end[pvt->pieces] = (uint32_t)u;
+
+  ++pvt->pieces;
+}
+
+/*
+ * start the next queued segment
+ *
+ * the cubic Hermite profile is split into the monotonic pieces
+ * at the roots of its velocity
+ */
+static uint8_t PVT_next(struct PVT_t* pvt)
+{
+  struct PVT_SEG_t* seg;
+  int64_t           D, V0, V1, B, C, Dd, dis, sq;
+
+  if ( pvt->head == pvt->tail ) return 0;
+
+  seg = &pvt->queue[pvt->head];
+
+  // p(u) = V0*u + (3*D - 2*V0 - V1)*u^2 + (V0 + V1 - 2*D)*u^3
+  // the velocities are scaled by the duration, p(1) = D exactly
+  pvt->end = seg->pos - pvt->p0;
+  D = (int64_t)pvt->end * 256;
+  V0 = (int64_t)pvt->v0 * seg->us * 256 / 1000000;
+  V1 = (int64_t)seg->vel * seg->us * 256 / 1000000;
+  pvt->b = V0;
+  pvt->c = 3*D - 2*V0 - V1;
+  pvt->d = V0 + V1 - 2*D;
+  pvt->ticks = (uint64_t)seg->us * GEN_tim_freq_get(pvt - pvts) / 1000000;
+
+  // velocity roots of b + 2*c*u + 3*d*u^2, 28.4 fixed point coefficients
+  // to keep the discriminant in 64 bits
+  B = pvt->b / 16;
+  C = pvt->c / 16;
+  Dd = pvt->d / 16;
+  pvt->pieces = 0;
+
+  if ( Dd )
+  {
+    dis = C*C - 3*Dd*B;
+    if ( dis > 0 )
+    {
+      sq = GEN_isqrt(dis);
+      PVT_piece_add(pvt, (-C - sq) * (int64_t)PVT_U_END / (3*Dd));
+      PVT_piece_add(pvt, (-C + sq) * (int64_t)PVT_U_END / (3*Dd));
+    }
+  }
+  else if ( C )
+  {
+    PVT_piece_add(pvt, -B * (int64_t)PVT_U_END / (2*C));
+  }
+
+  pvt->piece_end[pvt->pieces++] = PVT_U_END;
+  pvt->piece = 0;
+  pvt->u = 0;
+  pvt->s = 0;
+  pvt->active = 1;
+
+  // the next segment starts here
+  pvt->p0 = seg->pos;
+  pvt->v0 = seg->vel;
+  pvt->head = (pvt->head + 1) % PVT_QUEUE_SIZE;
+
+  return 1;
+}
+
+/*
+ * PVT axis steps source
+ *
+ * the step is at the crossing of the next integer position,
+ * its time is found by the bisection inside the monotonic piece
+ */
+static uint32_t PVT_source(void* ctx, int8_t* dir)
+{
+  struct PVT_t* pvt = ctx;
+  int64_t       p, target;
+  uint32_t      lo, hi, mid, ticks;
+  uint64_t      t;
+  int8_t        sd;
+
+  // the last queued segment is running, the outputs slow down for the next ones
+  GEN_profile_low_set(pvt - pvts, pvt->open && pvt->head == pvt->tail);
+
+  for ( ;; )
+  {
+    if ( !pvt->active && !PVT_next(pvt) )
+    {
+      // the open motion waits for the next segments
+      if ( pvt->open ) return GEN_PRF_WAIT;
+
+      // the queue is empty, the motion ends
+      pvt->on = 0;
+      return 0;
+    }
+
+    while ( pvt->piece < pvt->pieces )
+    {
+      hi = pvt->piece_end[pvt->piece];
+      p = PVT_position(pvt, hi);
+
+      if ( p >= ((int64_t)pvt->s + 1) * 256 ) sd = 1;
+      else if ( p <= ((int64_t)pvt->s - 1) * 256 ) sd = -1;
+      else
+      {
+        ++pvt->piece;
+        continue;
+      }
+
+      target = ((int64_t)pvt->s + sd) * 256;
+
+      for ( lo = pvt->u; hi - lo > 1; )
+      {
+        mid = lo + (hi - lo) / 2;
+        p = PVT_position(pvt, mid);
+        if ( sd > 0 ? p >= target : p <= target ) hi = mid;
+        else lo = mid;
+      }
+
+      pvt->u = hi;
+      pvt->s += sd;
+
+      t = pvt->start + (pvt->ticks * hi >> 24);
+      ticks = (uint32_t)(t - pvt->last);
+      pvt->last = t;
+
+      *dir = sd;
+      // 0 is the profile end
+      return ticks ? ticks : 1;
+    }
+
+    // the segment end
+    pvt->start += pvt->ticks;
+    pvt->active = 0;
+  }
+}
+
+/*
+ * queue the PVT segment of the axis
+ *
+ * the segment starts at the end of the previous one, the first one
+ * starts at the axis position with zero velocity
+ */
+enum GEN_ERR_t PVT_add(uint8_t axis, int32_t pos, int32_t vel, uint32_t us)
+{
+  struct PVT_t* pvt;
+  uint8_t       next;
+  int64_t       v;
+  enum GEN_ERR_t err;
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+
+  pvt = &pvts[axis];
+  next = (pvt->tail + 1) % PVT_QUEUE_SIZE;
+
+  if ( next == pvt->head ) return GEN_ERR_BUSY;
+  // the ended motion may have passed its queue end already
+  if ( pvt->on && !pvt->open ) return GEN_ERR_BUSY;
+  if ( !us ) return GEN_ERR_STEPS;
+
+  if ( !pvt->on && pvt->head == pvt->tail )
+  {
+    pvt->q_pos = GEN_position_get(axis);
+    pvt->q_vel = 0;
+  }
+
+  // keep the cubic coefficients in the 64 bit math range
+  v = (int64_t)pos - pvt->q_pos;
+  if ( v > PVT_STEPS_MAX || v < -PVT_STEPS_MAX ) return GEN_ERR_STEPS;
+  v = (int64_t)vel * us / 1000000;
+  if ( v > PVT_STEPS_MAX || v < -PVT_STEPS_MAX ) return GEN_ERR_FREQ;
+  v = (int64_t)pvt->q_vel * us / 1000000;
+  if ( v > PVT_STEPS_MAX || v < -PVT_STEPS_MAX ) return GEN_ERR_FREQ;
+
+  if ( (err = GEN_limits_check(axis, pos)) != GEN_OK ) return err;
+
+  pvt->queue[pvt->tail].pos = pos;
+  pvt->queue[pvt->tail].vel = vel;
+  pvt->queue[pvt->tail].us = us;
+  pvt->tail = next;
+
+  pvt->q_pos = pos;
+  pvt->q_vel = vel;
+
+  return GEN_OK;
+}
+
+/*
+ * start the queued PVT segments of the axes at the same time
+ *
+ * axes_mask bit 0 is the axis 0, the axes segments must have the same durations
+ * to stay synchronized. The segments are added while the motion runs,
+ * it ends at the empty axis queue after PVT_end()
+ */
+enum GEN_ERR_t PVT_start(uint8_t axes_mask)
+{
+  struct PVT_t*   pvt;
+  uint8_t         ready = 0;
+  enum GEN_ERR_t  err;
+
+  for ( uint8_t axis = 0; axis < GEN_AXIS_CNT; ++axis )
+  {
+    if ( !(axes_mask & (1 << axis)) ) continue;
+
+    pvt = &pvts[axis];
+    pvt->p0 = GEN_position_get(axis);
+    pvt->v0 = 0;
+    pvt->active = 0;
+    pvt->start = 0;
+    pvt->last = 0;
+    pvt->on = 1;
+    pvt->open = 1;
+
+    err = GEN_profile_set(axis, PVT_source, pvt);
+    if ( err != GEN_OK )
+    {
+      pvt->on = 0;
+      pvt->open = 0;
+
+      // release the prepared axes
+      for ( axis = GEN_AXIS_CNT; axis--; )
+      {
+        if ( ready & (1 << axis) )
+        {
+          pvts[axis].on = 0;
+          pvts[axis].open = 0;
+          GEN_stop(axis);
+        }
+      }
+
+      return err;
+    }
+
+    ready |= 1 << axis;
+  }
+
+  GEN_profile_start(ready);
+
+  return GEN_OK;
+}
+
+/*
+ * no more segments of the axes motions
+ *
+ * the axis motion ends when its queue is played
+ */
+enum GEN_ERR_t PVT_end(uint8_t axes_mask)
+{
+  for ( uint8_t axis = 0; axis < GEN_AXIS_CNT; ++axis )
+  {
+    if ( !(axes_mask & (1 << axis)) ) continue;
+
+    pvts[axis].open = 0;
+    GEN_profile_low_set(axis, 0);
+  }
+
+  return GEN_OK;
+}
@@ -0,0 +1,265 @@
+/**
+  ******************************************************************************
+  * File Name          : ramp.c
+  * Description        : acceleration ramps functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "ramp.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+#define RAMP_SCALE_ONE (1UL << 16)
+
+// axes ramp moves data array
+static struct RAMP_t ramps[GEN_AXIS_CNT] = {0};
+
+// recently used computed ramps
+static struct RAMP_CACHE_t cache[RAMP_CACHE_CNT] = {0};
+static struct RAMP_CACHE_STAT_t cache_stat = {0};
+static uint32_t cache_clock = 0;
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * ramp move steps source
+ *
+ * the acceleration is the table, the deceleration is the same table backwards
+ */
+static uint32_t RAMP_source(void* ctx, int8_t* dir)
+{
+  struct RAMP_t*  r = ctx;
+  uint32_t        t;
+
+  if ( r->step >= r->steps ) return 0;
+
+  if ( r->step < r->acc ) t = r->table->ticks[r->step];
+  else if ( r->step < r->steps - r->acc ) t = r->cruise;
+  else t = r->table->ticks[r->steps - 1 - r->step];
+
+  ++r->step;
+  *dir = r->dir;
+
+  if ( r->scale != RAMP_SCALE_ONE ) t = (uint32_t)((uint64_t)t * r->scale >> 16);
+
+  // 0 is the profile end
+  return t ? t : 1;
+}
+
+/*
+ * the ramp is inside the axis motion limits
+ */
+static enum GEN_ERR_t RAMP_limits_check(uint8_t axis, uint32_t accel, uint32_t freq_start, uint32_t freq)
+{
+  const struct LIMITS_t* lim = GEN_limits_get(axis);
+
+  if ( freq > (lim->freq_max ? lim->freq_max : GEN_FREQ_MAX) ) return GEN_ERR_FREQ;
+  if ( lim->accel && accel > lim->accel ) return GEN_ERR_FREQ;
+  if ( lim->freq_start && freq_start > lim->freq_start ) return GEN_ERR_FREQ;
+
+  return GEN_OK;
+}
+
+/*
+ * start the ramp move of the axis
+ */
+static enum GEN_ERR_t RAMP_run(uint8_t axis, int8_t dir, uint32_t steps,
+                               const struct RAMP_TABLE_t* tab, uint32_t freq)
+{
+  struct RAMP_t*  r;
+  uint32_t        tim_freq, cruise;
+  uint16_t        lo, hi, mid;
+  enum GEN_ERR_t  err;
+
+  // the running move data must stay intact
+  if ( GEN_busy(axis) ) return GEN_ERR_BUSY;
+
+  err = GEN_limits_check(axis, GEN_position_get(axis) + (dir < 0 ? -(int32_t)steps : (int32_t)steps));
+  if ( err != GEN_OK ) return err;
+
+  r = &ramps[axis];
+  tim_freq = GEN_tim_freq_get(axis);
+  cruise = RAMP_TIM_FREQ / freq;
+
+  // the acceleration ends at the first interval not longer than the cruise one
+  for ( lo = 0, hi = tab->size; lo < hi; )
+  {
+    mid = lo + (hi - lo) / 2;
+    if ( tab->ticks[mid] > cruise ) lo = mid + 1;
+    else hi = mid;
+  }
+
+  r->table = tab;
+  r->dir = dir < 0 ? -1 : 1;
+  r->steps = steps;
+  r->step = 0;
+  r->acc = lo < steps / 2 ? lo : steps / 2;
+  // the short move peaks at the next table interval
+  r->cruise = r->acc < lo ? tab->ticks[r->acc] : cruise;
+  r->scale = tim_freq == RAMP_TIM_FREQ ? RAMP_SCALE_ONE :
+             (uint32_t)(((uint64_t)tim_freq << 16) / RAMP_TIM_FREQ);
+
+  err = GEN_profile_set(axis, RAMP_source, r);
+  if ( err != GEN_OK )
+  {
+    r->steps = 0;
+    return err;
+  }
+
+  GEN_profile_start(1 << axis);
+
+  return GEN_OK;
+}
+
+/*
+ * the cache entry is the ramp of the running move
+ */
+static uint8_t RAMP_cache_busy(const struct RAMP_CACHE_t* e)
+{
+  for ( uint8_t axis = GEN_AXIS_CNT; axis--; )
+  {
+    if ( ramps[axis].table == &e->table && ramps[axis].step < ramps[axis].steps && GEN_busy(axis) ) return 1;
+  }
+
+  return 0;
+}
+
+/*
+ * steps of the ramp from the start frequency to the freq, (v^2 - v0^2) / 2a
+ */
+static uint64_t RAMP_size(uint32_t accel, uint32_t freq_start, uint32_t freq)
+{
+  return ((uint64_t)freq * freq - (uint64_t)freq_start * freq_start + 2ULL*accel - 1) / (2ULL*accel);
+}
+
+/*
+ * find the computed ramp in the cache or compute it to the least recently used entry
+ *
+ * the step k is at t = (sqrt(v0^2 + 2*a*k) - v0) / a, the root is 20.12 fixed point
+ */
+static const struct RAMP_TABLE_t* RAMP_cache_get(uint32_t accel, uint32_t freq_start, uint32_t freq)
+{
+  struct RAMP_CACHE_t*  e;
+  struct RAMP_CACHE_t*  lru = 0;
+  uint64_t              v0, t, prev;
+  uint64_t              size;
+
+  for ( e = &cache[0]; e < &cache[RAMP_CACHE_CNT]; ++e )
+  {
+    if ( e->used && e->table.accel == accel && e->freq_start == freq_start && e->table.freq_max == freq )
+    {
+      e->used = ++cache_clock;
+      ++cache_stat.hits;
+      return &e->table;
+    }
+
+    if ( !RAMP_cache_busy(e) && (!lru || e->used < lru->used) ) lru = e;
+  }
+
+  ++cache_stat.misses;
+
+  size = RAMP_size(accel, freq_start, freq);
+  if ( !lru || size > RAMP_CACHE_SIZE ) return 0;
+
+  if ( lru->used ) ++cache_stat.evictions;
+
+  v0 = (uint64_t)freq_start << 12;
+  prev = 0;
+
+  for ( uint32_t k = 0; k < size; ++k )
+  {
+    t = GEN_isqrt(((uint64_t)freq_start * freq_start + 2ULL * accel * (k + 1)) << 24);
+    t = (t - v0) * RAMP_TIM_FREQ / ((uint64_t)accel << 12);
+    lru->ticks[k] = (uint32_t)(t - prev);
+    prev = t;
+  }
+
+  lru->freq_start = freq_start;
+  lru->used = ++cache_clock;
+  lru->table.accel = accel;
+  lru->table.freq_max = freq;
+  lru->table.size = size;
+  lru->table.ticks = lru->ticks;
+
+  return &lru->table;
+}
+
+/*
+ * move the axis with the acceleration of the ramp table
+ *
+ * the move accelerates from zero to the freq, the short move decelerates
+ * from the middle. The ramp isn't computed, the table is only indexed
+ */
+enum GEN_ERR_t RAMP_move(uint8_t axis, int8_t dir, uint32_t steps, uint8_t table, uint32_t freq)
+{
+  enum GEN_ERR_t err;
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( table >= RAMP_TABLE_CNT || !steps ) return GEN_ERR_STEPS;
+  if ( !freq || freq > RAMP_tables[table].freq_max ) return GEN_ERR_FREQ;
+  if ( (err = RAMP_limits_check(axis, RAMP_tables[table].accel, 0, freq)) != GEN_OK ) return err;
+
+  return RAMP_run(axis, dir, steps, &RAMP_tables[table], freq);
+}
+
+/*
+ * move the axis with the acceleration, from the start frequency to the freq
+ *
+ * the flash tables are used when they fit, the other ramps are computed
+ * once and kept in the cache while they are used
+ */
+enum GEN_ERR_t RAMP_move_accel(uint8_t axis, int8_t dir, uint32_t steps,
+                               uint32_t accel, uint32_t freq_start, uint32_t freq)
+{
+  const struct RAMP_TABLE_t* tab;
+  enum GEN_ERR_t err;
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( !steps ) return GEN_ERR_STEPS;
+  if ( !accel || !freq || freq_start >= freq ) return GEN_ERR_FREQ;
+  if ( (err = RAMP_limits_check(axis, accel, freq_start, freq)) != GEN_OK ) return err;
+  // the rejected move doesn't evict a cached ramp
+  if ( GEN_busy(axis) ) return GEN_ERR_BUSY;
+
+  if ( !freq_start )
+  {
+    for ( uint8_t i = 0; i < RAMP_TABLE_CNT; ++i )
+    {
+      if ( RAMP_tables[i].accel == accel && freq <= RAMP_tables[i].freq_max )
+      {
+        return RAMP_run(axis, dir, steps, &RAMP_tables[i], freq);
+      }
+    }
+  }
+
+  // the ramp is too long for the cache
+  if ( RAMP_size(accel, freq_start, freq) > RAMP_CACHE_SIZE ) return GEN_ERR_FREQ;
+
+  tab = RAMP_cache_get(accel, freq_start, freq);
+  // all entries are the ramps of the running moves
+  if ( !tab ) return GEN_ERR_BUSY;
+
+  return RAMP_run(axis, dir, steps, tab, freq);
+}
+
+/*
+ * computed ramps cache hits and misses
+ */
+const struct RAMP_CACHE_STAT_t* RAMP_cache_stat(void)
+{
+  return &cache_stat;
+}
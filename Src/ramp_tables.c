@@ -0,0 +1,240 @@
+/**
+  ******************************************************************************
+  * File Name          : ramp_tables.c
+  * Description        : ramp tables, generated by Tools/ramp_gen.py, don't edit
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "ramp.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+#if RAMP_TIM_FREQ != 72000000
+#error "the ramp tables are generated for the other timer clock"
+#endif
+
+// 20000 steps/s^2, 4000 Hz
+static const uint32_t ramp0[400] =
+{
+  720000, 298234, 228843, 192923, 169969, 153664, 141308, 131527,
+  123532, 116840, 111130, 106183, 101844, 97996, 94555, 91452,
+  88636, 86065, 83706, 81531, 79517, 77644, 75900, 74266,
+  72735, 71294, 69936, 68652, 67437, 66283, 65188, 64145,
+  63150, 62200, 61292, 60423, 59589, 58789, 58021, 57281,
+  56569, 55884, 55223, 54584, 53967, 53371, 52793, 52235,
+  51694, 51169, 50659, 50166, 49685, 49219, 48765, 48324,
+  47894, 47476, 47068, 46671, 46284, 45906, 45537, 45177,
+  44826, 44482, 44146, 43818, 43497, 43183, 42876, 42575,
+  42280, 41991, 41709, 41431, 41160, 40894, 40632, 40376,
+  40124, 39877, 39635, 39397, 39163, 38933, 38708, 38486,
+  38267, 38054, 37842, 37635, 37432, 37230, 37033, 36838,
+  36648, 36458, 36274, 36090, 35910, 35734, 35558, 35386,
+  35217, 35049, 34884, 34721, 34562, 34403, 34247, 34093,
+  33941, 33791, 33644, 33497, 33354, 33211, 33071, 32932,
+  32795, 32660, 32526, 32395, 32264, 32135, 32008, 31882,
+  31758, 31635, 31514, 31393, 31275, 31158, 31041, 30927,
+  30813, 30701, 30590, 30480, 30371, 30264, 30158, 30052,
+  29948, 29845, 29743, 29642, 29542, 29443, 29345, 29248,
+  29152, 29057, 28963, 28869, 28777, 28686, 28595, 28505,
+  28416, 28328, 28241, 28154, 28068, 27984, 27900, 27816,
+  27733, 27651, 27571, 27489, 27410, 27331, 27253, 27174,
+  27098, 27021, 26945, 26871, 26795, 26722, 26648, 26576,
+  26504, 26432, 26361, 26291, 26221, 26151, 26083, 26015,
+  25947, 25880, 25813, 25747, 25682, 25616, 25552, 25488,
+  25424, 25361, 25298, 25236, 25174, 25113, 25052, 24992,
+  24931, 24872, 24813, 24754, 24696, 24638, 24580, 24524,
+  24466, 24411, 24354, 24299, 24243, 24189, 24135, 24080,
+  24027, 23973, 23921, 23868, 23815, 23764, 23712, 23660,
+  23610, 23559, 23509, 23459, 23409, 23360, 23311, 23262,
+  23214, 23165, 23118, 23071, 23023, 22976, 22929, 22883,
+  22837, 22792, 22745, 22701, 22655, 22611, 22566, 22522,
+  22478, 22434, 22391, 22348, 22305, 22262, 22220, 22177,
+  22136, 22094, 22052, 22011, 21970, 21929, 21889, 21848,
+  21808, 21769, 21728, 21689, 21650, 21611, 21572, 21533,
+  21495, 21457, 21419, 21381, 21343, 21306, 21269, 21231,
+  21195, 21158, 21122, 21085, 21050, 21013, 20978, 20942,
+  20907, 20872, 20837, 20802, 20767, 20733, 20699, 20664,
+  20630, 20597, 20563, 20530, 20496, 20463, 20430, 20398,
+  20364, 20333, 20299, 20268, 20236, 20203, 20172, 20141,
+  20108, 20078, 20047, 20015, 19985, 19953, 19924, 19893,
+  19862, 19833, 19802, 19772, 19743, 19713, 19684, 19654,
+  19625, 19596, 19567, 19538, 19509, 19481, 19453, 19424,
+  19395, 19368, 19340, 19312, 19284, 19257, 19229, 19201,
+  19175, 19147, 19120, 19094, 19066, 19040, 19014, 18986,
+  18961, 18934, 18908, 18883, 18856, 18830, 18805, 18779,
+  18753, 18729, 18702, 18678, 18653, 18627, 18603, 18578,
+  18553, 18529, 18504, 18480, 18455, 18432, 18407, 18383,
+  18359, 18336, 18311, 18288, 18265, 18241, 18217, 18195,
+  18171, 18148, 18125, 18102, 18079, 18057, 18034, 18011,
+};
+
+// 50000 steps/s^2, 8000 Hz
+static const uint32_t ramp1[640] =
+{
+  455368, 188620, 144732, 122016, 107498, 97185, 89371, 83185,
+  78129, 73896, 70285, 67156, 64412, 61978, 59802, 57839,
+  56058, 54433, 52940, 51565, 50290, 49107, 48003, 46970,
+  46002, 45090, 44231, 43420, 42651, 41921, 41229, 40568,
+  39940, 39339, 38764, 38215, 37687, 37182, 36695, 36228,
+  35778, 35344, 34926, 34521, 34132, 33755, 33390, 33036,
+  32694, 32362, 32040, 31727, 31424, 31129, 30841, 30563,
+  30291, 30026, 29769, 29517, 29273, 29033, 28800, 28573,
+  28350, 28133, 27921, 27713, 27510, 27311, 27117, 26926,
+  26741, 26558, 26378, 26204, 26032, 25863, 25698, 25536,
+  25377, 25220, 25068, 24917, 24768, 24624, 24481, 24340,
+  24203, 24067, 23934, 23802, 23674, 23546, 23422, 23299,
+  23178, 23058, 22941, 22826, 22712, 22599, 22489, 22380,
+  22273, 22167, 22063, 21960, 21858, 21759, 21659, 21563,
+  21466, 21372, 21278, 21185, 21095, 21004, 20916, 20828,
+  20742, 20656, 20571, 20488, 20406, 20324, 20244, 20164,
+  20085, 20008, 19931, 19855, 19780, 19706, 19632, 19560,
+  19488, 19417, 19346, 19278, 19208, 19141, 19073, 19007,
+  18941, 18875, 18811, 18748, 18684, 18621, 18559, 18499,
+  18437, 18377, 18318, 18258, 18200, 18143, 18085, 18028,
+  17972, 17916, 17861, 17807, 17752, 17698, 17645, 17593,
+  17540, 17488, 17437, 17386, 17336, 17285, 17236, 17187,
+  17138, 17090, 17041, 16995, 16947, 16900, 16854, 16808,
+  16762, 16717, 16673, 16627, 16584, 16539, 16497, 16453,
+  16410, 16368, 16326, 16284, 16242, 16201, 16161, 16120,
+  16079, 16040, 16000, 15961, 15921, 15883, 15844, 15806,
+  15769, 15730, 15693, 15656, 15619, 15582, 15546, 15510,
+  15474, 15439, 15403, 15368, 15333, 15298, 15264, 15230,
+  15196, 15162, 15128, 15096, 15062, 15029, 14997, 14964,
+  14933, 14900, 14868, 14837, 14805, 14774, 14743, 14712,
+  14682, 14651, 14621, 14591, 14561, 14532, 14502, 14472,
+  14444, 14414, 14386, 14357, 14328, 14300, 14273, 14244,
+  14216, 14189, 14161, 14134, 14107, 14080, 14053, 14026,
+  14000, 13973, 13947, 13921, 13895, 13869, 13844, 13818,
+  13793, 13767, 13743, 13717, 13693, 13668, 13643, 13619,
+  13594, 13571, 13546, 13523, 13498, 13475, 13452, 13428,
+  13405, 13381, 13359, 13336, 13312, 13290, 13268, 13245,
+  13223, 13200, 13179, 13156, 13134, 13113, 13091, 13069,
+  13048, 13026, 13006, 12984, 12963, 12942, 12921, 12900,
+  12880, 12859, 12839, 12818, 12798, 12778, 12758, 12738,
+  12718, 12698, 12679, 12659, 12639, 12620, 12601, 12581,
+  12562, 12543, 12524, 12506, 12486, 12468, 12449, 12430,
+  12412, 12394, 12375, 12357, 12339, 12320, 12303, 12285,
+  12267, 12249, 12232, 12214, 12196, 12179, 12161, 12145,
+  12127, 12109, 12093, 12076, 12059, 12042, 12025, 12008,
+  11992, 11975, 11958, 11942, 11926, 11909, 11894, 11877,
+  11860, 11845, 11829, 11813, 11797, 11781, 11765, 11750,
+  11734, 11718, 11704, 11687, 11672, 11657, 11642, 11627,
+  11611, 11596, 11582, 11566, 11551, 11537, 11522, 11507,
+  11493, 11477, 11464, 11448, 11435, 11420, 11405, 11392,
+  11377, 11363, 11348, 11335, 11321, 11307, 11292, 11279,
+  11266, 11251, 11238, 11224, 11210, 11197, 11183, 11170,
+  11156, 11143, 11130, 11117, 11103, 11090, 11077, 11064,
+  11050, 11038, 11025, 11012, 10999, 10986, 10974, 10961,
+  10948, 10935, 10923, 10911, 10897, 10886, 10873, 10860,
+  10849, 10836, 10823, 10812, 10799, 10787, 10775, 10764,
+  10751, 10739, 10727, 10715, 10704, 10691, 10680, 10668,
+  10657, 10644, 10634, 10621, 10610, 10599, 10587, 10576,
+  10564, 10553, 10541, 10531, 10519, 10508, 10496, 10486,
+  10474, 10464, 10452, 10441, 10431, 10419, 10409, 10398,
+  10387, 10376, 10365, 10355, 10344, 10333, 10322, 10313,
+  10301, 10291, 10280, 10270, 10260, 10249, 10239, 10229,
+  10218, 10208, 10197, 10188, 10177, 10167, 10157, 10147,
+  10137, 10126, 10117, 10107, 10097, 10087, 10077, 10067,
+  10058, 10047, 10038, 10028, 10019, 10008, 9999, 9990,
+  9979, 9971, 9960, 9952, 9941, 9932, 9923, 9914,
+  9904, 9894, 9886, 9876, 9866, 9858, 9848, 9839,
+  9830, 9821, 9811, 9803, 9793, 9784, 9776, 9766,
+  9758, 9748, 9740, 9730, 9722, 9713, 9704, 9695,
+  9687, 9677, 9669, 9661, 9651, 9643, 9635, 9625,
+  9617, 9609, 9600, 9591, 9583, 9575, 9566, 9558,
+  9549, 9541, 9532, 9524, 9516, 9507, 9500, 9491,
+  9482, 9475, 9466, 9458, 9450, 9442, 9434, 9426,
+  9417, 9410, 9401, 9394, 9385, 9378, 9370, 9361,
+  9354, 9346, 9338, 9330, 9323, 9314, 9307, 9299,
+  9291, 9284, 9276, 9268, 9260, 9253, 9245, 9238,
+  9230, 9223, 9214, 9208, 9200, 9192, 9185, 9177,
+  9170, 9163, 9155, 9147, 9141, 9133, 9125, 9119,
+  9111, 9103, 9097, 9089, 9082, 9075, 9067, 9061,
+  9053, 9046, 9039, 9032, 9024, 9018, 9010, 9004,
+};
+
+// 100000 steps/s^2, 10000 Hz
+static const uint32_t ramp2[500] =
+{
+  321994, 133374, 102342, 86278, 76012, 68720, 63195, 58821,
+  55245, 52253, 49699, 47486, 45546, 43825, 42287, 40898,
+  39639, 38490, 37434, 36462, 35561, 34724, 33943, 33213,
+  32528, 31884, 31276, 30702, 30159, 29643, 29153, 28686,
+  28241, 27817, 27411, 27022, 26649, 26291, 25948, 25617,
+  25298, 24992, 24696, 24411, 24135, 23868, 23610, 23360,
+  23119, 22883, 22656, 22434, 22220, 22011, 21809, 21611,
+  21419, 21232, 21049, 20872, 20699, 20530, 20364, 20204,
+  20047, 19893, 19743, 19596, 19452, 19312, 19175, 19040,
+  18908, 18779, 18653, 18529, 18407, 18288, 18171, 18057,
+  17944, 17834, 17725, 17619, 17514, 17412, 17310, 17211,
+  17114, 17018, 16924, 16831, 16740, 16650, 16561, 16475,
+  16389, 16305, 16222, 16140, 16060, 15980, 15902, 15825,
+  15750, 15674, 15601, 15528, 15456, 15385, 15316, 15247,
+  15179, 15112, 15046, 14980, 14916, 14853, 14790, 14727,
+  14667, 14606, 14546, 14487, 14429, 14371, 14315, 14258,
+  14202, 14148, 14093, 14040, 13987, 13934, 13882, 13831,
+  13780, 13730, 13680, 13631, 13582, 13535, 13487, 13439,
+  13394, 13347, 13301, 13257, 13211, 13167, 13124, 13080,
+  13037, 12995, 12952, 12911, 12870, 12828, 12788, 12748,
+  12708, 12669, 12629, 12591, 12553, 12515, 12477, 12440,
+  12402, 12366, 12330, 12294, 12258, 12223, 12187, 12153,
+  12119, 12084, 12050, 12017, 11983, 11951, 11917, 11885,
+  11853, 11821, 11789, 11757, 11727, 11695, 11665, 11634,
+  11604, 11574, 11544, 11514, 11485, 11456, 11427, 11399,
+  11370, 11342, 11313, 11286, 11258, 11231, 11204, 11176,
+  11150, 11123, 11097, 11070, 11045, 11018, 10993, 10967,
+  10942, 10916, 10892, 10867, 10842, 10817, 10794, 10769,
+  10745, 10721, 10698, 10674, 10650, 10628, 10604, 10581,
+  10559, 10536, 10513, 10491, 10469, 10447, 10425, 10403,
+  10382, 10360, 10338, 10318, 10296, 10275, 10255, 10233,
+  10213, 10193, 10172, 10152, 10132, 10112, 10091, 10073,
+  10052, 10033, 10014, 9994, 9975, 9956, 9937, 9918,
+  9899, 9881, 9862, 9844, 9825, 9807, 9789, 9771,
+  9753, 9735, 9717, 9700, 9682, 9664, 9648, 9630,
+  9612, 9596, 9579, 9562, 9545, 9528, 9512, 9495,
+  9478, 9463, 9446, 9429, 9414, 9397, 9382, 9366,
+  9349, 9335, 9318, 9303, 9287, 9272, 9257, 9242,
+  9226, 9211, 9196, 9181, 9166, 9152, 9136, 9122,
+  9108, 9092, 9079, 9064, 9049, 9036, 9021, 9007,
+  8993, 8979, 8965, 8951, 8938, 8923, 8910, 8897,
+  8882, 8870, 8856, 8842, 8829, 8816, 8803, 8790,
+  8776, 8764, 8750, 8738, 8725, 8712, 8699, 8687,
+  8674, 8662, 8649, 8636, 8624, 8612, 8600, 8587,
+  8575, 8563, 8551, 8539, 8526, 8515, 8503, 8492,
+  8479, 8468, 8456, 8444, 8433, 8421, 8410, 8398,
+  8387, 8375, 8364, 8353, 8342, 8331, 8319, 8308,
+  8297, 8287, 8275, 8264, 8254, 8243, 8232, 8221,
+  8210, 8200, 8189, 8179, 8168, 8158, 8147, 8137,
+  8126, 8116, 8106, 8095, 8086, 8075, 8065, 8055,
+  8045, 8034, 8025, 8015, 8005, 7995, 7985, 7976,
+  7965, 7956, 7947, 7936, 7927, 7917, 7908, 7898,
+  7889, 7880, 7869, 7861, 7851, 7842, 7833, 7823,
+  7814, 7805, 7796, 7786, 7778, 7768, 7760, 7750,
+  7742, 7732, 7724, 7715, 7706, 7697, 7688, 7680,
+  7671, 7662, 7653, 7645, 7636, 7628, 7619, 7611,
+  7602, 7594, 7585, 7577, 7568, 7560, 7552, 7544,
+  7535, 7527, 7519, 7510, 7503, 7494, 7486, 7478,
+  7471, 7462, 7454, 7446, 7438, 7430, 7422, 7415,
+  7406, 7399, 7391, 7383, 7375, 7368, 7360, 7352,
+  7345, 7337, 7330, 7321, 7315, 7306, 7300, 7291,
+  7285, 7276, 7270, 7262, 7254, 7248, 7240, 7232,
+  7226, 7218, 7210, 7204,
+};
+
+const struct RAMP_TABLE_t RAMP_tables[RAMP_TABLE_CNT] =
+{
+  {20000, 4000, 400, ramp0},
+  {50000, 8000, 640, ramp1},
+  {100000, 10000, 500, ramp2},
+};
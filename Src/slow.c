@@ -0,0 +1,118 @@
+/**
+  ******************************************************************************
+  * File Name          : slow.c
+  * Description        : low speed exact rate moves functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "slow.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+// axes low speed moves data array
+static struct SLOW_t slows[GEN_AXIS_CNT] = {0};
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * low speed move steps source
+ *
+ * the step k is at floor(k * tim_freq * den / num) ticks, the fraction is
+ * carried from step to step. The period longer than SLOW_WAIT_MAX is
+ * the time without a step and the rest of it
+ */
+static uint32_t SLOW_source(void* ctx, int8_t* dir)
+{
+  struct SLOW_t*  s = ctx;
+  uint32_t        t;
+
+  if ( !s->left )
+  {
+    if ( s->step >= s->steps ) return 0;
+
+    s->left = s->ticks;
+    s->acc += s->frac;
+    if ( s->acc >= s->num )
+    {
+      s->acc -= s->num;
+      ++s->left;
+    }
+  }
+
+  if ( s->left > SLOW_WAIT_MAX )
+  {
+    s->left -= SLOW_WAIT_MAX;
+    *dir = 0;
+    return SLOW_WAIT_MAX;
+  }
+
+  t = (uint32_t)s->left;
+  s->left = 0;
+  ++s->step;
+  *dir = s->dir;
+
+  // 0 is the profile end
+  return t ? t : 1;
+}
+
+/*
+ * start the low speed move of the axis
+ *
+ * the rate is num/den steps/s, so the rate below 1 Hz is exact,
+ * e.g. 1/3600 is a step per hour
+ */
+enum GEN_ERR_t SLOW_move(uint8_t axis, int8_t dir, uint32_t steps, uint32_t num, uint32_t den)
+{
+  struct SLOW_t*  s;
+  uint64_t        period;
+  enum GEN_ERR_t  err;
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( !steps ) return GEN_ERR_STEPS;
+  if ( !num || !den || num / den >= GEN_FREQ_MAX ) return GEN_ERR_FREQ;
+  // the running move data must stay intact
+  if ( GEN_busy(axis) ) return GEN_ERR_BUSY;
+
+  err = GEN_limits_check(axis, GEN_position_get(axis) + (dir < 0 ? -(int32_t)steps : (int32_t)steps));
+  if ( err != GEN_OK ) return err;
+
+  s = &slows[axis];
+
+  // tim_freq * den fits 64 bits, the period has no rounding
+  period = (uint64_t)GEN_tim_freq_get(axis) * den;
+  s->dir = dir < 0 ? -1 : 1;
+  s->steps = steps;
+  s->step = 0;
+  s->num = num;
+  s->ticks = period / num;
+  s->frac = period % num;
+  s->acc = 0;
+  s->left = 0;
+
+  // the overrides would break the exact rate
+  GEN_profile_exact_set(axis);
+  err = GEN_profile_set(axis, SLOW_source, s);
+  if ( err != GEN_OK )
+  {
+    s->steps = 0;
+    return err;
+  }
+
+  GEN_profile_start(1 << axis);
+
+  return GEN_OK;
+}
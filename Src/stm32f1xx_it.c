@@ -37,13 +37,16 @@
 
 /* USER CODE BEGIN 0 */
 #include "generator.h"
+#include "homing.h"
+#include "link.h"
+#include "follow.h"
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
 extern SPI_HandleTypeDef hspi1;
 extern SPI_HandleTypeDef hspi2;
-extern DMA_HandleTypeDef hdma_tim1_ch1;
-extern DMA_HandleTypeDef hdma_tim2_ch1;
+extern DMA_HandleTypeDef hdma_tim1_ch4_trig_com;
+extern DMA_HandleTypeDef hdma_tim2_ch2_ch4;
 extern DMA_HandleTypeDef hdma_tim3_ch1_trig;
 extern DMA_HandleTypeDef hdma_tim4_ch1;
 
@@ -64,6 +67,8 @@ void SysTick_Handler(void)
 
   // use own handler for the systick update event
   GEN_SYSTICK_IRQHandler();
+  // step/dir inputs sampling of the re-generators
+  FOL_SYSTICK_IRQHandler();
 
 #if 0
   /* USER CODE END SysTick_IRQn 0 */
@@ -87,11 +92,21 @@ void SysTick_Handler(void)
 void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
-  /* Clear the transfer complete flag */
-  __HAL_DMA_CLEAR_FLAG(&hdma_tim4_ch1, DMA_FLAG_TC1);
-
-  // use own handler for the DMA channel transfer complete event
-  GEN_DMA_transfer_complete(3);
+  // the profile output ring half is read
+  if ( __HAL_DMA_GET_FLAG(&hdma_tim4_ch1, DMA_FLAG_HT1) )
+  {
+    __HAL_DMA_CLEAR_FLAG(&hdma_tim4_ch1, DMA_FLAG_HT1);
+    GEN_DMA_half_transfer(3);
+  }
+
+  if ( __HAL_DMA_GET_FLAG(&hdma_tim4_ch1, DMA_FLAG_TC1) )
+  {
+    /* Clear the transfer complete flag */
+    __HAL_DMA_CLEAR_FLAG(&hdma_tim4_ch1, DMA_FLAG_TC1);
+
+    // use own handler for the DMA channel transfer complete event
+    GEN_DMA_transfer_complete(3);
+  }
 
 #if 0
   /* USER CODE END DMA1_Channel1_IRQn 0 */
@@ -105,72 +120,102 @@ void DMA1_Channel1_IRQHandler(void)
 }
 
 /**
-* @brief This function handles DMA1 channel2 global interrupt.
+* @brief This function handles DMA1 channel4 global interrupt.
 */
-void DMA1_Channel2_IRQHandler(void)
+void DMA1_Channel4_IRQHandler(void)
 {
-  /* USER CODE BEGIN DMA1_Channel2_IRQn 0 */
-  /* Clear the transfer complete flag */
-  __HAL_DMA_CLEAR_FLAG(&hdma_tim1_ch1, DMA_FLAG_TC2);
-
-  // use own handler for the DMA channel transfer complete event
-  GEN_DMA_transfer_complete(0);
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 0 */
+  // the profile output ring half is read
+  if ( __HAL_DMA_GET_FLAG(&hdma_tim1_ch4_trig_com, DMA_FLAG_HT4) )
+  {
+    __HAL_DMA_CLEAR_FLAG(&hdma_tim1_ch4_trig_com, DMA_FLAG_HT4);
+    GEN_DMA_half_transfer(0);
+  }
+
+  if ( __HAL_DMA_GET_FLAG(&hdma_tim1_ch4_trig_com, DMA_FLAG_TC4) )
+  {
+    /* Clear the transfer complete flag */
+    __HAL_DMA_CLEAR_FLAG(&hdma_tim1_ch4_trig_com, DMA_FLAG_TC4);
+
+    // use own handler for the DMA channel transfer complete event
+    GEN_DMA_transfer_complete(0);
+  }
 
 #if 0
-  /* USER CODE END DMA1_Channel2_IRQn 0 */
-  HAL_DMA_IRQHandler(&hdma_tim1_ch1);
-  /* USER CODE BEGIN DMA1_Channel2_IRQn 1 */
+  /* USER CODE END DMA1_Channel4_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_tim1_ch4_trig_com);
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 1 */
 #endif
 
   // to prevent compiler's warnings about unused var
-  UNUSED(hdma_tim1_ch1);
-  /* USER CODE END DMA1_Channel2_IRQn 1 */
+  UNUSED(hdma_tim1_ch4_trig_com);
+  /* USER CODE END DMA1_Channel4_IRQn 1 */
 }
 
 /**
-* @brief This function handles DMA1 channel5 global interrupt.
+* @brief This function handles DMA1 channel6 global interrupt.
 */
-void DMA1_Channel5_IRQHandler(void)
+void DMA1_Channel6_IRQHandler(void)
 {
-  /* USER CODE BEGIN DMA1_Channel5_IRQn 0 */
-  /* Clear the transfer complete flag */
-  __HAL_DMA_CLEAR_FLAG(&hdma_tim2_ch1, DMA_FLAG_TC5);
-
-  // use own handler for the DMA channel transfer complete event
-  GEN_DMA_transfer_complete(1);
+  /* USER CODE BEGIN DMA1_Channel6_IRQn 0 */
+  // the profile output ring half is read
+  if ( __HAL_DMA_GET_FLAG(&hdma_tim3_ch1_trig, DMA_FLAG_HT6) )
+  {
+    __HAL_DMA_CLEAR_FLAG(&hdma_tim3_ch1_trig, DMA_FLAG_HT6);
+    GEN_DMA_half_transfer(2);
+  }
+
+  if ( __HAL_DMA_GET_FLAG(&hdma_tim3_ch1_trig, DMA_FLAG_TC6) )
+  {
+    /* Clear the transfer complete flag */
+    __HAL_DMA_CLEAR_FLAG(&hdma_tim3_ch1_trig, DMA_FLAG_TC6);
+
+    // use own handler for the DMA channel transfer complete event
+    GEN_DMA_transfer_complete(2);
+  }
 
 #if 0
-  /* USER CODE END DMA1_Channel5_IRQn 0 */
-  HAL_DMA_IRQHandler(&hdma_tim2_ch1);
-  /* USER CODE BEGIN DMA1_Channel5_IRQn 1 */
+  /* USER CODE END DMA1_Channel6_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_tim3_ch1_trig);
+  /* USER CODE BEGIN DMA1_Channel6_IRQn 1 */
 #endif
 
   // to prevent compiler's warnings about unused var
-  UNUSED(hdma_tim2_ch1);
-  /* USER CODE END DMA1_Channel5_IRQn 1 */
+  UNUSED(hdma_tim3_ch1_trig);
+  /* USER CODE END DMA1_Channel6_IRQn 1 */
 }
 
 /**
-* @brief This function handles DMA1 channel6 global interrupt.
+* @brief This function handles DMA1 channel7 global interrupt.
 */
-void DMA1_Channel6_IRQHandler(void)
+void DMA1_Channel7_IRQHandler(void)
 {
-  /* USER CODE BEGIN DMA1_Channel6_IRQn 0 */
-  /* Clear the transfer complete flag */
-  __HAL_DMA_CLEAR_FLAG(&hdma_tim3_ch1_trig, DMA_FLAG_TC6);
-
-  // use own handler for the DMA channel transfer complete event
-  GEN_DMA_transfer_complete(2);
+  /* USER CODE BEGIN DMA1_Channel7_IRQn 0 */
+  // the profile output ring half is read
+  if ( __HAL_DMA_GET_FLAG(&hdma_tim2_ch2_ch4, DMA_FLAG_HT7) )
+  {
+    __HAL_DMA_CLEAR_FLAG(&hdma_tim2_ch2_ch4, DMA_FLAG_HT7);
+    GEN_DMA_half_transfer(1);
+  }
+
+  if ( __HAL_DMA_GET_FLAG(&hdma_tim2_ch2_ch4, DMA_FLAG_TC7) )
+  {
+    /* Clear the transfer complete flag */
+    __HAL_DMA_CLEAR_FLAG(&hdma_tim2_ch2_ch4, DMA_FLAG_TC7);
+
+    // use own handler for the DMA channel transfer complete event
+    GEN_DMA_transfer_complete(1);
+  }
 
 #if 0
-  /* USER CODE END DMA1_Channel6_IRQn 0 */
-  HAL_DMA_IRQHandler(&hdma_tim3_ch1_trig);
-  /* USER CODE BEGIN DMA1_Channel6_IRQn 1 */
+  /* USER CODE END DMA1_Channel7_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_tim2_ch2_ch4);
+  /* USER CODE BEGIN DMA1_Channel7_IRQn 1 */
 #endif
 
   // to prevent compiler's warnings about unused var
-  UNUSED(hdma_tim3_ch1_trig);
-  /* USER CODE END DMA1_Channel6_IRQn 1 */
+  UNUSED(hdma_tim2_ch2_ch4);
+  /* USER CODE END DMA1_Channel7_IRQn 1 */
 }
 
 /**
@@ -202,6 +247,52 @@ void SPI2_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+* @brief This function handles DMA1 channel3 global interrupt.
+*/
+void DMA1_Channel3_IRQHandler(void)
+{
+  // the host link status frame is sent
+  LINK_DMA_IRQHandler();
+}
+
+/**
+* @brief This function handles EXTI line2 interrupt.
+*/
+void EXTI2_IRQHandler(void)
+{
+  __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_2);
+  // axis 1 home switch
+  HOME_EXTI_IRQHandler(0);
+}
 
+/**
+* @brief This function handles EXTI line3 interrupt.
+*/
+void EXTI3_IRQHandler(void)
+{
+  __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_3);
+  // axis 2 home switch
+  HOME_EXTI_IRQHandler(1);
+}
+
+/**
+* @brief This function handles EXTI line[9:5] interrupts.
+*/
+void EXTI9_5_IRQHandler(void)
+{
+  // axis 3 home switch
+  if ( __HAL_GPIO_EXTI_GET_IT(GPIO_PIN_8) )
+  {
+    __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_8);
+    HOME_EXTI_IRQHandler(2);
+  }
+  // axis 4 home switch
+  if ( __HAL_GPIO_EXTI_GET_IT(GPIO_PIN_9) )
+  {
+    __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_9);
+    HOME_EXTI_IRQHandler(3);
+  }
+}
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,297 @@
+/**
+  ******************************************************************************
+  * File Name          : stream.c
+  * Description        : compressed steps intervals stream functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "stream.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+#define STR_MASK (STR_FIFO_SIZE - 1)
+
+// axes stream decoders data array
+static struct STR_t streams[GEN_AXIS_CNT] = {0};
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * stream byte at the offset from the FIFO head
+ */
+static uint8_t STR_peek(const struct STR_t* str, uint16_t offset)
+{
+  return str->fifo[(str->head + offset) & STR_MASK];
+}
+
+/*
+ * 32 bit little endian operand of the code at the FIFO head
+ */
+static uint32_t STR_peek32(const struct STR_t* str)
+{
+  return STR_peek(str, 1) | (STR_peek(str, 2) << 8) |
+         (STR_peek(str, 3) << 16) | ((uint32_t)STR_peek(str, 4) << 24);
+}
+
+/*
+ * code length, bytes
+ */
+static uint8_t STR_op_len(uint8_t op)
+{
+  return (op & 0xC0) == STR_OP_DD_LONG ? 2 : op == STR_OP_SET || op == STR_OP_WAIT ? 5 : 1;
+}
+
+/*
+ * tell the generator if the stream data is running low
+ *
+ * the stream end in the FIFO isn't the starvation
+ */
+static void STR_low_update(struct STR_t* str)
+{
+  GEN_profile_low_set(str - streams, !str->ends && ((str->tail - str->head) & STR_MASK) < STR_LOW_WATER);
+}
+
+/*
+ * stream decoder, the axis steps source
+ *
+ * the intervals are decoded straight to the profile ring data. The ones
+ * shorter than the axis max frequency are delayed by the profile, the steps
+ * out of the soft limits end the stream, the decoded position is ahead of
+ * the output, so the axis stops at the limit
+ */
+static uint32_t STR_source(void* ctx, int8_t* dir)
+{
+  struct STR_t* str = ctx;
+  uint32_t      start = DWT->CYCCNT;
+  uint32_t      v;
+  uint16_t      avail, len;
+  uint8_t       op;
+
+  for ( ;; )
+  {
+    if ( str->run )
+    {
+      --str->run;
+      str->interval += str->delta;
+      break;
+    }
+
+    avail = (str->tail - str->head) & STR_MASK;
+    if ( !avail )
+    {
+      STR_low_update(str);
+      return GEN_PRF_WAIT;
+    }
+
+    op = STR_peek(str, 0);
+    len = STR_op_len(op);
+    if ( avail < len )
+    {
+      STR_low_update(str);
+      return GEN_PRF_WAIT;
+    }
+
+    if ( (op & 0xC0) == STR_OP_DD )
+    {
+      // sign extension of the 6 bit value
+      str->delta += (int8_t)(op << 2) >> 2;
+      str->interval += str->delta;
+    }
+    else if ( (op & 0xC0) == STR_OP_RUN )
+    {
+      str->run = op & 0x3F;
+      str->interval += str->delta;
+    }
+    else if ( (op & 0xC0) == STR_OP_DD_LONG )
+    {
+      // sign extension of the 14 bit value
+      str->delta += (int16_t)(((op & 0x3F) << 10) | (STR_peek(str, 1) << 2)) >> 2;
+      str->interval += str->delta;
+    }
+    else if ( op == STR_OP_DIR_FWD || op == STR_OP_DIR_BACK )
+    {
+      str->dir = op == STR_OP_DIR_BACK ? -1 : 1;
+      str->head = (str->head + len) & STR_MASK;
+      continue;
+    }
+    else if ( op == STR_OP_SET )
+    {
+      // the interval is 31 bit, the longer one is saturated like the host encoder does
+      v = STR_peek32(str);
+      str->interval = v > 0x7FFFFFFF ? 0x7FFFFFFF : (int32_t)v;
+      str->delta = 0;
+    }
+    else if ( op == STR_OP_WAIT )
+    {
+      // the axis idle time keeps the synchronized axes streams at the same time,
+      // GEN_PRF_WAIT is the source without data, the longest wait is a tick shorter
+      v = STR_peek32(str);
+      str->head = (str->head + len) & STR_MASK;
+      STR_low_update(str);
+
+      *dir = 0;
+      return !v ? 1 : v == GEN_PRF_WAIT ? GEN_PRF_WAIT - 1 : v;
+    }
+    else
+    {
+      // the stream end or an unknown code
+      str->error = op != STR_OP_END ? STR_ERR_CODE : STR_OK;
+      str->head = (str->head + len) & STR_MASK;
+      if ( str->ends ) --str->ends;
+      return 0;
+    }
+
+    str->head = (str->head + len) & STR_MASK;
+    break;
+  }
+
+  if ( GEN_limits_check(str - streams, str->pos + str->dir) != GEN_OK )
+  {
+    // the rest of the stream isn't played by the next start
+    str->error = STR_ERR_LIMIT;
+    str->head = str->tail;
+    str->scan = str->tail;
+    str->run = 0;
+    str->ends = 0;
+    return 0;
+  }
+  str->pos += str->dir;
+
+  str->cycles += DWT->CYCCNT - start;
+  ++str->steps;
+
+  STR_low_update(str);
+
+  *dir = str->dir;
+  // 0 is the profile end
+  return str->interval > 0 ? (uint32_t)str->interval : 1;
+}
+
+/*
+ * stream decoders init
+ *
+ * uses in the main() before infinite loop start
+ */
+void STR_init(void)
+{
+  // the CPU clocks counter measures the decode rate
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*
+ * free space in the axis stream FIFO, bytes
+ */
+uint16_t STR_free(uint8_t axis)
+{
+  return (streams[axis].head - streams[axis].tail - 1) & STR_MASK;
+}
+
+/*
+ * add the encoded stream data of the axis
+ *
+ * the data is added all at once or not at all
+ */
+enum GEN_ERR_t STR_write(uint8_t axis, const uint8_t* data, uint16_t len)
+{
+  struct STR_t* str;
+  uint8_t       op, n;
+
+  if ( axis >= GEN_AXIS_CNT ) return GEN_ERR_AXIS;
+  if ( len > STR_free(axis) ) return GEN_ERR_BUSY;
+
+  str = &streams[axis];
+
+  while ( len-- )
+  {
+    str->fifo[str->tail] = *data++;
+    str->tail = (str->tail + 1) & STR_MASK;
+  }
+
+  // count the stream ends, the codes which end the decoding
+  while ( str->scan != str->tail )
+  {
+    op = str->fifo[str->scan];
+    n = STR_op_len(op);
+    if ( ((str->tail - str->scan) & STR_MASK) < n ) break;
+
+    if ( (op & 0xC0) == 0xC0 && op != STR_OP_DIR_FWD && op != STR_OP_DIR_BACK &&
+         op != STR_OP_SET && op != STR_OP_WAIT ) ++str->ends;
+    str->scan = (str->scan + n) & STR_MASK;
+  }
+
+  STR_low_update(str);
+
+  return GEN_OK;
+}
+
+/*
+ * start the streams of the axes at the same time
+ *
+ * axes_mask bit 0 is the axis 0, the stream may start before its data,
+ * the output is silent until the data comes
+ */
+enum GEN_ERR_t STR_start(uint8_t axes_mask)
+{
+  struct STR_t*   str;
+  uint8_t         ready = 0;
+  enum GEN_ERR_t  err;
+
+  for ( uint8_t axis = 0; axis < GEN_AXIS_CNT; ++axis )
+  {
+    if ( !(axes_mask & (1 << axis)) ) continue;
+
+    str = &streams[axis];
+    str->dir = 1;
+    str->pos = GEN_position_get(axis);
+    str->interval = 0;
+    str->delta = 0;
+    str->run = 0;
+    str->error = STR_OK;
+    str->steps = 0;
+    str->cycles = 0;
+
+    err = GEN_profile_set(axis, STR_source, str);
+    if ( err != GEN_OK )
+    {
+      // release the prepared axes
+      for ( axis = GEN_AXIS_CNT; axis--; )
+      {
+        if ( ready & (1 << axis) ) GEN_stop(axis);
+      }
+
+      return err;
+    }
+
+    ready |= 1 << axis;
+  }
+
+  GEN_profile_start(ready);
+
+  return GEN_OK;
+}
+
+/*
+ * measured decode rate of the axis stream, steps/s of the CPU time
+ */
+uint32_t STR_decode_rate(uint8_t axis)
+{
+  if ( axis >= GEN_AXIS_CNT || !streams[axis].cycles ) return 0;
+
+  return (uint32_t)((uint64_t)streams[axis].steps * HAL_RCC_GetHCLKFreq() / streams[axis].cycles);
+}
@@ -0,0 +1,183 @@
+/**
+  ******************************************************************************
+  * File Name          : telemetry.c
+  * Description        : axes telemetry stream functionality
+  ******************************************************************************
+  *
+  * "AS IS"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "stm32f1xx_hal.h"
+#include "generator.h"
+#include "ramp.h"
+#include "stream.h"
+#include "telemetry.h"
+
+
+
+
+/* Global vars ---------------------------------------------------------------*/
+
+// telemetry SPI master, the hardware NSS frames the data
+extern SPI_HandleTypeDef hspi2;
+
+static struct TLM_FRAME_t frame = {0};
+static struct TLM_STAT_t stat = {0};
+
+static uint16_t period = 1000 / TLM_RATE; // ms
+static uint32_t frame_time = 0; // the last frame time slot, ms
+static uint32_t last_time = 0; // the last sent state time, ms
+static int32_t  last_pos[GEN_AXIS_CNT] = {0};
+
+// the frame is in progress
+static uint8_t tx_on = 0;
+
+
+
+
+/* functions ------------------------------------------------------------------*/
+
+/*
+ * stop the sent frame transfer
+ */
+static void TLM_tx_stop(void)
+{
+  hspi2.Instance->CR2 &= ~(SPI_CR2_TXDMAEN);
+  // NSS goes high
+  hspi2.Instance->CR1 &= ~(SPI_CR1_SPE);
+
+  TLM_DMA->CCR &= ~(DMA_CCR_EN);
+  DMA1->IFCR = TLM_DMA_IFCR;
+
+  tx_on = 0;
+}
+
+/*
+ * fill the frame with the current axes state
+ */
+static void TLM_frame_fill(uint32_t now)
+{
+  struct GEN_STATUS_t             st;
+  const struct RAMP_CACHE_STAT_t* cache = RAMP_cache_stat();
+  uint32_t                        dt = now - last_time;
+  uint8_t*                        b = (uint8_t*)&frame;
+  uint8_t                         sum = 0;
+
+  frame.sync = TLM_SYNC;
+  ++frame.seq;
+  frame.len = sizeof(frame);
+  frame.time = now;
+
+  for ( uint8_t axis = 0; axis < GEN_AXIS_CNT; ++axis )
+  {
+    GEN_status_get(axis, &st);
+
+    frame.axis[axis].pos = st.pos;
+    frame.axis[axis].vel = dt ? (int32_t)((int64_t)(st.pos - last_pos[axis]) * 1000 / (int32_t)dt) : 0;
+    frame.axis[axis].depth = st.depth;
+    frame.axis[axis].underruns = st.underruns;
+    frame.axis[axis].isr_cnt = st.isr_cnt;
+    frame.axis[axis].isr_max = st.isr_max;
+    frame.axis[axis].late_stops = st.late_stops;
+    frame.axis[axis].seg = st.seg;
+    frame.axis[axis].verify_seg = st.verify_seg;
+    frame.axis[axis].verify_diff = st.verify_diff;
+    frame.axis[axis].verify_errors = st.verify_errors;
+    frame.axis[axis].decode_rate = STR_decode_rate(axis);
+
+    last_pos[axis] = st.pos;
+  }
+
+  frame.cache_hits = cache->hits;
+  frame.cache_misses = cache->misses;
+  frame.starves = st.starves;
+  frame.starve_time = st.starve_time;
+  frame.starving = st.starving;
+  frame.dma_load = st.dma_load;
+
+  for ( uint16_t i = 0; i < sizeof(frame) - 1; ++i ) sum ^= b[i];
+  frame.sum = sum;
+
+  last_time = now;
+}
+
+/*
+ * telemetry init
+ *
+ * uses in the main() before infinite loop start
+ */
+void TLM_init(void)
+{
+  frame_time = HAL_GetTick();
+  last_time = frame_time;
+}
+
+/*
+ * send the telemetry frames at the set rate
+ *
+ * the frame is skipped if the previous one is still sent, it never waits
+ *
+ * uses in the main() infinite loop
+ */
+void TLM_process(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  if ( tx_on )
+  {
+    // the frame is sent when the last byte is out
+    if ( !TLM_DMA->CNDTR && (hspi2.Instance->SR & SPI_FLAG_TXE) && !(hspi2.Instance->SR & SPI_FLAG_BSY) )
+    {
+      TLM_tx_stop();
+      ++stat.sent;
+    }
+  }
+
+  if ( !period || now - frame_time < period ) return;
+  frame_time = now;
+
+  if ( tx_on )
+  {
+    ++frame.seq;
+    ++stat.skipped;
+    return;
+  }
+
+  TLM_frame_fill(now);
+
+  TLM_DMA->CCR = DMA_CCR_DIR | DMA_CCR_MINC;
+  TLM_DMA->CNDTR = sizeof(frame);
+  TLM_DMA->CPAR = (uint32_t)&(hspi2.Instance->DR);
+  TLM_DMA->CMAR = (uint32_t)&frame;
+  TLM_DMA->CCR |= (DMA_CCR_EN);
+
+  // NSS goes low, the DMA starts at the TXE request
+  hspi2.Instance->CR1 |= (SPI_CR1_SPE);
+  hspi2.Instance->CR2 |= (SPI_CR2_TXDMAEN);
+
+  tx_on = 1;
+}
+
+/*
+ * set the telemetry frames rate, Hz (0 = off)
+ */
+void TLM_rate_set(uint16_t hz)
+{
+  if ( hz > TLM_RATE_MAX ) hz = TLM_RATE_MAX;
+  // the frame time slots are ms
+  if ( hz > 1000 ) hz = 1000;
+
+  period = hz ? 1000 / hz : 0;
+}
+
+/*
+ * telemetry stream statistics
+ */
+const struct TLM_STAT_t* TLM_stat(void)
+{
+  return &stat;
+}
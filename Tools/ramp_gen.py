@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+#
+# File Name          : ramp_gen.py
+# Description        : ramp tables generator, writes Src/ramp_tables.c
+#
+# "AS IS"
+#
+# the tables are the steps intervals of the constant acceleration ramps
+# from zero to the max frequency, in the profile timer ticks.
+# Run it after changing the settings below, the output is committed
+
+import math
+import os
+
+# settings --------------------------------------------------------------------
+
+TIM_FREQ = 72000000 # Hz, profile timer clock, RAMP_TIM_FREQ
+
+# acceleration profiles: steps/s^2, max frequency Hz
+PROFILES = [
+    (20000, 4000),
+    (50000, 8000),
+    (100000, 10000),
+]
+
+SIZE_MAX = 1024 # max table size
+
+# -----------------------------------------------------------------------------
+
+OUT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Src", "ramp_tables.c")
+
+
+def table(accel, freq_max):
+    # the step n is at t = sqrt(2*n/accel), the intervals are the rounded
+    # time differences, so the ramp time has no accumulated error
+    size = math.ceil(freq_max * freq_max / (2 * accel))
+    if size > SIZE_MAX:
+        raise SystemExit("profile %d/%d: %d steps, more than SIZE_MAX" % (accel, freq_max, size))
+
+    t = [round(TIM_FREQ * math.sqrt(2 * n / accel)) for n in range(size + 1)]
+    return [t[n + 1] - t[n] for n in range(size)]
+
+
+def main():
+    out = []
+    out.append("/**")
+    out.append("  ******************************************************************************")
+    out.append("  * File Name          : ramp_tables.c")
+    out.append("  * Description        : ramp tables, generated by Tools/ramp_gen.py, don't edit")
+    out.append("  ******************************************************************************")
+    out.append("  *")
+    out.append("  * \"AS IS\"")
+    out.append("  *")
+    out.append("  ******************************************************************************")
+    out.append("  */")
+    out.append("")
+    out.append("/* Includes ------------------------------------------------------------------*/")
+    out.append("")
+    out.append("#include \"stm32f1xx_hal.h\"")
+    out.append("#include \"generator.h\"")
+    out.append("#include \"ramp.h\"")
+    out.append("")
+    out.append("")
+    out.append("")
+    out.append("")
+    out.append("/* Global vars ---------------------------------------------------------------*/")
+    out.append("")
+    out.append("#if RAMP_TIM_FREQ != %d" % TIM_FREQ)
+    out.append("#error \"the ramp tables are generated for the other timer clock\"")
+    out.append("#endif")
+
+    for i, (accel, freq_max) in enumerate(PROFILES):
+        tab = table(accel, freq_max)
+        out.append("")
+        out.append("// %d steps/s^2, %d Hz" % (accel, freq_max))
+        out.append("static const uint32_t ramp%d[%d] =" % (i, len(tab)))
+        out.append("{")
+        for n in range(0, len(tab), 8):
+            out.append("  " + ", ".join(str(v) for v in tab[n:n + 8]) + ",")
+        out.append("};")
+
+    out.append("")
+    out.append("const struct RAMP_TABLE_t RAMP_tables[RAMP_TABLE_CNT] =")
+    out.append("{")
+    for i, (accel, freq_max) in enumerate(PROFILES):
+        out.append("  {%d, %d, %d, ramp%d}," % (accel, freq_max, len(table(accel, freq_max)), i))
+    out.append("};")
+    out.append("")
+
+    with open(OUT, "w") as f:
+        f.write("\n".join(out))
+
+    print("%s: %d tables, RAMP_TABLE_CNT must be %d" % (OUT, len(PROFILES), len(PROFILES)))
+
+
+if __name__ == "__main__":
+    main()